@@ -0,0 +1,571 @@
+/**
+ * @filename   clogbench.c
+ *   microbenchmarks of libclogger internals across 1..N threads.
+ *
+ *   stampid - ids of rtclock_ticktime() (per-thread blocks) against one
+ *             atomic add per id on a shared counter. ids are checked for
+ *             duplicates and order per thread.
+ *
+ *   ring    - 1..N writers and one reader passing {writer, seq} through
+ *             ringbufst, ringbuf and shmmbuf. reader checks seq of every
+ *             writer comes in order and none is lost. build 'make
+ *             clogbench_tsan' to run it under ThreadSanitizer.
+ *
+ * @author     Liang Zhang <350137278@qq.com>
+ * @version    0.0.1
+ * @create     2026-10-18 09:08:27
+ * @update     2026-10-18 09:08:27
+ */
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/uatomic.h>
+#include <common/rtclock.h>
+#include <common/ringbufst.h>
+#include <common/ringbuf.h>
+
+#ifdef __WINDOWS__
+  # include <common/shmmbuf-win.h>
+#else
+  # include <common/shmmbuf.h>
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __WINDOWS__
+    # include <common/win32/getoptw.h>
+
+    # if !defined(__MINGW__)
+        // link to libclogger.lib for MS Windows
+        #pragma comment(lib, "libclogger.lib")
+    # endif
+#else
+    // Linux: see Makefile
+    # include <getopt.h>
+#endif
+
+
+#define  APPNAME     "clogbench"
+#define  APPVER      "1.0.0"
+
+#define  CLOGBENCH_THREADS_MAX   256
+
+
+typedef struct
+{
+    pthread_barrier_t *start;
+    void *arg;
+    int64_t count;
+
+    /* time of first and last operation */
+    double begin, end;
+
+    /* ids taken by thread kept for checks */
+    int64_t *ids;
+} clogbench_thread_t;
+
+
+static uatomic_int64 sharednanos;
+
+
+static double clogbench_now (void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+
+/* ticktime as nanoseconds of its {sec.nsec} */
+static void * stampid_block_func (void *arg)
+{
+    clogbench_thread_t *thr = (clogbench_thread_t *) arg;
+    rtclock_handle rtc = (rtclock_handle) thr->arg;
+    struct timespec ts;
+    int64_t i;
+
+    pthread_barrier_wait(thr->start);
+    thr->begin = clogbench_now();
+
+    for (i = 0; i < thr->count; i++) {
+        rtclock_ticktime(rtc, &ts);
+        thr->ids[i] = (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    thr->end = clogbench_now();
+    return NULL;
+}
+
+
+/* one atomic add per id on counter shared by all threads */
+static void * stampid_shared_func (void *arg)
+{
+    clogbench_thread_t *thr = (clogbench_thread_t *) arg;
+    int64_t i;
+
+    pthread_barrier_wait(thr->start);
+    thr->begin = clogbench_now();
+
+    for (i = 0; i < thr->count; i++) {
+        thr->ids[i] = uatomic_int64_add(&sharednanos);
+    }
+
+    thr->end = clogbench_now();
+    return NULL;
+}
+
+
+static int compare_int64 (const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *) a, y = *(const int64_t *) b;
+    return (x < y)? -1 : (x > y? 1 : 0);
+}
+
+
+/* returns seconds taken by numthreads each taking count ids */
+static double stampid_run (void * (*func)(void *), void *arg, int numthreads, int64_t count, int64_t *idsbuf, int64_t *dups, int64_t *unordered)
+{
+    pthread_t threads[CLOGBENCH_THREADS_MAX];
+    clogbench_thread_t thrs[CLOGBENCH_THREADS_MAX];
+    pthread_barrier_t start;
+    double begin, end;
+    int64_t i, total = count * numthreads;
+    int k;
+
+    pthread_barrier_init(&start, NULL, (unsigned) numthreads + 1);
+
+    for (k = 0; k < numthreads; k++) {
+        thrs[k].start = &start;
+        thrs[k].arg = arg;
+        thrs[k].count = count;
+        thrs[k].ids = idsbuf + count * k;
+        pthread_create(&threads[k], NULL, func, &thrs[k]);
+    }
+
+    pthread_barrier_wait(&start);
+
+    for (k = 0; k < numthreads; k++) {
+        pthread_join(threads[k], NULL);
+    }
+
+    /* from first thread started to last one done */
+    begin = thrs[0].begin;
+    end = thrs[0].end;
+    for (k = 1; k < numthreads; k++) {
+        if (thrs[k].begin < begin) {
+            begin = thrs[k].begin;
+        }
+        if (thrs[k].end > end) {
+            end = thrs[k].end;
+        }
+    }
+
+    pthread_barrier_destroy(&start);
+
+    *unordered = 0;
+    for (k = 0; k < numthreads; k++) {
+        for (i = 1; i < count; i++) {
+            if (thrs[k].ids[i] <= thrs[k].ids[i - 1]) {
+                (*unordered)++;
+            }
+        }
+    }
+
+    qsort(idsbuf, (size_t) total, sizeof(int64_t), compare_int64);
+
+    *dups = 0;
+    for (i = 1; i < total; i++) {
+        if (idsbuf[i] == idsbuf[i - 1]) {
+            (*dups)++;
+        }
+    }
+
+    return (end - begin);
+}
+
+
+static int bench_stampid (int maxthreads, int64_t count)
+{
+    int numthreads;
+    int64_t *idsbuf = (int64_t *) mem_alloc_unset(sizeof(int64_t) * (size_t) count * (size_t) maxthreads);
+    rtclock_handle rtc = rtclock_init(RTCLOCK_FREQ_SEC);
+
+    fprintf(stdout, "stampid: %" PRId64 " ids per thread (Mids/s, duplicates, out of order per thread)\n", count);
+    fprintf(stdout, "%-8s %12s %8s %8s %12s\n", "THREADS", "BLOCK", "DUPS", "ORDER", "SHARED");
+
+    for (numthreads = 1; numthreads <= maxthreads; numthreads *= 2) {
+        int64_t dups, unordered, shareddups, sharedunordered;
+
+        double tblock = stampid_run(stampid_block_func, rtc, numthreads, count, idsbuf, &dups, &unordered);
+        double tshared = stampid_run(stampid_shared_func, NULL, numthreads, count, idsbuf, &shareddups, &sharedunordered);
+
+        fprintf(stdout, "%-8d %12.1f %8" PRId64 " %8" PRId64 " %12.1f\n", numthreads,
+            (double) count * numthreads / tblock / 1e6, dups, unordered,
+            (double) count * numthreads / tshared / 1e6);
+        fflush(stdout);
+    }
+
+    rtclock_uninit(rtc);
+    mem_free(idsbuf);
+    return 1;
+}
+
+
+/* message passed by ring writers */
+typedef struct
+{
+    int64_t writer;
+    int64_t seq;
+} ringbench_msg_t;
+
+
+typedef struct
+{
+    const char *name;
+
+    /* returns 1 if msg written, 0 to write again */
+    int (*write_func)(void *ring, const ringbench_msg_t *msg);
+
+    /* returns 1 if a msg read into msg, 0 if none */
+    int (*read_func)(void *ring, ringbench_msg_t *msg);
+} ringbench_ops_t;
+
+
+typedef struct
+{
+    clogbench_thread_t thr;
+    const ringbench_ops_t *ops;
+    int64_t writer;
+} ringbench_writer_t;
+
+
+typedef struct
+{
+    clogbench_thread_t thr;
+    const ringbench_ops_t *ops;
+    int numwriters;
+
+    /* next seq expected from each writer */
+    int64_t *nextseq;
+
+    int64_t errors;
+} ringbench_reader_t;
+
+
+static void ringbst_write_cb (char *chunk, size_t chunksz, void *arg)
+{
+    memcpy(chunk, arg, chunksz);
+}
+
+static int ringbst_read_cb (const ringbuf_entry_st *entry, void *arg)
+{
+    memcpy(arg, entry->chunk, sizeof(ringbench_msg_t));
+    return 1;
+}
+
+static int ringbst_write (void *ring, const ringbench_msg_t *msg)
+{
+    return ringbufst_write((ring_buffer_st *) ring, sizeof(*msg), ringbst_write_cb, (void *) msg);
+}
+
+static int ringbst_read (void *ring, ringbench_msg_t *msg)
+{
+    return (ringbufst_read_next((ring_buffer_st *) ring, ringbst_read_cb, msg) == 1);
+}
+
+
+/* ringbuf only passes pointers: {writer, seq} is packed into pointer itself */
+#define RINGBUF_MSG_SEQBITS   40
+
+static int ringb_write (void *ring, const ringbench_msg_t *msg)
+{
+    uintptr_t v = (uintptr_t) ((msg->writer << RINGBUF_MSG_SEQBITS) | msg->seq) + 1;
+    return ringbuf_push((ringbuf_t *) ring, (ringbuf_elt_t *) v);
+}
+
+static int ringb_read (void *ring, ringbench_msg_t *msg)
+{
+    ringbuf_elt_t *elt;
+
+    if (ringbuf_pop((ringbuf_t *) ring, &elt) == 1) {
+        int64_t v = (int64_t) ((uintptr_t) elt - 1);
+        msg->writer = v >> RINGBUF_MSG_SEQBITS;
+        msg->seq = v & ((1LL << RINGBUF_MSG_SEQBITS) - 1);
+        return 1;
+    }
+    return 0;
+}
+
+
+static int ringshm_read_cb (const shmmbuf_entry_t *entry, void *arg)
+{
+    memcpy(arg, entry->chunk, sizeof(ringbench_msg_t));
+    return SHMMBUF_READ_NEXT;
+}
+
+static int ringshm_write (void *ring, const ringbench_msg_t *msg)
+{
+    return (shmmap_buffer_write((shmmap_buffer_t *) ring, msg, sizeof(*msg)) == SHMMBUF_WRITE_SUCCESS);
+}
+
+static int ringshm_read (void *ring, ringbench_msg_t *msg)
+{
+    return (shmmap_buffer_read_next((shmmap_buffer_t *) ring, ringshm_read_cb, msg) == SHMMBUF_READ_NEXT);
+}
+
+
+static const ringbench_ops_t ringbench_ops[] = {
+    {"RINGBUFST", ringbst_write, ringbst_read},
+    {"RINGBUF", ringb_write, ringb_read},
+    {"SHMMBUF", ringshm_write, ringshm_read}
+};
+
+
+static void * ringbench_writer_func (void *arg)
+{
+    ringbench_writer_t *wrt = (ringbench_writer_t *) arg;
+    ringbench_msg_t msg;
+
+    msg.writer = wrt->writer;
+
+    pthread_barrier_wait(wrt->thr.start);
+    wrt->thr.begin = clogbench_now();
+
+    for (msg.seq = 0; msg.seq < wrt->thr.count; msg.seq++) {
+        while (! wrt->ops->write_func(wrt->thr.arg, &msg)) {
+            sched_yield();
+        }
+    }
+
+    wrt->thr.end = clogbench_now();
+    return NULL;
+}
+
+
+static void * ringbench_reader_func (void *arg)
+{
+    ringbench_reader_t *rdr = (ringbench_reader_t *) arg;
+    ringbench_msg_t msg;
+    int64_t total = rdr->thr.count * rdr->numwriters;
+
+    pthread_barrier_wait(rdr->thr.start);
+    rdr->thr.begin = clogbench_now();
+
+    while (total > 0) {
+        if (! rdr->ops->read_func(rdr->thr.arg, &msg)) {
+            sched_yield();
+            continue;
+        }
+
+        if (msg.writer < 0 || msg.writer >= rdr->numwriters || msg.seq != rdr->nextseq[msg.writer]) {
+            rdr->errors++;
+        } else {
+            rdr->nextseq[msg.writer]++;
+        }
+        total--;
+    }
+
+    rdr->thr.end = clogbench_now();
+    return NULL;
+}
+
+
+/* returns seconds taken to pass count msgs of each writer through ring */
+static double ringbench_run (const ringbench_ops_t *ops, void *ring, int numwriters, int64_t count, int64_t *errors)
+{
+    pthread_t threads[CLOGBENCH_THREADS_MAX + 1];
+    ringbench_writer_t wrts[CLOGBENCH_THREADS_MAX];
+    int64_t nextseq[CLOGBENCH_THREADS_MAX];
+    ringbench_reader_t rdr;
+    pthread_barrier_t start;
+    double begin, end;
+    int k;
+
+    pthread_barrier_init(&start, NULL, (unsigned) numwriters + 2);
+
+    bzero(&rdr, sizeof(rdr));
+    bzero(nextseq, sizeof(nextseq));
+
+    rdr.thr.start = &start;
+    rdr.thr.arg = ring;
+    rdr.thr.count = count;
+    rdr.ops = ops;
+    rdr.numwriters = numwriters;
+    rdr.nextseq = nextseq;
+    pthread_create(&threads[numwriters], NULL, ringbench_reader_func, &rdr);
+
+    for (k = 0; k < numwriters; k++) {
+        bzero(&wrts[k], sizeof(wrts[k]));
+
+        wrts[k].thr.start = &start;
+        wrts[k].thr.arg = ring;
+        wrts[k].thr.count = count;
+        wrts[k].ops = ops;
+        wrts[k].writer = k;
+        pthread_create(&threads[k], NULL, ringbench_writer_func, &wrts[k]);
+    }
+
+    pthread_barrier_wait(&start);
+
+    for (k = 0; k <= numwriters; k++) {
+        pthread_join(threads[k], NULL);
+    }
+
+    pthread_barrier_destroy(&start);
+
+    /* from first writer started to reader done */
+    begin = rdr.thr.begin;
+    end = rdr.thr.end;
+    for (k = 0; k < numwriters; k++) {
+        if (wrts[k].thr.begin < begin) {
+            begin = wrts[k].thr.begin;
+        }
+    }
+
+    *errors = rdr.errors;
+    for (k = 0; k < numwriters; k++) {
+        if (nextseq[k] != count) {
+            (*errors)++;
+        }
+    }
+
+    return (end - begin);
+}
+
+
+static int bench_ring (int maxthreads, int64_t count)
+{
+    int numwriters, i, ret = 1;
+    void *rings[3];
+    char shmname[64];
+    ub8token_t token = 20261018;
+
+    rings[0] = ringbufst_init(4096, (int) RINGBUFST_ALIGN_ENTRYSIZE(sizeof(ringbench_msg_t)));
+    rings[1] = ringbuf_init(4096);
+
+    snprintf(shmname, sizeof(shmname), "%s-%d", APPNAME, (int) getpid());
+    if (shmmap_buffer_create((shmmap_buffer_t **) &rings[2], shmname, SHMMBUF_FILEMODE_DEFAULT, 4096 * 32, &token, 0, 0) != SHMMBUF_CREATE_SUCCESS) {
+        fprintf(stderr, "%s: shmmap_buffer_create failed: %s\n", APPNAME, shmname);
+        ringbuf_uninit((ringbuf_t *) rings[1]);
+        ringbufst_uninit((ring_buffer_st *) rings[0]);
+        return 0;
+    }
+
+    fprintf(stdout, "ring: %" PRId64 " msgs per writer, one reader (Mmsgs/s, lost or out of order)\n", count);
+    fprintf(stdout, "%-8s", "WRITERS");
+    for (i = 0; i < 3; i++) {
+        fprintf(stdout, " %12s %6s", ringbench_ops[i].name, "ERR");
+    }
+    fprintf(stdout, "\n");
+
+    for (numwriters = 1; numwriters <= maxthreads; numwriters *= 2) {
+        fprintf(stdout, "%-8d", numwriters);
+
+        for (i = 0; i < 3; i++) {
+            int64_t errors;
+            double secs = ringbench_run(&ringbench_ops[i], rings[i], numwriters, count, &errors);
+
+            fprintf(stdout, " %12.1f %6" PRId64, (double) count * numwriters / secs / 1e6, errors);
+            if (errors) {
+                ret = 0;
+            }
+        }
+
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    shmmap_buffer_close((shmmap_buffer_t *) rings[2]);
+    shmmap_buffer_delete(shmname);
+    ringbuf_uninit((ringbuf_t *) rings[1]);
+    ringbufst_uninit((ring_buffer_st *) rings[0]);
+    return ret;
+}
+
+
+static void print_usage (void)
+{
+#if defined(__WINDOWS__) || defined(__CYGWIN__)
+    fprintf(stdout, "Usage: %s.exe [Options...]\n", APPNAME);
+#else
+    fprintf(stdout, "Usage: %s [Options...]\n", APPNAME);
+#endif
+
+    fprintf(stdout, "  %s measures internals of libclogger for 1, 2, 4 .. threads.\n", APPNAME);
+
+    fprintf(stdout, "Options:\n");
+    fprintf(stdout, "  -h, --help                  display help information.\n");
+    fprintf(stdout, "  -V, --version               show %s version.\n", APPNAME);
+    fprintf(stdout, "  -m, --mode=MODE             what to measure: stampid (default), ring.\n");
+    fprintf(stdout, "  -t, --threads=NUM           max number of threads ('64' default).\n");
+    fprintf(stdout, "  -n, --count=NUM             operations per thread ('200000' default).\n");
+
+    fflush(stdout);
+}
+
+
+int main (int argc, char *argv[])
+{
+    int opt, optindex, ret = 0;
+    int maxthreads = 64;
+    int64_t count = 200000;
+    const char *mode = "stampid";
+
+    const struct option lopts[] = {
+        {"help",           no_argument, 0, 'h'},
+        {"version",        no_argument, 0, 'V'},
+        {"mode",           required_argument, 0, 'm'},
+        {"threads",        required_argument, 0, 't'},
+        {"count",          required_argument, 0, 'n'},
+        {0, 0, 0, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "hVm:t:n:", lopts, &optindex)) != -1) {
+        switch (opt) {
+        case '?':
+            exit(EXIT_FAILURE);
+
+        case 'h':
+            print_usage();
+            exit(0);
+            break;
+
+        case 'V':
+        #ifdef NDEBUG
+            fprintf(stdout, "%s-%s, Build Release: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #else
+            fprintf(stdout, "%s-%s, Build Debug: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #endif
+            exit(0);
+            break;
+
+        case 'm':
+            mode = optarg;
+            break;
+
+        case 't':
+            maxthreads = atoi(optarg);
+            break;
+
+        case 'n':
+            count = (int64_t) atol(optarg);
+            break;
+        }
+    }
+
+    if (maxthreads < 1 || maxthreads > CLOGBENCH_THREADS_MAX || count < 1) {
+        fprintf(stderr, "%s: threads must be 1..%d and count above 0\n", APPNAME, CLOGBENCH_THREADS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    if (! strcmp(mode, "stampid")) {
+        ret = bench_stampid(maxthreads, count);
+    } else if (! strcmp(mode, "ring")) {
+        ret = bench_ring(maxthreads, count);
+    } else {
+        fprintf(stderr, "%s: bad mode: %s\n", APPNAME, mode);
+        exit(EXIT_FAILURE);
+    }
+
+    return (ret? 0 : EXIT_FAILURE);
+}
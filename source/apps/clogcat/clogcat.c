@@ -0,0 +1,250 @@
+/**
+ * @filename   clogcat.c
+ *   decode binary log files (appender = BINFILE) into DATED text.
+ *
+ * @author     Liang Zhang <350137278@qq.com>
+ * @version    0.0.1
+ * @create     2026-10-18 11:20:05
+ * @update     2026-10-18 11:20:05
+ */
+#include <clogger/loggerbin.h>
+
+#include <common/memapi.h>
+
+#ifdef __WINDOWS__
+    # include <common/win32/getoptw.h>
+
+    # if !defined(__MINGW__)
+        // link to libclogger.lib for MS Windows
+        #pragma comment(lib, "libclogger.lib")
+    # endif
+#else
+    // Linux: see Makefile
+    # include <getopt.h>
+#endif
+
+
+#define  APPNAME     "clogcat"
+#define  APPVER      "1.0.0"
+
+/* bytes read from file at once */
+#define  CLOGCAT_READSIZE   65536
+
+/* max bytes of one rendered line */
+#define  CLOGCAT_LINESIZE   262144
+
+
+typedef struct
+{
+    const char *filename;
+
+    /* bytes not yet decoded */
+    char *buf;
+    size_t bufcap;
+    size_t buflen;
+
+    char line[CLOGCAT_LINESIZE];
+
+    ub8 blocks;
+    ub8 badblocks;
+    ub8 records;
+} clogcat_ctx;
+
+
+static void print_usage (void)
+{
+#if defined(__WINDOWS__) || defined(__CYGWIN__)
+    fprintf(stdout, "Usage: %s.exe [Options...] [FILE...]\n", APPNAME);
+#else
+    fprintf(stdout, "Usage: %s [Options...] [FILE...]\n", APPNAME);
+#endif
+
+    fprintf(stdout, "  %s prints binary log files (appender = BINFILE) as DATED text.\n", APPNAME);
+    fprintf(stdout, "  reads standard input if no FILE or FILE is '-'.\n");
+
+    fprintf(stdout, "Options:\n");
+    fprintf(stdout, "  -h, --help                  display help information.\n");
+    fprintf(stdout, "  -V, --version               show %s version.\n", APPNAME);
+    fprintf(stdout, "  -s, --stats                 print blocks and records decoded to stderr.\n");
+
+    fflush(stdout);
+}
+
+
+static int print_record_cb (void *arg, const logger_dated_opts *opts, const logger_record *rec)
+{
+    clogcat_ctx *ctx = (clogcat_ctx *) arg;
+
+    size_t len = logger_format_dated(opts, rec, ctx->line, sizeof(ctx->line));
+
+    fwrite(ctx->line, 1, len, stdout);
+    ctx->records++;
+
+    return 1;
+}
+
+
+/* find next block magic after a bad block */
+static size_t resync_block (const char *buf, size_t len)
+{
+    size_t pos = 1;
+
+    while (pos + 4 <= len) {
+        if (buf[pos] == LOGGER_BIN_MAGIC[0] && !memcmp(buf + pos, LOGGER_BIN_MAGIC, 4)) {
+            return pos;
+        }
+        pos++;
+    }
+
+    /* keep tail which may be head of magic */
+    return (len > 3? len - 3 : 0);
+}
+
+
+/* decode all complete blocks in buffer. returns bytes consumed */
+static size_t decode_blocks (clogcat_ctx *ctx, int eof)
+{
+    size_t pos = 0;
+
+    while (pos < ctx->buflen) {
+        size_t blocklen = 0;
+
+        int ret = logger_bin_block_check(ctx->buf + pos, ctx->buflen - pos, &blocklen);
+
+        if (ret == 1) {
+            if (logger_bin_block_decode(ctx->buf + pos, blocklen, print_record_cb, ctx) == -1) {
+                fprintf(stderr, "%s: malformed block at offset %" PRIu64 " in %s\n", APPNAME, (ub8) pos, ctx->filename);
+                ctx->badblocks++;
+            } else {
+                ctx->blocks++;
+            }
+            pos += blocklen;
+        } else if (ret == 0) {
+            if (! eof) {
+                /* wait for more bytes */
+                break;
+            }
+
+            fprintf(stderr, "%s: truncated block (%" PRIu64 " bytes) at end of %s\n", APPNAME, (ub8)(ctx->buflen - pos), ctx->filename);
+            ctx->badblocks++;
+            pos = ctx->buflen;
+        } else {
+            fprintf(stderr, "%s: bad block skipped in %s\n", APPNAME, ctx->filename);
+            ctx->badblocks++;
+            pos += resync_block(ctx->buf + pos, ctx->buflen - pos);
+        }
+    }
+
+    return pos;
+}
+
+
+static int cat_file (clogcat_ctx *ctx, const char *filename)
+{
+    FILE *fp;
+    int eof = 0;
+
+    if (! strcmp(filename, "-")) {
+        fp = stdin;
+        ctx->filename = "(stdin)";
+    } else {
+        fp = fopen(filename, "rb");
+        ctx->filename = filename;
+    }
+
+    if (! fp) {
+        fprintf(stderr, "%s: cannot open file: %s\n", APPNAME, filename);
+        return 0;
+    }
+
+    ctx->buflen = 0;
+
+    while (! eof) {
+        size_t cb, consumed;
+
+        if (ctx->bufcap - ctx->buflen < CLOGCAT_READSIZE) {
+            ctx->bufcap = ctx->buflen + CLOGCAT_READSIZE * 4;
+            ctx->buf = (char *) mem_realloc(ctx->buf, ctx->bufcap);
+        }
+
+        cb = fread(ctx->buf + ctx->buflen, 1, ctx->bufcap - ctx->buflen, fp);
+        if (cb == 0) {
+            eof = 1;
+        }
+        ctx->buflen += cb;
+
+        consumed = decode_blocks(ctx, eof);
+        if (consumed) {
+            ctx->buflen -= consumed;
+            memmove(ctx->buf, ctx->buf + consumed, ctx->buflen);
+        }
+    }
+
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    fflush(stdout);
+    return 1;
+}
+
+
+int main (int argc, char *argv[])
+{
+    int opt, optindex, stats = 0, failed = 0;
+
+    clogcat_ctx *ctx;
+
+    const struct option lopts[] = {
+        {"help",           no_argument, 0, 'h'},
+        {"version",        no_argument, 0, 'V'},
+        {"stats",          no_argument, 0, 's'},
+        {0, 0, 0, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "hVs", lopts, &optindex)) != -1) {
+        switch (opt) {
+        case '?':
+            exit(EXIT_FAILURE);
+
+        case 'h':
+            print_usage();
+            exit(0);
+            break;
+
+        case 'V':
+        #ifdef NDEBUG
+            fprintf(stdout, "%s-%s, Build Release: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #else
+            fprintf(stdout, "%s-%s, Build Debug: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #endif
+            exit(0);
+            break;
+
+        case 's':
+            stats = 1;
+            break;
+        }
+    }
+
+    ctx = (clogcat_ctx *) mem_alloc_zero(1, sizeof(*ctx));
+
+    if (optind >= argc) {
+        failed += ! cat_file(ctx, "-");
+    } else {
+        while (optind < argc) {
+            failed += ! cat_file(ctx, argv[optind++]);
+        }
+    }
+
+    if (stats) {
+        fprintf(stderr, "%s: %" PRIu64 " blocks, %" PRIu64 " records, %" PRIu64 " bad blocks\n", APPNAME, ctx->blocks, ctx->records, ctx->badblocks);
+    }
+
+    failed += (ctx->badblocks? 1 : 0);
+
+    mem_free(ctx->buf);
+    mem_free(ctx);
+
+    return (failed? EXIT_FAILURE : 0);
+}
@@ -0,0 +1,357 @@
+/**
+ * @filename   cloggerctl.c
+ *   list loggers of running process, set levels and call sites of them with
+ *   expiry and read stats through control page of the process.
+ *
+ * @author     Liang Zhang <350137278@qq.com>
+ * @version    0.0.1
+ * @create     2026-10-18 13:40:22
+ * @update     2026-10-18 13:40:22
+ */
+#include <clogger/loggerctl.h>
+
+#include <common/memapi.h>
+#include <common/cstrbuf.h>
+
+#ifdef __WINDOWS__
+    # include <common/win32/getoptw.h>
+
+    # if !defined(__MINGW__)
+        // link to libclogger.lib for MS Windows
+        #pragma comment(lib, "libclogger.lib")
+    # endif
+#else
+    // Linux: see Makefile
+    # include <getopt.h>
+    # include <dirent.h>
+    # include <signal.h>
+#endif
+
+
+#define  APPNAME     "cloggerctl"
+#define  APPVER      "1.0.0"
+
+
+static const char *levelnames[] = {
+    "OFF", "", "", "", "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE", "ALL"
+};
+
+
+static void print_usage (void)
+{
+#if defined(__WINDOWS__) || defined(__CYGWIN__)
+    fprintf(stdout, "Usage: %s.exe [Options...]\n", APPNAME);
+#else
+    fprintf(stdout, "Usage: %s [Options...]\n", APPNAME);
+#endif
+
+    fprintf(stdout, "  %s controls loggers of running process through its control page.\n", APPNAME);
+    fprintf(stdout, "  lists processes having control page if no pid given (Linux).\n");
+
+    fprintf(stdout, "Options:\n");
+    fprintf(stdout, "  -h, --help                  display help information.\n");
+    fprintf(stdout, "  -V, --version               show %s version.\n", APPNAME);
+    fprintf(stdout, "  -p, --pid=PID               process to control. list its loggers and sites if no more options.\n");
+    fprintf(stdout, "  -i, --ident=IDENT           logger to set level for ('*' for all).\n");
+    fprintf(stdout, "  -l, --level=LEVEL           set level of logger: TRACE, DEBUG, INFO, WARN, ERROR, FATAL, OFF\n");
+    fprintf(stdout, "                               or 'none' to restore level of config.\n");
+    fprintf(stdout, "  -s, --site=FILE:LINE        call site to switch (source file basename and line).\n");
+    fprintf(stdout, "  -e, --enable=on|off|none    switch call site on (logged at any level), off or restore it.\n");
+    fprintf(stdout, "  -t, --expiry=SECONDS        level or site is restored after seconds (default 0: never).\n");
+
+    fflush(stdout);
+}
+
+
+static int parse_level (const char *name)
+{
+    int level;
+
+    if (! cstr_compare_len(name, (int) strlen(name), "none", 4, 1)) {
+        return 0;
+    }
+
+    for (level = CLOG_LEVEL_OFF; level <= CLOG_LEVEL_ALL; level++) {
+        if (*levelnames[level] && ! cstr_compare_len(name, (int) strlen(name), levelnames[level], (int) strlen(levelnames[level]), 1)) {
+            return LOGGERCTL_LEVEL_SET | level;
+        }
+    }
+
+    return -1;
+}
+
+
+static void format_expiry (int64_t expiry, int64_t now, char *buf, size_t bufsize)
+{
+    if (! expiry) {
+        snprintf(buf, bufsize, "-");
+    } else if (expiry > now) {
+        snprintf(buf, bufsize, "%" PRId64 "s", expiry - now);
+    } else {
+        snprintf(buf, bufsize, "expired");
+    }
+}
+
+
+static void list_page (const loggerctl_page *page)
+{
+    int i, numloggers = page->numloggers;
+    int64_t now = (int64_t) time(NULL);
+    char expiry[32];
+
+    fprintf(stdout, "pid %d: %d loggers, %d active sites\n", page->pid, numloggers, page->activesites);
+    fprintf(stdout, "%-4s %-24s %-6s %-8s %16s %12s %10s %8s\n", "ID", "IDENT", "LEVEL", "EXPIRY", "MESSAGES", "DROPPED", "RING(KiB)", "AGE");
+
+    for (i = 0; i < numloggers && i < LOGGERCTL_LOGGERS; i++) {
+        const loggerctl_logger *lg = &page->loggers[i];
+        int level = lg->level;
+        int64_t updated = lg->updated;
+
+        if (! lg->ident[0]) {
+            /* no logger of this id */
+            continue;
+        }
+
+        format_expiry(level? lg->expiry : 0, now, expiry, sizeof(expiry));
+
+        fprintf(stdout, "%-4d %-24s %-6s %-8s %16" PRId64 " %12" PRId64 " %10" PRId64 " %7" PRId64 "s\n",
+            lg->loggerid, lg->ident,
+            (level? levelnames[(level & 0xff) % 11] : "-"),
+            expiry,
+            (int64_t) lg->messages, (int64_t) lg->dropped,
+            (int64_t) lg->ringresident / 1024,
+            (updated? now - updated : (int64_t) -1));
+    }
+
+    if (page->activesites) {
+        fprintf(stdout, "\n%-40s %-6s %-8s\n", "SITE", "ENABLE", "EXPIRY");
+
+        for (i = 0; i < LOGGERCTL_SITES; i++) {
+            const loggerctl_site *site = &page->sites[i];
+            int flags = site->flags;
+
+            if ((flags & LOGGERCTL_SITE_USED) && (flags & (LOGGERCTL_SITE_ON | LOGGERCTL_SITE_OFF))) {
+                char sitename[80];
+
+                snprintf(sitename, sizeof(sitename), "%s:%d", site->file, site->lineno);
+                format_expiry(site->expiry, now, expiry, sizeof(expiry));
+
+                fprintf(stdout, "%-40s %-6s %-8s\n", sitename, ((flags & LOGGERCTL_SITE_ON)? "on" : "off"), expiry);
+            }
+        }
+    }
+
+    fflush(stdout);
+}
+
+
+static int list_processes (void)
+{
+#if defined(__WINDOWS__)
+    fprintf(stderr, "%s: pid must be given (-p PID)\n", APPNAME);
+    return 0;
+#else
+    DIR *dir;
+    struct dirent *ent;
+    int prefixlen = (int) strlen(LOGGERCTL_NAME_PREFIX);
+
+    dir = opendir("/dev/shm");
+    if (! dir) {
+        fprintf(stderr, "%s: cannot open /dev/shm: %s\n", APPNAME, strerror(errno));
+        return 0;
+    }
+
+    fprintf(stdout, "%-8s %-6s %s\n", "PID", "ALIVE", "LOGGERS");
+
+    while ((ent = readdir(dir)) != NULL) {
+        if (! strncmp(ent->d_name, LOGGERCTL_NAME_PREFIX, prefixlen)) {
+            int pid = atoi(ent->d_name + prefixlen);
+            int alive = (pid > 0 && (kill(pid, 0) == 0 || errno == EPERM));
+            int numloggers = -1;
+
+            loggerctl_hdl ctl = loggerctl_open(pid);
+            if (ctl) {
+                numloggers = loggerctl_get_page(ctl)->numloggers;
+                loggerctl_close(ctl);
+            }
+
+            fprintf(stdout, "%-8d %-6s %d\n", pid, (alive? "yes" : "no"), numloggers);
+        }
+    }
+
+    closedir(dir);
+    return 1;
+#endif
+}
+
+
+static int set_level (loggerctl_page *page, const char *ident, int levelword, int64_t expiry)
+{
+    int i, count = 0, numloggers = page->numloggers;
+
+    for (i = 0; i < numloggers && i < LOGGERCTL_LOGGERS; i++) {
+        loggerctl_logger *lg = &page->loggers[i];
+
+        if (! lg->ident[0]) {
+            continue;
+        }
+
+        if (! strcmp(ident, "*") || ! strcmp(ident, lg->ident)) {
+            /* expiry goes first: logthread reads it after level */
+            uatomic_int64_set(&lg->expiry, (levelword? expiry : 0));
+            uatomic_int_store_rel(&lg->level, levelword);
+            count++;
+        }
+    }
+
+    if (! count) {
+        fprintf(stderr, "%s: logger not found: %s\n", APPNAME, ident);
+    }
+    return count;
+}
+
+
+static int set_site (loggerctl_page *page, const char *site, const char *enable, int64_t expiry)
+{
+    int ret, onoff, lineno;
+    char file[LOGGERCTL_FILE_MAX + 1];
+    const char *colon = strrchr(site, ':');
+
+    if (! colon || colon == site || colon - site > LOGGERCTL_FILE_MAX || (lineno = atoi(colon + 1)) <= 0) {
+        fprintf(stderr, "%s: bad site (FILE:LINE): %s\n", APPNAME, site);
+        return 0;
+    }
+
+    memcpy(file, site, colon - site);
+    file[colon - site] = '\0';
+
+    if (! strcmp(enable, "on")) {
+        onoff = LOGGERCTL_SITE_ON;
+    } else if (! strcmp(enable, "off")) {
+        onoff = LOGGERCTL_SITE_OFF;
+    } else if (! strcmp(enable, "none")) {
+        onoff = 0;
+    } else {
+        fprintf(stderr, "%s: bad enable (on, off, none): %s\n", APPNAME, enable);
+        return 0;
+    }
+
+    ret = loggerctl_set_site(page, file, lineno, onoff, expiry);
+    if (ret == -1) {
+        fprintf(stderr, "%s: sites table is full\n", APPNAME);
+        return 0;
+    }
+    return 1;
+}
+
+
+int main (int argc, char *argv[])
+{
+    int opt, optindex, pid = 0, ret = 1;
+    int levelword = -1;
+    int64_t expiry = 0;
+
+    const char *ident = NULL;
+    const char *site = NULL;
+    const char *enable = NULL;
+
+    loggerctl_hdl ctl;
+
+    const struct option lopts[] = {
+        {"help",           no_argument, 0, 'h'},
+        {"version",        no_argument, 0, 'V'},
+        {"pid",            required_argument, 0, 'p'},
+        {"ident",          required_argument, 0, 'i'},
+        {"level",          required_argument, 0, 'l'},
+        {"site",           required_argument, 0, 's'},
+        {"enable",         required_argument, 0, 'e'},
+        {"expiry",         required_argument, 0, 't'},
+        {0, 0, 0, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "hVp:i:l:s:e:t:", lopts, &optindex)) != -1) {
+        switch (opt) {
+        case '?':
+            exit(EXIT_FAILURE);
+
+        case 'h':
+            print_usage();
+            exit(0);
+            break;
+
+        case 'V':
+        #ifdef NDEBUG
+            fprintf(stdout, "%s-%s, Build Release: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #else
+            fprintf(stdout, "%s-%s, Build Debug: %s %s\n\n", APPNAME, APPVER, __DATE__, __TIME__);
+        #endif
+            exit(0);
+            break;
+
+        case 'p':
+            pid = atoi(optarg);
+            break;
+
+        case 'i':
+            ident = optarg;
+            break;
+
+        case 'l':
+            levelword = parse_level(optarg);
+            if (levelword == -1) {
+                fprintf(stderr, "%s: bad level: %s\n", APPNAME, optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+
+        case 's':
+            site = optarg;
+            break;
+
+        case 'e':
+            enable = optarg;
+            break;
+
+        case 't':
+            expiry = (int64_t) atol(optarg);
+            break;
+        }
+    }
+
+    if (! pid) {
+        return (list_processes()? 0 : EXIT_FAILURE);
+    }
+
+    if ((ident && levelword == -1) || (! ident && levelword != -1) || (site && ! enable) || (! site && enable)) {
+        fprintf(stderr, "%s: -i and -l, -s and -e must be given together\n", APPNAME);
+        exit(EXIT_FAILURE);
+    }
+
+    if (expiry > 0) {
+        expiry += (int64_t) time(NULL);
+    } else {
+        expiry = 0;
+    }
+
+    ctl = loggerctl_open(pid);
+    if (! ctl) {
+        fprintf(stderr, "%s: no control page of process (or owned by other user): %d\n", APPNAME, pid);
+        exit(EXIT_FAILURE);
+    }
+
+    if (ident) {
+        ret = set_level(loggerctl_get_page(ctl), ident, levelword, expiry);
+    }
+
+    if (site && ret) {
+        ret = set_site(loggerctl_get_page(ctl), site, enable, expiry);
+    }
+
+    if (! ident && ! site) {
+        list_page(loggerctl_get_page(ctl));
+    }
+
+    loggerctl_close(ctl);
+
+    return (ret? 0 : EXIT_FAILURE);
+}
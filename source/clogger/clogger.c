@@ -33,6 +33,22 @@
 */
 #include "clogger_api.h"
 #include "loggermgr_i.h"
+#include "loggerkv.h"
+#include "loggerfmt.h"
+#include "loggerbin.h"
+#include "loggerctl.h"
+#include "loggerrate.h"
+#include "loggermdc.h"
+#include "loggerbt.h"
+#include "loggerfr.h"
+#include "loggersink.h"
+#include "loggerbatch.h"
+#include "loggerqs.h"
+
+#include <common/crc32c.h>
+
+#include <common/jsonesc.h>
+#include <common/varint.h>
 
 static const char THIS_FILE[] = "clogger.c";
 
@@ -44,14 +60,48 @@ static const char THIS_FILE[] = "clogger.c";
 
 static const char clog_endcolor[] = "\033[0m";
 
-static const char *clog_week_strs[]  = { 0, "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
-
-static const char *clog_month_strs[]  = { 0, "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
-
 /* refer to: clog_level_t */
 static const char *clog_level_strs[] = {"OFF", 0, 0, 0, "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE", "ALL", 0};
 static const int   clog_level_lens[] = {    3, 0, 0, 0,       5,       5,      4,      4,       5,       5,    3,  0};
 
+/* bytes of keys, quotes, commas and numbers in one json line */
+#define CLOG_JSON_LINE_FIXSIZE  160
+
+/* "#18446744073709551615 " or "\"seq\":18446744073709551615," */
+#define CLOG_SEQFMT_SIZE        28
+
+/* kind of message in ringbuffer */
+#define CLOG_MSGKIND_TEXT   0
+#define CLOG_MSGKIND_KV     1
+#define CLOG_MSGKIND_BIN    2
+#define CLOG_MSGKIND_SPILL  3
+
+/* spilled messages not yet logged take at most times of maxspillsize */
+#define CLOG_SPILL_INFLIGHT   4
+
+/* caller waiting for room: pauses, yields, then parks in slices of usec */
+#define CLOG_WAIT_SPINS     64
+#define CLOG_WAIT_YIELDS    8
+#define CLOG_WAIT_PARKUS    100000
+
+/* parked callers are woken when 1/8 of queue is read by logthread */
+#define CLOG_WAIT_WATERMARKS  8
+
+/* messages left at destroy are read for 5 seconds at most */
+#define CLOG_SHUTDOWN_DRAINUS  5000000
+
+/* btkey of loggers created */
+static uatomic_int logger_bt_keys = 0;
+
+/* loggers with flight recorder, flushed on fatal signals. logger takes
+ *  first free slot from (loggerid % 256) on: ids of reloaded loggers or of
+ *  other managers may be same.
+ */
+#define CLOG_FLIGHT_LOGGERS_MAX  256
+
+static uatomic_ptr clog_flight_loggers[CLOG_FLIGHT_LOGGERS_MAX];
+static uatomic_int clog_flight_count = 0;
+
 
 #if defined(__WINDOWS__)
     // same as: <unistd.h>
@@ -78,8 +128,22 @@ typedef struct
     cstrbuf ident;
     clog_level_t level;
 
+    /* level which message is routed by (level above is 0 for PLAIN) */
+    clog_level_t msglevel;
+
     size_t fmtlen;
-    dateformat_buf dateminfmt, datetimefmt, stampidfmt;
+    dateformat_buf datetimefmt, stampidfmt;
+
+    /* nanoseconds since epoch and raw stamp id (rawtimestamp) */
+    ub8 timestamp;
+    ub8 stampid;
+
+    /* priority lane used: sequence taken by lane message, or the last one
+     *  taken before other message. 0 for none */
+    ub8 seq;
+
+    /* put into priority lane whatever level is (backtrace of ERROR) */
+    int urgent;
 
     size_t startclrlen;
     char startclrfmt[32];
@@ -94,23 +158,83 @@ typedef struct
     char threadnofmt[32];
 #endif
 
+    /* diagnostic context of thread rendered once (thread-local) */
+    int mdclen;
+    const char *mdc;
+
+    /* CLOG_MSGKIND_TEXT or CLOG_MSGKIND_KV */
+    int kind;
+
+    /* JSON layout: call site and escaped length of message */
+    const char *filename;
+    int filenamelen;
+    const char *funcname;
+    int funcnamelen;
+    int lineno;
+    size_t msgesclen;
+
     size_t msglen;
     char *message;
+
+    /* CLOG_MSGKIND_SPILL: record put into ring instead of message */
+    const void *spill;
+
+    /* oversize text not made yet (message is NULL): formatted by
+     *  write_message_cb into its place in spill chunk. msglen holds room
+     *  for textlen and tag of suppressed */
+    const char *spillformat;
+    va_list *spillargs;
+    size_t spilltextlen;
+    int64_t spillsuppressed;
 } clog_message_fmt;
 
 
 typedef struct
 {
-    size_t offsetcb;
-    size_t dateminfmtlen;
-    char dateminfmt[ROF_DATEMINUTE_SIZE];
+    ub4 offsetcb;
+
+    /* KV: offset of encoded fields in message (after header text) */
+    ub4 kvoffset;
+
+    /* rolling time of file is derived from timestamp by logthread */
+    ub8 timestamp;
+
+    /* rawtimestamp: stamp id and offset in message where datetime is put */
+    ub8 stampid;
+    ub2 timeoffset;
+
+    /* BINARY: order of record (LOGGER_DATED_SEQUENCE) */
+    ub8 seq;
+
+    /* text after datetime and stampid compared for duplicates */
+    ub2 bodyoffset;
+
+    ub1 kind;
+    ub1 autowrapline;
+
+    /* level of message for thresholds of appenders and routes */
+    ub1 level;
+
     char message[0];
 } clog_message_hdr;
 
 
+/**
+ * message of CLOG_MSGKIND_SPILL: chunk of oversize message made on heap by
+ *  caller and freed by logthread. epoch tells chunks of last process found
+ *  in flight recorder.
+ */
+typedef struct
+{
+    ub8 epoch;
+    size_t chunksize;
+    clog_message_hdr *chunk;
+} clog_message_spill;
+
+
 static size_t clog_message_fmt_chunksize (const clog_message_fmt *msg, size_t maxmsgsize)
 {
-    size_t chunksize = ROF_DATEMINUTE_SIZE +
+    size_t chunksize = sizeof(clog_message_hdr) +
                 cstrbufGetLen(msg->ident) +
                 clog_level_lens[msg->level] +
                 msg->fmtlen +
@@ -119,7 +243,9 @@ static size_t clog_message_fmt_chunksize (const clog_message_fmt *msg, size_t ma
 #ifndef CLOGGER_NO_THREADNO
                 msg->threadnofmtlen +
 #endif
+                msg->mdclen +
                 msg->msglen +
+                (msg->seq? CLOG_SEQFMT_SIZE : 0) +
                 32;
 
     chunksize = memapi_align_psize(chunksize);
@@ -132,7 +258,47 @@ static size_t clog_message_fmt_chunksize (const clog_message_fmt *msg, size_t ma
 }
 
 
-typedef struct _clog_logger_t
+static size_t clog_message_json_chunksize (const clog_message_fmt *msg, size_t maxmsgsize)
+{
+    size_t chunksize = sizeof(clog_message_hdr) + CLOG_JSON_LINE_FIXSIZE +
+                msg->fmtlen +
+                clog_level_lens[msg->level] +
+#ifndef CLOGGER_NO_THREADNO
+                msg->threadnofmtlen +
+#endif
+                msg->msgesclen;
+
+    if (msg->mdclen) {
+        chunksize += sizeof(",\"mdc\":") + msg->mdclen;
+    }
+
+    if (msg->seq) {
+        chunksize += CLOG_SEQFMT_SIZE;
+    }
+
+    if (msg->ident) {
+        chunksize += json_escape_length(msg->ident->str, msg->ident->len);
+    }
+    if (msg->filename) {
+        chunksize += json_escape_length(msg->filename, msg->filenamelen);
+        chunksize += json_escape_length(msg->funcname, msg->funcnamelen);
+    }
+
+    chunksize = memapi_align_psize(chunksize);
+
+    if (chunksize >= maxmsgsize) {
+        return (-1);
+    }
+
+    return chunksize;
+}
+
+
+/**
+ * settings read by callers and logthread without lock. a published block is
+ *  never changed: logger_manager_reload and clog_set_levelcolor publish a copy.
+ */
+typedef struct _clog_logger_settings_t
 {
     struct {
         unsigned loctime        :1;
@@ -161,49 +327,220 @@ typedef struct _clog_logger_t
 #endif
     } bf;
 
+    clog_level_t level;
+
+    /* see: clog_level_t */
+    clog_style_t levelstyles[12];
+    clog_color_t levelcolors[12];
+
+    clog_dateformat_t dateformat;
+
+    clog_kvformat_t kvformat;
+
+    /* rolling policy applied to logfile by logthread */
+    rollingtime_t rollingtime;
+    ub8 maxfilesize;
+    ub4 maxfilecount;
+    int rollingappend;
+
+    /* rate limit and sampling of every call site */
+    logger_rate_policy ratepolicy;
+
+    /* seconds in which consecutive duplicates are coalesced, 0 for none */
+    int coalesce;
+
+    /* highest level written by every appender */
+    clog_level_t stdoutlevel;
+    clog_level_t sysloglevel;
+    clog_level_t rofilelevel;
+    clog_level_t shmloglevel;
+
+    /* levels routed to own files are not written to logfile */
+    int routeonly;
+
+    /* records up to backtracelevel not logged are kept for next ERROR */
+    int backtrace;
+    int backtracems;
+    clog_level_t backtracelevel;
+
+    /* replaced blocks are freed by logthread after callers reading them left */
+    struct _clog_logger_settings_t *retired;
+} clog_logger_settings;
+
+
+typedef struct _clog_logger_t
+{
+    /* must be first: read by clog_logger_level_gate */
+    clog_logger_head head;
+
+    /* clog_logger_settings: read without lock */
+    uatomic_ptr settings;
+
+    /* serializes writers of settings and gatelevel */
+    pthread_mutex_t settingslock;
+
+    /* logthread only: blocks waiting for callers to leave and qs epoch */
+    clog_logger_settings *reclaimlist;
+    int64_t reclaimepoch;
+
+    /* logthread only: level and sites of cloggerctl gate was updated by */
+    int ctlstate;
+    int ctlsitesgen;
+
+    /* slot in clog_flight_loggers, -1 if not taken */
+    int flightslot;
+
+    /* holds lock of flight recorder file (bf.flightrecorder) */
+    int flightfd;
+
+    /* resources opened by create which settings can not change */
+    struct {
+        unsigned appenderrofile :1;
+        unsigned appendershmlog :1;
+        unsigned appenderbinfile:1;
+        unsigned rawtimestamp   :1;
+        unsigned flightrecorder :1;
+    } bf;
+
+    /* openlog called by create or reload */
+    int syslogopen;
+
     /* logger thread log messages */
     pthread_t logthread;
     pthread_mutex_t shutdownlock;
 
+    /* set by destroy: messages of callers are dropped since */
+    uatomic_int shutdown;
+
     /* logged messages counter */
     uatomic_int64 logmessages;
     uatomic_int64 logrounds;
 
+    /* messages not put into ringbuffer */
+    uatomic_int64 dropped;
+
+    /* flushes requested by callers and acknowledged by logthread */
+    uatomic_int64 flushseq;
+    int64_t flushack;
+    pthread_mutex_t flushlock;
+    pthread_cond_t flushcond;
+
+    /* callers waiting for room in ringbuffer */
+    uatomic_int parked;
+    pthread_mutex_t parklock;
+    pthread_cond_t parkcond;
+
+    /* level word and stats in control page, NULL if no control page */
+    loggerctl_logger *ctl;
+    loggerctl_page *ctlpage;
+
+    /* state of call sites limited, created when first needed */
+    uatomic_ptr rates;
+
     /* semaphore for ringbuffer */
     unsema_t sema;
 
     /* MT-safety ring buffer for queued logging messages */
     ring_buffer_st *ringbuffer;
 
-    /* a memory pool for formating message */
+    /* ring for WARN and above read ahead of ringbuffer, NULL if not used */
+    ring_buffer_st *priorityring;
+    int priorityweight;
+
+    /* last sequence taken by message put into priorityring */
+    uatomic_int64 msgseq;
+
+    /* seconds without messages after which pages of rings are given back */
+    int ringreclaim;
+
+    /* pattern of file which ringbuffer is mapped onto (bf.flightrecorder) */
+    cstrbuf flightrecorder;
+
+    /* a memory pool for formating message, buffers made when first needed */
     ringbuf_t *mempool;
+    uatomic_int mempoolelts;
+    int maxconcurrents;
 
     /* configuration */
-    clog_level_t level;
+    clog_layout_t layout;
 
-    /* see: clog_level_t */
-    clog_style_t levelstyles[12];
-    clog_color_t levelcolors[12];
+    /* where timestamp of message is read from */
+    rtclock_source_t clocksource;
 
-    clog_layout_t layout;
+    /* logthread only: settings applied to datedopts and logfile */
+    const clog_logger_settings *applied;
 
-    clog_dateformat_t dateformat;
+    /* logthread only: buffer for rendering KV message */
+    size_t renderbufsz;
+    char *renderbuf;
+
+    /* logthread only: last message and run of its duplicates not logged */
+    struct {
+        ub4 hash;
+        ub4 len;
+        size_t bufsz;
+        char *buf;
+
+        /* timestamp of last message which duplicates are counted since */
+        ub8 startts;
+        clog_level_t level;
+
+        ub8 count;
+        ub8 firstts;
+        ub8 lastts;
+    } dup;
+
+    /* logthread only: localtime of last second and rolling time of last minute */
+    sb8 calsecond;
+    struct tm calendar;
+    sb8 calminute;
+    dateformat_buf dateminfmt;
+
+    /* BINARY layout: options for DATED line and blocks writer for BINFILE */
+    logger_dated_opts datedopts;
+    logger_bin_writer binwriter;
 
     /* rolling logging file */
     rollingfile_t logfile;
 
+    /* rolling files which levels are routed to (ROFILE), opened by create */
+    int numroutes;
+    ub4 routedlevels;
+    struct {
+        ub4 levels;
+        cstrbuf nameprefix;
+        rollingfile_t logfile;
+    } routes[LOGGER_CONF_ROUTES_MAX];
+
     /* shared memory map  for logging */
     shmmaplog_hdl shmlog;
 
+    /* own queue and worker of STDOUT and SYSLOG (appenderqueue), or NULL */
+    logger_sink stdoutsink;
+    logger_sink syslogsink;
+
     /* ident or category for loging */
     cstrbuf ident;
 
     /* unique id for logger */
     int loggerid;
 
+    /* owner of records in backtrace ring of threads, never reused */
+    ub4 btkey;
+
     /* readonly max size for message */
     int maxmsgsize;
 
+    /* readonly max size for message spilled out of ring (0 for none) */
+    size_t maxspillsize;
+    ub8 spillepoch;
+
+    /* bytes of spilled messages not yet logged */
+    uatomic_int64 spillbytes;
+
+    /* readonly length of ringbuffer */
+    int queuelength;
+
     /* global shared real time clock */
     rtclock_handle rtc;
 
@@ -225,6 +562,254 @@ static rollingfile_t * clog_logger_get_rollingfile(clog_logger logger)
 }
 
 
+/* buffer for formating message: pool grows up to maxconcurrents buffers */
+static ringbuf_elt_t * clog_logger_msgbuf_pop (clog_logger logger)
+{
+    ringbuf_elt_t *msgbuf;
+
+    while (ringbuf_pop(logger->mempool, &msgbuf) != 1) {
+        if (uatomic_int_add(&logger->mempoolelts) <= logger->maxconcurrents) {
+            ringbuf_elt_new(logger->maxmsgsize, mem_free, &msgbuf);
+            break;
+        }
+        uatomic_int_sub(&logger->mempoolelts);
+    }
+
+    return msgbuf;
+}
+
+
+static const clog_logger_settings * clog_logger_settings_get (clog_logger logger)
+{
+    return (const clog_logger_settings *) uatomic_ptr_load_acq(&logger->settings);
+}
+
+
+/* highest level which can pass clog_logger_level_pass now */
+static void clog_logger_update_gate (clog_logger logger)
+{
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+    int gatelevel = st->level;
+
+    if (logger->ctl) {
+        int ctllevel = logger->ctl->level;
+        if (ctllevel) {
+            gatelevel = (ctllevel & 0xff);
+        }
+    }
+
+    if (st->backtrace && gatelevel < st->backtracelevel) {
+        /* records below level are captured for backtrace */
+        gatelevel = st->backtracelevel;
+    }
+
+    logger->head.gatelevel = gatelevel;
+}
+
+
+/* settingslock held or logger not started */
+static void clog_logger_settings_publish (clog_logger logger, clog_logger_settings *st)
+{
+    st->retired = (clog_logger_settings *) uatomic_ptr_load_acq(&logger->settings);
+    uatomic_ptr_store_rel(&logger->settings, st);
+
+    clog_logger_update_gate(logger);
+}
+
+
+/**
+ * callers read settings got after enter until leave. only the record of
+ *  calling thread is written (see loggerqs.h).
+ */
+static void clog_logger_settings_enter (clog_logger logger)
+{
+    logger_qs_enter();
+}
+
+
+static void clog_logger_settings_leave (clog_logger logger)
+{
+    logger_qs_leave();
+}
+
+
+/**
+ * logthread only: blocks older than applied are freed when threads entered
+ *  before they were taken off are gone. never blocks: checked again in next
+ *  loop.
+ */
+static void clog_logger_settings_reclaim (clog_logger logger)
+{
+    if (! logger->reclaimlist) {
+        clog_logger_settings *applied = (clog_logger_settings *) logger->applied;
+
+        if (! applied->retired) {
+            return;
+        }
+
+        /* retired of applied block is written only here after published */
+        logger->reclaimlist = applied->retired;
+        applied->retired = NULL;
+        logger->reclaimepoch = logger_qs_advance();
+    }
+
+    if (! logger_qs_passed(logger->reclaimepoch)) {
+        return;
+    }
+
+    while (logger->reclaimlist) {
+        clog_logger_settings *st = logger->reclaimlist;
+        logger->reclaimlist = st->retired;
+        mem_free(st);
+    }
+}
+
+
+/**
+ * logthread only: controls set by cloggerctl go to gatelevel as publisher.
+ *  sitegen (never 0 while sites are switched) makes call sites look up
+ *  their flags again.
+ */
+static void clog_logger_follow_ctl (clog_logger logger)
+{
+    int ctlstate = (logger->ctl->level & 0xff);
+    int sitesgen = uatomic_int_load_acq(&logger->ctlpage->sitesgen);
+
+    if (ctlstate != logger->ctlstate) {
+        pthread_mutex_lock(&logger->settingslock);
+        logger->ctlstate = ctlstate;
+        clog_logger_update_gate(logger);
+        pthread_mutex_unlock(&logger->settingslock);
+    }
+
+    if (sitesgen != logger->ctlsitesgen) {
+        logger->ctlsitesgen = sitesgen;
+
+        if (uatomic_int_load_acq(&logger->ctlpage->activesites)) {
+            /* fits in sitegate of call site with on bit */
+            logger->head.sitegen = (sitesgen & 0x3fffffff) + 1;
+        } else {
+            logger->head.sitegen = 0;
+        }
+    }
+}
+
+
+static clog_logger_settings * clog_logger_settings_dup (const clog_logger_settings *from)
+{
+    clog_logger_settings *st = (clog_logger_settings *) mem_alloc_unset(sizeof(*st));
+    memcpy(st, from, sizeof(*st));
+    st->retired = NULL;
+    return st;
+}
+
+
+/**
+ * level of settings unless it is overridden by cloggerctl. call site switched
+ *  on or off by cloggerctl wins over level.
+ */
+static int clog_logger_level_pass (clog_logger logger, const clog_logger_settings *st, clog_level_t level, const char *filename, int lineno)
+{
+    int maxlevel = st->level;
+
+    if (logger->ctl) {
+        int ctllevel = logger->ctl->level;
+        if (ctllevel) {
+            maxlevel = (ctllevel & 0xff);
+        }
+
+        if (filename && logger->ctlpage->activesites) {
+            int flags = loggerctl_site_flags(logger->ctlpage, filename, lineno);
+            if (flags & LOGGERCTL_SITE_ON) {
+                return 1;
+            }
+            if (flags & LOGGERCTL_SITE_OFF) {
+                return 0;
+            }
+        }
+    }
+
+    return (level <= maxlevel);
+}
+
+
+static logger_rate_hdl clog_logger_get_rates (clog_logger logger)
+{
+    logger_rate_hdl rates = (logger_rate_hdl) uatomic_ptr_load_acq(&logger->rates);
+
+    if (! rates) {
+        logger_rate_hdl newrates = logger_rate_create();
+        if (! newrates) {
+            return NULL;
+        }
+
+        rates = (logger_rate_hdl) uatomic_ptr_comp_exch(&logger->rates, NULL, newrates);
+        if (rates) {
+            /* created by other thread */
+            logger_rate_free(newrates);
+        } else {
+            rates = newrates;
+        }
+    }
+
+    return rates;
+}
+
+
+/**
+ * rate limit and sampling of call site before message is formatted. FATAL
+ *  is never limited. suppressed is set to lines not logged since last one.
+ */
+static int clog_logger_rate_pass (clog_logger logger, const clog_logger_settings *st, clog_level_t level, const char *filename, int lineno, int64_t *suppressed)
+{
+    struct timespec now;
+    logger_rate_hdl rates = (logger_rate_hdl) logger->rates;
+
+    *suppressed = 0;
+
+    if (level <= CLOG_LEVEL_FATAL || ! filename) {
+        return 1;
+    }
+
+    if (! logger_rate_policy_isset(&st->ratepolicy)) {
+        if (! logger_rate_site_policies(rates)) {
+            /* nothing limited */
+            return 1;
+        }
+    } else if (! rates) {
+        rates = clog_logger_get_rates(logger);
+        if (! rates) {
+            return 1;
+        }
+    }
+
+    rtclock_gettime(logger->rtc, RTCLOCK_SOURCE_COARSE, &now);
+
+    return logger_rate_pass(rates, &st->ratepolicy, filename, lineno, &now, suppressed);
+}
+
+
+/* " [suppressed 9223372036854775807]" */
+#define CLOG_SUPPRESSED_SIZE    40
+
+/* put count of suppressed lines at end of message (overwrites tail if full) */
+static int clog_message_add_suppressed (char *msgbuf, int msglen, int bufsize, int64_t suppressed)
+{
+    char tag[CLOG_SUPPRESSED_SIZE];
+    int taglen = snprintf(tag, sizeof(tag), " [suppressed %" PRId64 "]", suppressed);
+
+    if (taglen >= bufsize) {
+        return msglen;
+    }
+    if (msglen + taglen >= bufsize) {
+        msglen = bufsize - taglen - 1;
+    }
+
+    memcpy(msgbuf + msglen, tag, taglen + 1);
+    return msglen + taglen;
+}
+
+
 static cstrbuf clog_replace_string (const char *source, int pairs, ...)
 {
     cstrbuf sb = cstrbufNew(0, source, -1);
@@ -250,135 +835,136 @@ static cstrbuf clog_replace_string (const char *source, int pairs, ...)
 }
 
 
-static size_t clog_format_datetime (clog_logger logger, dateformat_buf *dateminfmt, dateformat_buf *datetimefmt, dateformat_buf *stampidfmt)
+static size_t clog_format_dateminfmt (clog_logger logger, const struct tm *tmloc, dateformat_buf *dateminfmt)
 {
-    size_t totalfmtlen = 0;
-    struct timespec now = {0};
-    struct tm loc = {0};
-    int timezone = 0;
-    int datlight = 0;
-    const char *timezonefmt = TIMEZONE_FORMAT_UTC;
-    if (logger->bf.loctime) {
-        timezone = rtclock_timezone(logger->rtc, &timezonefmt);
-        datlight = rtclock_daylight(logger->rtc);
-    }
-    rtclock_localtime(logger->rtc, timezone, datlight, &loc, &now);
-
     /* dateminfmt must be: "20191223-1157" */
     switch(logger->logfile.timepolicy) {
     case ROLLING_TM_MIN_1:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d-%02d%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday, loc.tm_hour, loc.tm_min);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday, tmloc->tm_hour, tmloc->tm_min);
         break;
     case ROLLING_TM_MIN_5:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d-%02d%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday, loc.tm_hour, (loc.tm_min/5) * 5);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday, tmloc->tm_hour, (tmloc->tm_min/5) * 5);
         break;
     case ROLLING_TM_MIN_10:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d-%02d%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday, loc.tm_hour, (loc.tm_min/10) * 10);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday, tmloc->tm_hour, (tmloc->tm_min/10) * 10);
         break;
     case ROLLING_TM_MIN_30:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d-%02d%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday, loc.tm_hour, (loc.tm_min/30) * 30);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday, tmloc->tm_hour, (tmloc->tm_min/30) * 30);
         break;
     case ROLLING_TM_HOUR:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d-%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday, loc.tm_hour);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday, tmloc->tm_hour);
         break;
     case ROLLING_TM_DAY:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d%02d",
-                                loc.tm_year, loc.tm_mon, loc.tm_mday);
+                                tmloc->tm_year, tmloc->tm_mon, tmloc->tm_mday);
         break;
     case ROLLING_TM_MON:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d%02d",
-                                loc.tm_year, loc.tm_mon);
+                                tmloc->tm_year, tmloc->tm_mon);
         break;
     case ROLLING_TM_YEAR:
         dateminfmt->fmtlen = snprintf(dateminfmt->fmtbuf, sizeof(dateminfmt->fmtbuf), "%04d",
-                                loc.tm_year);
+                                tmloc->tm_year);
         break;
     default:
         dateminfmt->fmtlen = 0;
         dateminfmt->fmtbuf[0] = 0;
         break;
     }
-    totalfmtlen += dateminfmt->fmtlen;
 
-    if (datetimefmt) {
-        if (logger->dateformat == CLOG_DATEFMT_RFC_3339 || logger->dateformat == CLOG_DATEFMT_ISO_8601) {
-            /* "2019-12-26 10:13:41+08:00", "2019-12-26T10:14:32+08:00" */
-            char T = (logger->dateformat == CLOG_DATEFMT_ISO_8601?  'T' : 32);
+    return dateminfmt->fmtlen;
+}
 
-            if (logger->bf.timeunitms) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                        "%04d-%02d-%02d%c%02d:%02d:%02d.%03d%.*s:%.*s", loc.tm_year, loc.tm_mon, loc.tm_mday, T, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000000), 3, timezonefmt, 2, timezonefmt + 3);
-            } else if (logger->bf.timeunitus) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                        "%04d-%02d-%02d%c%02d:%02d:%02d.%06d%.*s:%.*s", loc.tm_year, loc.tm_mon, loc.tm_mday, T, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000), 3, timezonefmt, 2, timezonefmt + 3);
-            } else {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                        "%04d-%02d-%02d%c%02d:%02d:%02d%.*s:%.*s",      loc.tm_year, loc.tm_mon, loc.tm_mday, T, loc.tm_hour, loc.tm_min, loc.tm_sec, 3, timezonefmt, 2, timezonefmt + 3);
-            }
-        } else if (logger->dateformat == CLOG_DATEFMT_UNIVERSAL) {
-            /* "Thu Dec 26 02:16:02 UTC 2019" */
-            if (logger->bf.timeunitms) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s %.3s %02d %02d:%02d:%02d.%03d UTC%.*s %04d", clog_week_strs[loc.tm_wday], clog_month_strs[loc.tm_mon], loc.tm_mday, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000000), 5*logger->bf.loctime, timezonefmt, loc.tm_year);
-            } else if (logger->bf.timeunitus) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s %.3s %02d %02d:%02d:%02d.%06d UTC%.*s %04d", clog_week_strs[loc.tm_wday], clog_month_strs[loc.tm_mon], loc.tm_mday, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000), 5*logger->bf.loctime, timezonefmt, loc.tm_year);
-            } else {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s %.3s %02d %02d:%02d:%02d UTC%.*s %04d", clog_week_strs[loc.tm_wday], clog_month_strs[loc.tm_mon], loc.tm_mday, loc.tm_hour, loc.tm_min, loc.tm_sec, 5*logger->bf.loctime, timezonefmt, loc.tm_year);
-            }
-        } else if (logger->dateformat == CLOG_DATEFMT_RFC_2822) {
-            /* "Thu, 26 Dec 2019 10:12:45 +0800" */
-            if (logger->bf.timeunitms) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s, %02d %.3s %04d %02d:%02d:%02d.%03d %.*s", clog_week_strs[loc.tm_wday], loc.tm_mday, clog_month_strs[loc.tm_mon], loc.tm_year, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000000), 5, timezonefmt);
-            } else if (logger->bf.timeunitus) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s, %02d %.3s %04d %02d:%02d:%02d.%06d %.*s", clog_week_strs[loc.tm_wday], loc.tm_mday, clog_month_strs[loc.tm_mon], loc.tm_year, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000), 5, timezonefmt);
-            } else {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%.3s, %02d %.3s %04d %02d:%02d:%02d %.*s", clog_week_strs[loc.tm_wday], loc.tm_mday, clog_month_strs[loc.tm_mon], loc.tm_year, loc.tm_hour, loc.tm_min, loc.tm_sec, 5, timezonefmt);
-            }
-        } else {
-            /* CLOG_DATEFMT_NUMERIC_1 = "20191226101245+0800", CLOG_DATEFMT_NUMERIC_2 = "20191226-101245+0800" */
-            char minuschr[2] = {'-', '\0'};
 
-            if (logger->dateformat == CLOG_DATEFMT_NUMERIC_1) {
-                minuschr[0] = '\0';
-            }
+/**
+ * timestamp of message is always read by caller. datetime and stampid are
+ *  formatted when dated unless rawtimestamp is set.
+ */
+static size_t clog_format_datetime (clog_logger logger, clog_message_fmt *msgfmt, int dated)
+{
+    struct timespec now;
+    struct tm loc = {0};
+    int timezone = 0;
+    int datlight = 0;
+    const char *timezonefmt = TIMEZONE_FORMAT_UTC;
+    int timeunit;
+    const clog_logger_settings *st;
 
-            if (logger->bf.timeunitms) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%04d%02d%02d%s%02d%02d%02d.%03d%.*s", loc.tm_year, loc.tm_mon, loc.tm_mday, minuschr, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000000), 5, timezonefmt);
-            } else if (logger->bf.timeunitus) {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%04d%02d%02d%s%02d%02d%02d.%06d%.*s", loc.tm_year, loc.tm_mon, loc.tm_mday, minuschr, loc.tm_hour, loc.tm_min, loc.tm_sec, (int)(now.tv_nsec / 1000), 5, timezonefmt);
-            } else {
-                datetimefmt->fmtlen = snprintf(datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf),
-                    "%04d%02d%02d%s%02d%02d%02d%.*s", loc.tm_year, loc.tm_mon, loc.tm_mday, minuschr, loc.tm_hour, loc.tm_min, loc.tm_sec, 5, timezonefmt);
-            }
-        }
+    rtclock_gettime(logger->rtc, logger->clocksource, &now);
+    msgfmt->timestamp = (ub8) now.tv_sec * 1000000000ULL + (ub8) now.tv_nsec;
 
-        totalfmtlen += datetimefmt->fmtlen;
+    if (! dated) {
+        return 0;
     }
 
-    if (stampidfmt) {
-        if (logger->bf.timestampid) {
-            stampidfmt->fmtlen = logger_manager_get_stampid(stampidfmt->fmtbuf, (int)sizeof(stampidfmt->fmtbuf));
-        } else {
-            stampidfmt->fmtlen = 0;
-            stampidfmt->fmtbuf[0] = 0;
+    st = clog_logger_settings_get(logger);
+
+    if (logger->bf.rawtimestamp) {
+        /* formatted by logthread */
+        if (st->bf.timestampid) {
+            struct timespec ts;
+            rtclock_ticktime(logger->rtc, &ts);
+            msgfmt->stampid = (ub8) ts.tv_sec * 1000000000ULL + (ub8) ts.tv_nsec;
         }
-        totalfmtlen += stampidfmt->fmtlen;
+        return 0;
+    }
+
+    if (st->bf.loctime) {
+        timezone = rtclock_timezone(logger->rtc, &timezonefmt);
+        datlight = rtclock_daylight(logger->rtc);
+    }
+    getlocaltime_safe(&loc, now.tv_sec, timezone, datlight);
+    loc.tm_year += 1900;
+    loc.tm_mon += 1;
+
+    timeunit = (st->bf.timeunitms? CLOG_TIMEUNIT_MSEC : (st->bf.timeunitus? CLOG_TIMEUNIT_USEC : CLOG_TIMEUNIT_SEC));
+
+    msgfmt->datetimefmt.fmtlen = logger_format_datetime(st->dateformat, timeunit, st->bf.loctime, timezonefmt, &loc, now.tv_nsec,
+                                msgfmt->datetimefmt.fmtbuf, sizeof(msgfmt->datetimefmt.fmtbuf));
+
+    if (st->bf.timestampid) {
+        msgfmt->stampidfmt.fmtlen = logger_manager_get_stampid(msgfmt->stampidfmt.fmtbuf, (int)sizeof(msgfmt->stampidfmt.fmtbuf));
     }
 
     /* all success */
-    return totalfmtlen;
+    return msgfmt->datetimefmt.fmtlen + msgfmt->stampidfmt.fmtlen;
+}
+
+
+/* logthread only: localtime of nanoseconds timestamp converted once a second */
+static const struct tm * clog_timestamp_localtime (clog_logger logger, ub8 timestamp)
+{
+    sb8 second = (sb8)(timestamp / 1000000000ULL);
+
+    if (second != logger->calsecond) {
+        bzero(&logger->calendar, sizeof(logger->calendar));
+        getlocaltime_safe(&logger->calendar, second, logger->datedopts.timezone, logger->datedopts.daylight);
+        logger->calendar.tm_year += 1900;
+        logger->calendar.tm_mon += 1;
+        logger->calsecond = second;
+    }
+
+    return &logger->calendar;
+}
+
+
+/* logthread only: dateminfmt for nanoseconds timestamp formatted once a minute */
+static const dateformat_buf * clog_timestamp_dateminfmt (clog_logger logger, ub8 timestamp)
+{
+    /* offset of timezone is whole minutes */
+    sb8 minute = (sb8)(timestamp / 60000000000ULL);
+
+    if (minute != logger->calminute) {
+        clog_format_dateminfmt(logger, clog_timestamp_localtime(logger, timestamp), &logger->dateminfmt);
+        logger->calminute = minute;
+    }
+
+    return &logger->dateminfmt;
 }
 
 
@@ -391,8 +977,9 @@ static void write_message_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
     char *msgbuf = msghdr->message;
     size_t msgcb = 0;
 
-    msghdr->dateminfmtlen = msg->dateminfmt.fmtlen;
-    memcpy(msghdr->dateminfmt, msg->dateminfmt.fmtbuf, msghdr->dateminfmtlen);
+    msghdr->timestamp = msg->timestamp;
+    msghdr->stampid = msg->stampid;
+    msghdr->level = (ub1) msg->msglevel;
 
     if (msg->stampidfmt.fmtlen) {
         memcpy(msgbuf + msgcb, msg->stampidfmt.fmtbuf, msg->stampidfmt.fmtlen);
@@ -400,17 +987,26 @@ static void write_message_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
         msgbuf[msgcb++] = 32;
     }
 
+    if (msg->seq) {
+        /* ahead of bodyoffset: not compared for duplicates */
+        msgcb += snprintf(msgbuf + msgcb, CLOG_SEQFMT_SIZE, "#%"PRIu64" ", (uint64_t) msg->seq);
+    }
+
     if (msg->startclrlen) {
         memcpy(msgbuf + msgcb, msg->startclrfmt, msg->startclrlen);
         msgcb += msg->startclrlen;
     }
 
+    msghdr->timeoffset = (ub2) msgcb;
+
     if (msg->datetimefmt.fmtlen) {
         memcpy(msgbuf + msgcb, msg->datetimefmt.fmtbuf, msg->datetimefmt.fmtlen);
         msgcb += msg->datetimefmt.fmtlen;
         msgbuf[msgcb++] = 32;
     }
 
+    msghdr->bodyoffset = (ub2) msgcb;
+
     memcpy(msgbuf + msgcb, clog_level_strs[msg->level], clog_level_lens[msg->level]);
     msgcb += clog_level_lens[msg->level];
     msgbuf[msgcb++] = 32;
@@ -442,633 +1038,2723 @@ static void write_message_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
         msgcb += 4;
     }
 
-    memcpy(msgbuf + msgcb, msg->message, msg->msglen);
-    msgcb += msg->msglen;
+    if (msg->mdclen) {
+        memcpy(msgbuf + msgcb, msg->mdc, msg->mdclen);
+        msgcb += msg->mdclen;
+        msgbuf[msgcb++] = 32;
+    }
+
+    msghdr->kind = (ub1) msg->kind;
+    msghdr->kvoffset = (ub4) msgcb;
+
+    if (msg->spillformat) {
+        va_list args;
+        int textlen;
+
+        va_copy(args, *msg->spillargs);
+        textlen = vsnprintf(msgbuf + msgcb, msg->spilltextlen + 1, msg->spillformat, args);
+        va_end(args);
+
+        if (textlen < 0 || textlen > (int) msg->spilltextlen) {
+            /* arguments changed since sized: never for sane caller */
+            textlen = (int) cstr_length(msgbuf + msgcb, (int) msg->spilltextlen);
+        }
+        if (msg->spillsuppressed) {
+            textlen = clog_message_add_suppressed(msgbuf + msgcb, textlen, textlen + CLOG_SUPPRESSED_SIZE, msg->spillsuppressed);
+        }
+        msgcb += textlen;
+    } else {
+        memcpy(msgbuf + msgcb, msg->message, msg->msglen);
+        msgcb += msg->msglen;
+    }
 
-    if (msg->autowrapline) {
+    if (msg->kind == CLOG_MSGKIND_KV) {
+        /* line wrapped after rendering by logthread */
+        msghdr->autowrapline = (ub1) msg->autowrapline;
+    } else if (msg->autowrapline) {
         if (msgbuf[msgcb - 1] != '\n') {
             msgbuf[msgcb++] = '\n';
         }
     }
 
-    msghdr->offsetcb = sizeof(*msghdr) + msgcb;
+    msghdr->offsetcb = (ub4)(sizeof(*msghdr) + msgcb);
 }
 
 
-static int read_message_cb (const ringbuf_entry_st *entry, void *arg)
-{
-    clog_logger logger = (clog_logger) arg;
+#define JSON_PUTS(p, s)  do { \
+        memcpy((p), (s), sizeof(s) - 1); \
+        (p) += sizeof(s) - 1; \
+    } while(0)
 
-    int wok, err;
+#define JSON_PUTESC(p, s, n)  do { \
+        (p) += json_escape_copy((p), (s), (n)); \
+    } while(0)
 
-    clog_message_hdr *msghdr = (clog_message_hdr *) entry->chunk;
-    size_t messagelen = msghdr->offsetcb - sizeof(*msghdr);
 
-    if (logger->bf.appenderstdout) {
-        fprintf(stdout, "%.*s", (int) messagelen, msghdr->message);
-    }
+/**
+ * assemble one json object per line:
+ *   {"seq":N,"ts":"..","sid":"..","level":"..","ident":"..","file":"..","line":N,"func":"..","pid":N,"tid":N,"mdc":{..},"msg":".."}
+ *
+ * for KV message the object is not closed and encoded fields are appended
+ *  to be rendered as members by logthread.
+ */
+static void write_message_json_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
+{
+    const clog_message_fmt *msg = (const clog_message_fmt *) entry;
+
+    clog_message_hdr *msghdr = (clog_message_hdr *) chunkbuf;
 
-    if (logger->bf.appendersyslog) {
-        int priority = (LOG_DEBUG + 1);
+    char *p = msghdr->message;
 
-        switch (logger->level) {
-        case CLOG_LEVEL_FATAL:
-            priority = LOG_EMERG;
-            break;
+    msghdr->timestamp = msg->timestamp;
+    msghdr->stampid = msg->stampid;
+    msghdr->level = (ub1) msg->msglevel;
 
-        case CLOG_LEVEL_ERROR:
-            priority = LOG_ERR;
-            break;
+    *p++ = '{';
+    if (msg->seq) {
+        p += snprintf(p, CLOG_SEQFMT_SIZE, "\"seq\":%"PRIu64",", (uint64_t) msg->seq);
+    }
+    JSON_PUTS(p, "\"ts\":\"");
+    msghdr->timeoffset = (ub2)(p - msghdr->message);
+    JSON_PUTESC(p, msg->datetimefmt.fmtbuf, msg->datetimefmt.fmtlen);
 
-        case CLOG_LEVEL_WARN:
-            priority = LOG_WARNING;
-            break;
+    if (msg->stampidfmt.fmtlen) {
+        JSON_PUTS(p, "\",\"sid\":\"");
+        memcpy(p, msg->stampidfmt.fmtbuf, msg->stampidfmt.fmtlen);
+        p += msg->stampidfmt.fmtlen;
+    }
 
-        case CLOG_LEVEL_INFO:
-            priority = LOG_INFO;
-            break;
+    msghdr->bodyoffset = (ub2)(p - msghdr->message);
 
-        case CLOG_LEVEL_DEBUG:
-            priority = LOG_DEBUG;
-            break;
+    JSON_PUTS(p, "\",\"level\":\"");
+    memcpy(p, clog_level_strs[msg->level], clog_level_lens[msg->level]);
+    p += clog_level_lens[msg->level];
 
-        case CLOG_LEVEL_ALL:
-        case CLOG_LEVEL_TRACE:
-        case CLOG_LEVEL_OFF:
-            break;
-        }
+    if (msg->ident) {
+        JSON_PUTS(p, "\",\"ident\":\"");
+        JSON_PUTESC(p, msg->ident->str, msg->ident->len);
+    }
 
-        if (priority <= LOG_DEBUG) {
-            syslog(LOG_USER | priority, "%.*s", (int)messagelen, msghdr->message);
-        }
+    *p++ = '"';
+
+    if (msg->filename) {
+        JSON_PUTS(p, ",\"file\":\"");
+        JSON_PUTESC(p, msg->filename, msg->filenamelen);
+        JSON_PUTS(p, "\",\"line\":");
+        p += snprintf(p, 12, "%d", msg->lineno);
+        JSON_PUTS(p, ",\"func\":\"");
+        JSON_PUTESC(p, msg->funcname, msg->funcnamelen);
+        *p++ = '"';
     }
 
-    wok = 0;
-    if (logger->bf.appendershmlog) {
-        wok = shmmaplog_write(logger->shmlog, msghdr->message, messagelen);
+#ifndef CLOGGER_NO_THREADNO
+    if (msg->threadnofmtlen) {
+        /* ,"pid":1899,"tid":1 */
+        memcpy(p, msg->threadnofmt, msg->threadnofmtlen);
+        p += msg->threadnofmtlen;
     }
+#endif
 
-    if (!wok && logger->bf.appenderrofile) {
-        err = rollingfile_write(&logger->logfile, msghdr->dateminfmt, (int)msghdr->dateminfmtlen, msghdr->message, messagelen);
-        if (err == -1) {
-            emerglog_exit("libclogger", "rollingfile_write() error due to the path for logfile not existed: %.*s\n",
-                cstrbufGetLen(logger->logfile.loggingfile),
-                cstrbufGetStr(logger->logfile.loggingfile));
-        }
+    if (msg->mdclen) {
+        /* ,"mdc":{"reqid":"abc"} */
+        JSON_PUTS(p, ",\"mdc\":");
+        memcpy(p, msg->mdc, msg->mdclen);
+        p += msg->mdclen;
     }
 
-    if (uatomic_int64_add(&logger->logmessages) == SB8MAXVAL) {
-        uatomic_int64_zero(&logger->logmessages);
-        uatomic_int64_add(&logger->logrounds);
+    msghdr->kind = (ub1) msg->kind;
+    msghdr->autowrapline = 1;
+
+    if (msg->kind == CLOG_MSGKIND_KV) {
+        msghdr->kvoffset = (ub4)(p - msghdr->message);
+        memcpy(p, msg->message, msg->msglen);
+        p += msg->msglen;
+    } else {
+        JSON_PUTS(p, ",\"msg\":\"");
+        JSON_PUTESC(p, msg->message, msg->msglen);
+        JSON_PUTS(p, "\"}\n");
     }
 
-    return 1;
+    msghdr->offsetcb = (ub4)(sizeof(*msghdr) + (p - msghdr->message));
 }
 
 
-static void * clog_threadfunc (void *arg)
+/* BINARY record is copied as it is */
+static void write_message_bin_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
 {
-    clog_logger logger = (clog_logger) arg;
+    const clog_message_fmt *msg = (const clog_message_fmt *) entry;
 
-    while (pthread_mutex_trylock(&logger->shutdownlock) != 0) {
-        if (unsema_timedwait(&logger->sema, 1000) == 0) {
-            /* bugfix(2025-02-13):
-             *   old: ringbufst_read_next(logger->ringbuffer, read_message_cb, logger);
-             * read all messages until no message(=0)
-             */
-            while (ringbufst_read_next(logger->ringbuffer, read_message_cb, logger));
-        }
-    }
+    clog_message_hdr *msghdr = (clog_message_hdr *) chunkbuf;
 
-    pthread_mutex_destroy(&logger->shutdownlock);
-    return (void*) 0;
+    /* timestamp is in record */
+    msghdr->timestamp = 0;
+    msghdr->stampid = 0;
+    msghdr->timeoffset = 0;
+    msghdr->bodyoffset = 0;
+    msghdr->kvoffset = 0;
+    msghdr->kind = CLOG_MSGKIND_BIN;
+    msghdr->autowrapline = 0;
+    msghdr->level = (ub1) msg->msglevel;
+    msghdr->seq = msg->seq;
+
+    memcpy(msghdr->message, msg->message, msg->msglen);
+
+    msghdr->offsetcb = (ub4)(sizeof(*msghdr) + msg->msglen);
 }
 
 
-/**
- * public helper api
- */
-void clog_set_levelcolor(clog_logger logger, clog_level_t level, clog_color_t color)
+/* SPILL record goes to ring, message is in chunk of record */
+static void write_message_spill_cb (char *chunkbuf, size_t chunkbufsz, void *entry)
 {
-    logger->levelcolors[ level ] = color;
+    const clog_message_fmt *msg = (const clog_message_fmt *) entry;
+
+    clog_message_hdr *msghdr = (clog_message_hdr *) chunkbuf;
+
+    msghdr->timestamp = msg->timestamp;
+    msghdr->stampid = 0;
+    msghdr->timeoffset = 0;
+    msghdr->bodyoffset = 0;
+    msghdr->kvoffset = 0;
+    msghdr->kind = CLOG_MSGKIND_SPILL;
+    msghdr->autowrapline = 0;
+    msghdr->level = (ub1) msg->msglevel;
+    msghdr->seq = msg->seq;
+
+    memcpy(msghdr->message, msg->spill, sizeof(clog_message_spill));
+
+    msghdr->offsetcb = (ub4)(sizeof(*msghdr) + sizeof(clog_message_spill));
 }
 
 
-void clog_set_levelstyle(clog_logger logger, clog_level_t level, clog_style_t style)
+/* logthread only: datetime of nanoseconds timestamp */
+static void clog_timestamp_datetimefmt (clog_logger logger, ub8 timestamp, dateformat_buf *datetimefmt)
 {
-    logger->levelstyles[ level ] = style;
+    const logger_dated_opts *opts = &logger->datedopts;
+
+    int timeunit = ((opts->flags & LOGGER_DATED_TIMEUNITMS)? CLOG_TIMEUNIT_MSEC :
+                        ((opts->flags & LOGGER_DATED_TIMEUNITUS)? CLOG_TIMEUNIT_USEC : CLOG_TIMEUNIT_SEC));
+
+    datetimefmt->fmtlen = logger_format_datetime(opts->dateformat, timeunit, (opts->flags & LOGGER_DATED_LOCTIME)? 1 : 0, opts->tzfmt,
+                                clog_timestamp_localtime(logger, timestamp), (long)(timestamp % 1000000000ULL),
+                                datetimefmt->fmtbuf, sizeof(datetimefmt->fmtbuf));
 }
 
 
-int clog_level_from_string (const char *levelstring, int length, clog_level_t *level)
+/**
+ * rawtimestamp: datetime and stampid formatted by logthread are put at
+ *   timeoffset of header text.
+ */
+static size_t render_rawtime (clog_logger logger, const clog_message_hdr *msghdr, size_t textlen, char *outbuf)
 {
-    int lvl = cstr_findstr_in(levelstring, length, clog_level_strs, (int)(sizeof(clog_level_strs)/sizeof(clog_level_strs[0])), 1);
+    char *p = outbuf;
 
-    if (lvl != -1) {
-        *level = (clog_level_t) lvl;
+    dateformat_buf datetimefmt, stampidfmt;
 
-        /* success */
-        return 1;
+    clog_timestamp_datetimefmt(logger, msghdr->timestamp, &datetimefmt);
+
+    /* stampid is taken by caller if timestampid was set */
+    stampidfmt.fmtlen = 0;
+    if (msghdr->stampid) {
+        stampidfmt.fmtlen = snprintf(stampidfmt.fmtbuf, sizeof(stampidfmt.fmtbuf), "{%"PRId64".%09d}",
+                                (int64_t)(msghdr->stampid / 1000000000ULL), (int)(msghdr->stampid % 1000000000ULL));
     }
 
-    /* failed as default */
-    return 0;
-}
+    if (logger->layout == CLOG_LAYOUT_JSON) {
+        memcpy(p, msghdr->message, msghdr->timeoffset);
+        p += msghdr->timeoffset;
 
+        JSON_PUTESC(p, datetimefmt.fmtbuf, datetimefmt.fmtlen);
 
-int clog_layout_from_string(const char *layoutstring, int length, clog_layout_t *layout)
-{
-    if (!cstr_compare_len(layoutstring, length, "PLAIN", 5, 1)) {
-        *layout = CLOG_LAYOUT_PLAIN;
-        return 1;
-    }
+        if (stampidfmt.fmtlen) {
+            JSON_PUTS(p, "\",\"sid\":\"");
+            memcpy(p, stampidfmt.fmtbuf, stampidfmt.fmtlen);
+            p += stampidfmt.fmtlen;
+        }
+    } else {
+        if (stampidfmt.fmtlen) {
+            memcpy(p, stampidfmt.fmtbuf, stampidfmt.fmtlen);
+            p += stampidfmt.fmtlen;
+            *p++ = 32;
+        }
 
-    if (!cstr_compare_len(layoutstring, length, "DATED", 5, 1)) {
-        *layout = CLOG_LAYOUT_DATED;
-        return 1;
+        memcpy(p, msghdr->message, msghdr->timeoffset);
+        p += msghdr->timeoffset;
+
+        memcpy(p, datetimefmt.fmtbuf, datetimefmt.fmtlen);
+        p += datetimefmt.fmtlen;
+        *p++ = 32;
     }
 
-    /* failed as default */
-    return 0;
+    memcpy(p, msghdr->message + msghdr->timeoffset, textlen - msghdr->timeoffset);
+    p += textlen - msghdr->timeoffset;
+
+    return (size_t)(p - outbuf);
 }
 
 
-int clog_dateformat_from_string(const char *datefmtstring, int length, clog_dateformat_t *dateformat)
+/**
+ * render message as text in logthread:
+ *   header text is copied (with datetime if rawtimestamp) and encoded fields
+ *   of KV message are rendered after it.
+ */
+static size_t render_message (clog_logger logger, const clog_message_hdr *msghdr, size_t messagelen)
 {
-    if (!cstr_compare_len(datefmtstring, length, "UTC", 3, 1)) {
-        *dateformat = CLOG_DATEFMT_UNIVERSAL;
-        return 1;
-    }
-    if (!cstr_compare_len(datefmtstring, length, "UNIVERSAL", 9, 1)) {
-        *dateformat = CLOG_DATEFMT_UNIVERSAL;
-        return 1;
-    }
-
-    if (!cstr_compare_len(datefmtstring, length, "NUMERIC-1", 9, 1)) {
-        *dateformat = CLOG_DATEFMT_NUMERIC_1;
-        return 1;
-    }
-    if (!cstr_compare_len(datefmtstring, length, "NUMERIC", 7, 1)) {
-        *dateformat = CLOG_DATEFMT_NUMERIC_1;
-        return 1;
-    }
+    char *outbuf = logger->renderbuf;
+    size_t outsz = logger->renderbufsz - 1;
+    size_t textlen = (msghdr->kind == CLOG_MSGKIND_KV)? msghdr->kvoffset : messagelen;
+    size_t len;
 
-    if (!cstr_compare_len(datefmtstring, length, "NUMERIC-2", 9, 1)) {
-        *dateformat = CLOG_DATEFMT_NUMERIC_2;
-        return 1;
+    if (logger->bf.rawtimestamp) {
+        len = render_rawtime(logger, msghdr, textlen, outbuf);
+    } else {
+        memcpy(outbuf, msghdr->message, textlen);
+        len = textlen;
     }
 
-    if (!cstr_compare_len(datefmtstring, length, "RFC-3339", 8, 1)) {
-        *dateformat = CLOG_DATEFMT_RFC_3339;
-        return 1;
-    }
-    if (!cstr_compare_len(datefmtstring, length, "DEFAULT", 7, 1)) {
-        *dateformat = CLOG_DATEFMT_RFC_3339;
-        return 1;
+    if (msghdr->kind != CLOG_MSGKIND_KV) {
+        return len;
     }
 
-    if (!cstr_compare_len(datefmtstring, length, "ISO-8601", 8, 1)) {
-        *dateformat = CLOG_DATEFMT_ISO_8601;
-        return 1;
+    if (logger->layout == CLOG_LAYOUT_JSON) {
+        /* fields are rendered as {"k":v,...} and become members of line object by '{' => ',' */
+        size_t kvlen = logger_kv_render(CLOG_KVFORMAT_JSON, msghdr->message + textlen, messagelen - textlen, outbuf + len, outsz - len);
+        if (kvlen) {
+            outbuf[len] = ',';
+            len += kvlen;
+        } else {
+            outbuf[len++] = '}';
+        }
+    } else {
+        len += logger_kv_render(logger->datedopts.kvformat, msghdr->message + textlen, messagelen - textlen, outbuf + len, outsz - len);
     }
 
-    if (!cstr_compare_len(datefmtstring, length, "RFC-2822", 8, 1)) {
-        *dateformat = CLOG_DATEFMT_RFC_2822;
-        return 1;
+    if (msghdr->autowrapline) {
+        outbuf[len++] = '\n';
     }
 
-    /* failed as default */
-    return 0;
+    return len;
 }
 
 
-int clog_appender_from_string (const char *appenderstring, int length, int *appender)
+/* logthread only: write to rolling file named by timestamp */
+static void clog_logger_rofile_write (clog_logger logger, rollingfile_t *rof, ub8 timestamp, const char *message, size_t messagelen)
 {
-    int appenders = 0;
+    const dateformat_buf *dateminfmt = clog_timestamp_dateminfmt(logger, timestamp);
 
-    cstrbuf apstr = cstrbufNew(0, appenderstring, length);
-    cstr_toupper(apstr->str, apstr->len);
-
-    if (cstr_containwith(apstr->str, apstr->len, "STDOUT", 6) != -1) {
-        appenders |= CLOG_APPENDER_STDOUT;
-    }
-    if (cstr_containwith(apstr->str, apstr->len, "ROFILE", 6) != -1) {
-        appenders |= CLOG_APPENDER_ROFILE;
-    }
-    if (cstr_containwith(apstr->str, apstr->len, "SYSLOG", 6) != -1) {
-        appenders |= CLOG_APPENDER_SYSLOG;
-    }
-    if (cstr_containwith(apstr->str, apstr->len, "SHMLOG", 6) != -1) {
-        appenders |= CLOG_APPENDER_SHMMAP;
+    if (rollingfile_write(rof, dateminfmt->fmtbuf, (int)dateminfmt->fmtlen, message, messagelen) == -1) {
+        emerglog_exit("libclogger", "rollingfile_write() error due to the path for logfile not existed: %.*s\n",
+            cstrbufGetLen(rof->loggingfile),
+            cstrbufGetStr(rof->loggingfile));
     }
+}
 
-    if (!appenders) {
-        /* failed as default */
-        cstrbufFree(&apstr);
-        return 0;
-    }
 
-    *appender = appenders;
-    cstrbufFree(&apstr);
-    return 1;
+/* logthread only: 1 if any appender or route of settings takes message of level */
+static int clog_logger_level_routed (clog_logger logger, const clog_logger_settings *st, clog_level_t level)
+{
+    return ((st->bf.appenderstdout && level <= st->stdoutlevel) ||
+            (st->bf.appendersyslog && level <= st->sysloglevel) ||
+            (st->bf.appendershmlog && level <= st->shmloglevel) ||
+            (st->bf.appenderrofile && (level <= st->rofilelevel || (logger->routedlevels & (1U << level)))))? 1 : 0;
 }
 
 
-/**
- * public api
- */
-clog_logger clog_logger_create (clogger_conf conf, logger_manager mgr)
+/* logthread or worker of appender SYSLOG */
+static void clog_syslog_write (void *arg, clog_level_t level, const char *message, size_t messagelen)
 {
-    clog_logger_t *logger;
+    int priority = (LOG_DEBUG + 1);
 
-    struct timespec ts;
+    switch (level) {
+    case CLOG_LEVEL_FATAL:
+        priority = LOG_EMERG;
+        break;
 
-    char timestr[22] = {0};
+    case CLOG_LEVEL_ERROR:
+        priority = LOG_ERR;
+        break;
 
-    cstrbuf namepatternRep = 0;
-    cstrbuf pathprefixRep = 0;
-    cstrbuf shmlogfileRep = 0;
+    case CLOG_LEVEL_WARN:
+        priority = LOG_WARNING;
+        break;
 
-    ub4 flags = (int) logger_conf_get_creatflags(conf);
+    case CLOG_LEVEL_INFO:
+        priority = LOG_INFO;
+        break;
 
-    CHKCONFIG_INT_VALUE(CLOG_MSGBUF_SIZE_DEFAULT, CLOG_MSGBUF_SIZE_MIN, CLOG_MSGBUF_SIZE_MAX, conf->maxmsgsize);
+    case CLOG_LEVEL_DEBUG:
+        priority = LOG_DEBUG;
+        break;
 
-    CHKCONFIG_INT_VALUE(128, 64, 1024, conf->maxconcurrents);
-    if (conf->maxconcurrents > conf->queuelength) {
-        conf->maxconcurrents = memapi_align_psize(conf->queuelength);
+    case CLOG_LEVEL_ALL:
+    case CLOG_LEVEL_TRACE:
+    case CLOG_LEVEL_OFF:
+        break;
     }
 
-    getnowtimeofday(&ts);
-    snprintf(timestr, sizeof(timestr), "%"PRId64, (int64_t)ts.tv_sec);
+    if (priority <= LOG_DEBUG) {
+        syslog(LOG_USER | priority, "%.*s", (int)messagelen, message);
+    }
+}
 
-    logger = (clog_logger_t *) mem_alloc_zero(1, sizeof(*logger));
 
-    logger->rtc = mgr->rtclock;
+/* worker of appender STDOUT: flushes once queue is empty */
+static void clog_stdout_write (void *arg, clog_level_t level, const char *message, size_t messagelen)
+{
+    fwrite(message, 1, messagelen, stdout);
+}
 
-    logger->pidcstrlen = snprintf(logger->pidcstr, sizeof(logger->pidcstr), "%d", getprocessid());
 
-    if (CLOG_TIMEUNIT_MSEC & flags) {
-        logger->bf.timeunitms = 1;
-        logger->bf.timeunitus = 0;
-    }
-    if (CLOG_TIMEUNIT_USEC & flags) {
-        logger->bf.timeunitms = 0;
-        logger->bf.timeunitus = 1;
-    }
-    if (CLOG_TIMESTAMP_ID & flags) {
-        logger->bf.timestampid = 1;
-    }
+static void clog_stdout_idle (void *arg)
+{
+    fflush(stdout);
+}
 
-    if (CLOG_TIMEZONE_LOC & flags) {
-        logger->bf.loctime = 1;
-    }
 
-    if (CLOG_ROLLING_SIZE_BASED & flags) {
-        logger->bf.rollingsize = 1;
+/* logthread only: write text line to appenders of settings which take level */
+static void clog_logger_write_appenders (clog_logger logger, const clog_logger_settings *st, clog_level_t level, const char *message, size_t messagelen, ub8 timestamp)
+{
+    int wok, i;
+
+    ub4 levelbit = (1U << level);
+
+    if (st->bf.appenderstdout && level <= st->stdoutlevel) {
+        if (! logger->stdoutsink) {
+            fprintf(stdout, "%.*s", (int) messagelen, message);
+        } else if (! logger_sink_push(logger->stdoutsink, level, message, messagelen)) {
+            /* slow reader of stdout never stalls logthread */
+            uatomic_int64_add(&logger->dropped);
+        }
     }
-    if (CLOG_ROLLING_TIME_BASED & flags) {
-        logger->bf.rollingtime = 1;
+
+    if (st->bf.appendersyslog && level <= st->sysloglevel) {
+        if (! logger->syslogsink) {
+            clog_syslog_write(logger, level, message, messagelen);
+        } else if (! logger_sink_push(logger->syslogsink, level, message, messagelen)) {
+            uatomic_int64_add(&logger->dropped);
+        }
     }
 
-    if (CLOG_APPENDER_STDOUT & flags) {
-        logger->bf.appenderstdout = 1;
+    wok = 0;
+    if (st->bf.appendershmlog && level <= st->shmloglevel) {
+        wok = shmmaplog_write(logger->shmlog, message, messagelen);
     }
-    if (CLOG_APPENDER_SYSLOG & flags) {
-        logger->bf.appendersyslog = 1;
+
+    if (!wok && st->bf.appenderrofile && level <= st->rofilelevel && !(st->routeonly && (logger->routedlevels & levelbit))) {
+        clog_logger_rofile_write(logger, &logger->logfile, timestamp, message, messagelen);
     }
-    if (CLOG_APPENDER_ROFILE & flags) {
-        logger->bf.appenderrofile = 1;
+
+    if (st->bf.appenderrofile && (logger->routedlevels & levelbit)) {
+        for (i = 0; i < logger->numroutes; i++) {
+            if (logger->routes[i].levels & levelbit) {
+                clog_logger_rofile_write(logger, &logger->routes[i].logfile, timestamp, message, messagelen);
+            }
+        }
     }
-    if (CLOG_APPENDER_SHMMAP & flags) {
-        logger->bf.appendershmlog = 1;
+}
+
+
+/**
+ * logthread only: write summary of duplicates not logged:
+ *   2019-12-22 17:35:28.188+08:00 <client> last message repeated 1234 times (first 2019-12-22 17:35:26.001+08:00, last ...)
+ */
+static void clog_logger_repeated_flush (clog_logger logger, const clog_logger_settings *st)
+{
+    dateformat_buf firstfmt, lastfmt;
+    int len;
+
+    if (! logger->dup.count) {
+        return;
     }
 
-    if (CLOG_LEVEL_COLORS & flags) {
-        logger->bf.levelcolors = 1;
+    clog_timestamp_datetimefmt(logger, logger->dup.firstts, &firstfmt);
+    clog_timestamp_datetimefmt(logger, logger->dup.lastts, &lastfmt);
+
+    if (logger->layout == CLOG_LAYOUT_JSON) {
+        len = snprintf(logger->renderbuf, logger->renderbufsz, "{\"ts\":\"%.*s\",\"ident\":\"%.*s\",\"repeated\":%" PRIu64 ",\"first\":\"%.*s\",\"last\":\"%.*s\"}\n",
+                (int) lastfmt.fmtlen, lastfmt.fmtbuf,
+                (int) logger->ident->len, logger->ident->str,
+                logger->dup.count,
+                (int) firstfmt.fmtlen, firstfmt.fmtbuf,
+                (int) lastfmt.fmtlen, lastfmt.fmtbuf);
+    } else {
+        len = snprintf(logger->renderbuf, logger->renderbufsz, "%.*s <%.*s> last message repeated %" PRIu64 " times (first %.*s, last %.*s)\n",
+                (int) lastfmt.fmtlen, lastfmt.fmtbuf,
+                (int) logger->ident->len, logger->ident->str,
+                logger->dup.count,
+                (int) firstfmt.fmtlen, firstfmt.fmtbuf,
+                (int) lastfmt.fmtlen, lastfmt.fmtbuf);
     }
-    if (CLOG_LEVEL_STYLES & flags) {
-        logger->bf.levelstyles = 1;
+
+    if (len > 0 && len < (int) logger->renderbufsz) {
+        clog_logger_write_appenders(logger, st, logger->dup.level, logger->renderbuf, (size_t) len, logger->dup.lastts);
     }
 
-    if (CLOG_FILE_LINENO & flags) {
-        logger->bf.filelineno = 1;
+    logger->dup.count = 0;
+}
+
+
+/**
+ * logthread only: returns 1 if body is same as last message within window
+ *  of coalesce and is counted instead of logged.
+ */
+static int clog_logger_coalesce (clog_logger logger, const clog_logger_settings *st, clog_level_t level, const char *body, size_t bodylen, ub8 timestamp)
+{
+    ub4 hash = crc32c(0, body, bodylen);
+
+    if (logger->dup.len == (ub4) bodylen && logger->dup.hash == hash &&
+        timestamp >= logger->dup.startts && timestamp - logger->dup.startts < (ub8) st->coalesce * 1000000000ULL &&
+        ! memcmp(logger->dup.buf, body, bodylen)) {
+        if (! logger->dup.count++) {
+            logger->dup.firstts = timestamp;
+        }
+        logger->dup.lastts = timestamp;
+        return 1;
     }
-    if (CLOG_FUNCTION_NAME & flags) {
-        logger->bf.function = 1;
+
+    /* run of duplicates ends before this message */
+    clog_logger_repeated_flush(logger, st);
+
+    if (bodylen > logger->dup.bufsz) {
+        logger->dup.bufsz = memapi_align_psize(bodylen);
+        logger->dup.buf = (char *) mem_realloc(logger->dup.buf, logger->dup.bufsz);
     }
+    memcpy(logger->dup.buf, body, bodylen);
 
-    if (conf->autowrapline) {
-        logger->bf.autowrapline = 1;
+    logger->dup.hash = hash;
+    logger->dup.len = (ub4) bodylen;
+    logger->dup.startts = timestamp;
+    logger->dup.level = level;
+
+    return 0;
+}
+
+
+static void clog_logger_read_message (clog_logger logger, clog_message_hdr *msghdr)
+{
+    size_t messagelen = msghdr->offsetcb - sizeof(*msghdr);
+    const char *message = msghdr->message;
+
+    ub8 timestamp = msghdr->timestamp;
+    clog_level_t level = (clog_level_t) msghdr->level;
+
+    const clog_logger_settings *st = logger->applied;
+
+    if (msghdr->kind == CLOG_MSGKIND_BIN) {
+        logger_record rec;
+        logger_bin_record_view(msghdr->message, messagelen, &rec);
+        rec.seq = msghdr->seq;
+
+        if (logger->bf.appenderbinfile) {
+            logger_bin_writer_append(logger->binwriter, &rec);
+        }
+
+        if (! clog_logger_level_routed(logger, st, level)) {
+            /* no text appender takes level: record is not formatted */
+            goto count_message;
+        }
+
+        /* record without timestamp and stampid */
+        if (st->coalesce && messagelen > offsetof(logger_bin_record, threadid) &&
+            clog_logger_coalesce(logger, st, level, message + offsetof(logger_bin_record, threadid), messagelen - offsetof(logger_bin_record, threadid), rec.timestamp)) {
+            goto count_message;
+        }
+
+        /* deferred formatting in logthread */
+        messagelen = logger_format_dated(&logger->datedopts, &rec, logger->renderbuf, logger->renderbufsz);
+        message = logger->renderbuf;
+        timestamp = rec.timestamp;
+    } else {
+        if (! clog_logger_level_routed(logger, st, level)) {
+            goto count_message;
+        }
+
+        if (st->coalesce && clog_logger_coalesce(logger, st, level, message + msghdr->bodyoffset, messagelen - msghdr->bodyoffset, timestamp)) {
+            goto count_message;
+        }
+
+        if (msghdr->kind == CLOG_MSGKIND_KV || logger->bf.rawtimestamp) {
+            messagelen = render_message(logger, msghdr, messagelen);
+            message = logger->renderbuf;
+        }
     }
 
-    if (conf->hideident) {
-        logger->bf.hideident = 1;
+    clog_logger_write_appenders(logger, st, level, message, messagelen, timestamp);
+
+count_message:
+    if (uatomic_int64_add(&logger->logmessages) == SB8MAXVAL) {
+        uatomic_int64_zero(&logger->logmessages);
+        uatomic_int64_add(&logger->logrounds);
     }
+}
 
-#ifndef CLOGGER_NO_THREADNO
-    if (conf->processid) {
-        logger->bf.processid = 1;
+
+static void clog_logger_spill_free (clog_logger logger, const clog_message_spill *spill)
+{
+    uatomic_int64_sub_n(&logger->spillbytes, spill->chunksize);
+    mem_free(spill->chunk);
+}
+
+
+static int read_message_cb (const ringbuf_entry_st *entry, void *arg)
+{
+    clog_logger logger = (clog_logger) arg;
+
+    clog_message_hdr *msghdr = (clog_message_hdr *) entry->chunk;
+
+    if (msghdr->kind == CLOG_MSGKIND_SPILL) {
+        const clog_message_spill *spill = (const clog_message_spill *) msghdr->message;
+
+        if (spill->epoch != logger->spillepoch) {
+            /* recovered by flight recorder: chunk was on heap of last process */
+            uatomic_int64_add(&logger->dropped);
+            return 1;
+        }
+
+        if (logger->bf.rawtimestamp && spill->chunksize + logger->maxmsgsize > logger->renderbufsz) {
+            /* datetime is put into text of spilled message */
+            mem_free(logger->renderbuf);
+            logger->renderbufsz = spill->chunksize + logger->maxmsgsize;
+            logger->renderbuf = (char *) mem_alloc_unset(logger->renderbufsz);
+        }
+
+        clog_logger_read_message(logger, spill->chunk);
+        clog_logger_spill_free(logger, spill);
+        return 1;
     }
 
-    if (conf->threadno) {
-        logger->bf.threadno = 1;
+    clog_logger_read_message(logger, msghdr);
+    return 1;
+}
+
+
+/* full block of BINFILE written to rolling file */
+static int write_binblock_cb (void *arg, ub8 firstts, const char *block, size_t blocklen)
+{
+    clog_logger logger = (clog_logger) arg;
+
+    clog_logger_rofile_write(logger, &logger->logfile, firstts, block, blocklen);
+
+    return 1;
+}
+
+
+/* keep on current file when policy is reloaded */
+static void clog_logger_apply_rolling (clog_logger logger, const clog_logger_settings *st, rollingfile_t *rof)
+{
+    int appendfileno = rof->appendfileno;
+
+    rollingfile_set_timepolicy(rof, st->rollingtime);
+    rollingfile_set_sizepolicy(rof, st->maxfilesize, st->maxfilecount, st->rollingappend);
+
+    if (logger->applied && appendfileno < (int) rof->maxfilecount) {
+        rof->appendfileno = appendfileno;
     }
+}
+
+
+/**
+ * logthread only (or create before logthread starts): options for rendering
+ *  and rolling policy of logfile and routes are taken from settings.
+ */
+static void clog_logger_apply_settings (clog_logger logger, const clog_logger_settings *st)
+{
+    logger_dated_opts *opts = &logger->datedopts;
+    int i;
+
+    opts->flags = (st->bf.timeunitms? LOGGER_DATED_TIMEUNITMS : 0) |
+            (st->bf.timeunitus? LOGGER_DATED_TIMEUNITUS : 0) |
+            (st->bf.loctime? LOGGER_DATED_LOCTIME : 0) |
+            (st->bf.timestampid? LOGGER_DATED_TIMESTAMPID : 0) |
+            (st->bf.filelineno? LOGGER_DATED_FILELINENO : 0) |
+            (st->bf.function? LOGGER_DATED_FUNCTION : 0) |
+#ifndef CLOGGER_NO_THREADNO
+            (st->bf.processid? LOGGER_DATED_PROCESSID : 0) |
+            (st->bf.threadno? LOGGER_DATED_THREADNO : 0) |
 #endif
+            (st->bf.autowrapline? LOGGER_DATED_AUTOWRAPLINE : 0) |
+            (st->bf.hideident? LOGGER_DATED_HIDEIDENT : 0) |
+            (logger->priorityring? LOGGER_DATED_SEQUENCE : 0);
+
+    opts->dateformat = st->dateformat;
+    opts->kvformat = st->kvformat;
+
+    opts->tzfmt = TIMEZONE_FORMAT_UTC;
+    opts->timezone = 0;
+    opts->daylight = 0;
+    if (st->bf.loctime) {
+        opts->timezone = rtclock_timezone(logger->rtc, &opts->tzfmt);
+        opts->daylight = rtclock_daylight(logger->rtc);
+    }
+    opts->tzfmtlen = cstr_length(opts->tzfmt, 16);
 
-    logger->maxmsgsize = conf->maxmsgsize;
-    logger->ident = cstrbufDup(0, conf->ident->str, conf->ident->len);
+    /* timezone may be changed */
+    logger->calsecond = -1;
+    logger->calminute = -1;
 
-    logger->mempool = ringbuf_init(conf->maxconcurrents);
-    while (conf->maxconcurrents-- > 0) {
-        ringbuf_elt_t *eltp;
-        ringbuf_elt_new(conf->maxmsgsize, mem_free, &eltp);
-        if (ringbuf_push(logger->mempool, eltp) != 1) {
-            ringbuf_elt_free(eltp);
+    clog_logger_apply_rolling(logger, st, &logger->logfile);
+
+    for (i = 0; i < logger->numroutes; i++) {
+        clog_logger_apply_rolling(logger, st, &logger->routes[i].logfile);
+    }
+
+    logger->applied = st;
+}
+
+
+/**
+ * handler of fatal signals only: lines rendered by callers are written to
+ *  logfiles opened by logthread without locks. records of other kinds are
+ *  left in flight recorder for next process.
+ */
+static int clog_logger_fatal_flush_cb (const ringbuf_entry_st *entry, void *arg)
+{
+    clog_logger logger = (clog_logger) arg;
+
+    const clog_message_hdr *msghdr = (const clog_message_hdr *) entry->chunk;
+    const clog_logger_settings *st = logger->applied;
+
+    ub4 levelbit, msglen;
+    int i;
+
+    if (msghdr->kind == CLOG_MSGKIND_SPILL) {
+        const clog_message_spill *spill = (const clog_message_spill *) msghdr->message;
+
+        if (spill->epoch != logger->spillepoch) {
+            return 1;
         }
+        msghdr = spill->chunk;
     }
 
-    logger->ringbuffer = ringbufst_init(conf->queuelength, conf->maxmsgsize);
+    levelbit = (1U << msghdr->level);
+    msglen = (ub4)(msghdr->offsetcb - sizeof(*msghdr));
 
-    if (logger->bf.appenderrofile) {
-        namepatternRep = clog_replace_string(cstrbufGetStr(conf->nameprefix), 3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
-        pathprefixRep = clog_replace_string(cstrbufGetStr(conf->pathprefix),   3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+    if (msghdr->kind != CLOG_MSGKIND_TEXT || logger->bf.rawtimestamp) {
+        return 0;
+    }
 
-        rollingfile_init(&logger->logfile, cstrbufGetStr(pathprefixRep), cstrbufGetStr(namepatternRep));
+    if (msghdr->level <= st->rofilelevel && !(st->routeonly && (logger->routedlevels & levelbit))) {
+        if (logger->logfile.fhlogging == filehandle_invalid) {
+            return 0;
+        }
+        file_writebytes(logger->logfile.fhlogging, msghdr->message, msglen);
     }
 
-    if (logger->bf.appendershmlog) {
-        int err;
-        md5sum_t ctx;
+    if (logger->routedlevels & levelbit) {
+        for (i = 0; i < logger->numroutes; i++) {
+            if ((logger->routes[i].levels & levelbit) && logger->routes[i].logfile.fhlogging != filehandle_invalid) {
+                file_writebytes(logger->routes[i].logfile.fhlogging, msghdr->message, msglen);
+            }
+        }
+    }
 
-        shmlogfileRep = clog_replace_string(cstrbufGetStr(conf->shmlogfile), 3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+    return 1;
+}
 
-        md5sum_init(&ctx, conf->magickey);
-        md5sum_update(&ctx, (const uint8_t *) shmlogfileRep->str, shmlogfileRep->len);
-        md5sum_done(&ctx);
 
-        err = shmmaplog_init(cstrbufGetStr(pathprefixRep), cstrbufGetStr(shmlogfileRep), (conf->maxmsgsize * conf->queuelength), ctx.digest, &logger->shmlog);
-        if (err) {
-            mem_free(logger);
-            emerglog_exit("libclogger", "shmmaplog_init error(%d)", err);
+static void clog_logger_fatal_flush (void)
+{
+    int i;
+
+    for (i = 0; i < CLOG_FLIGHT_LOGGERS_MAX; i++) {
+        clog_logger logger = (clog_logger) uatomic_ptr_load_acq(&clog_flight_loggers[i]);
+
+        if (logger && logger->applied && logger->bf.appenderrofile) {
+            if (logger->priorityring) {
+                while (ringbufst_read_next(logger->priorityring, clog_logger_fatal_flush_cb, logger) == 1);
+            }
+            while (ringbufst_read_next(logger->ringbuffer, clog_logger_fatal_flush_cb, logger) == 1);
         }
     }
+}
 
-    cstrbufFree(&namepatternRep);
-    cstrbufFree(&pathprefixRep);
-    cstrbufFree(&shmlogfileRep);
 
-    if (unsema_init(&logger->sema, 0) != 0) {
-        emerglog_exit("libclogger", "unsema_init error(%d)", errno);
+/**
+ * logthread only: messages read before are written out to appenders, and
+ *  callers waiting for flushseq are released.
+ */
+static void clog_logger_flush_ack (clog_logger logger, int64_t flushseq)
+{
+    if (logger->binwriter) {
+        logger_bin_writer_flush(logger->binwriter);
     }
 
-    if (pthread_mutex_init(&logger->shutdownlock, NULL) == -1) {
-        emerglog_exit("libclogger", "pthread_mutex_init failed");
+    if (logger->applied) {
+        clog_logger_repeated_flush(logger, logger->applied);
     }
 
-    if (pthread_mutex_lock(&logger->shutdownlock) != 0) {
-        emerglog_exit("libclogger", "pthread_mutex_lock failed");
+    if (! logger->stdoutsink) {
+        fflush(stdout);
     }
 
-    /* set default colors and styles */
-    clog_set_levelcolor(logger, CLOG_LEVEL_FATAL, CLOG_COLOR_RED);
-    clog_set_levelcolor(logger, CLOG_LEVEL_ERROR, CLOG_COLOR_PURPLE);
-    clog_set_levelcolor(logger, CLOG_LEVEL_WARN,  CLOG_COLOR_YELLOW);
-    clog_set_levelcolor(logger, CLOG_LEVEL_INFO,  CLOG_COLOR_CYAN);
-    clog_set_levelcolor(logger, CLOG_LEVEL_DEBUG, CLOG_COLOR_GREEN);
-    clog_set_levelcolor(logger, CLOG_LEVEL_TRACE, CLOG_COLOR_NOCLR);
+    pthread_mutex_lock(&logger->flushlock);
+    logger->flushack = flushseq;
+    pthread_cond_broadcast(&logger->flushcond);
+    pthread_mutex_unlock(&logger->flushlock);
+}
+
 
-    clog_set_levelstyle(logger, CLOG_LEVEL_FATAL, CLOG_STYLE_LIGHT);
-    clog_set_levelstyle(logger, CLOG_LEVEL_ERROR, CLOG_STYLE_LIGHT);
-    clog_set_levelstyle(logger, CLOG_LEVEL_WARN,  CLOG_STYLE_LIGHT);
-    clog_set_levelstyle(logger, CLOG_LEVEL_INFO,  CLOG_STYLE_NORMAL);
-    clog_set_levelstyle(logger, CLOG_LEVEL_DEBUG, CLOG_STYLE_NORMAL);
-    clog_set_levelstyle(logger, CLOG_LEVEL_TRACE, CLOG_STYLE_NORMAL);
+/* logthread only: wake callers parked by logger_wait_write after room freed */
+static void clog_logger_unpark (clog_logger logger)
+{
+    if (uatomic_int_get(&logger->parked)) {
+        pthread_mutex_lock(&logger->parklock);
+        pthread_cond_broadcast(&logger->parkcond);
+        pthread_mutex_unlock(&logger->parklock);
+    }
+}
 
-    rollingfile_t * rof = &(logger->logfile);
 
-    rollingfile_set_timepolicy(rof, conf->rollingtime);
-    rollingfile_set_sizepolicy(rof, conf->maxfilesize, conf->maxfilecount, conf->rollingappend);
+static int64_t clog_elapsed_usec (const struct timespec *since)
+{
+    struct timespec now;
+    getnowtimeofday(&now);
+    return (int64_t)(now.tv_sec - since->tv_sec) * 1000000 + (now.tv_nsec - since->tv_nsec) / 1000;
+}
 
-    /* copy config for logger */
-    logger->level = conf->loglevel;
-    logger->layout = conf->layout;
-    logger->dateformat = conf->dateformat;
 
-    if (logger->bf.appendersyslog) {
-#if defined(__WINDOWS__)
-        if (conf->winsyslogconf) {
-            /* default: "localhost:514" */
-            set_syslog_conf_dir(cstrbufGetStr(conf->winsyslogconf));
+/**
+ * logthread only: read all messages until no message or maxus elapsed
+ *  (no limit if maxus < 0). callers parked for room are woken every time
+ *  ROffset advances past watermark entries. priorityring is read first: up
+ *  to priorityweight messages of it for one message of ringbuffer. returns
+ *  number of messages read.
+ */
+static int clog_logger_drain (clog_logger logger, int64_t maxus)
+{
+    int watermark = logger->queuelength / CLOG_WAIT_WATERMARKS;
+    int reads = 0, total = 0;
+    struct timespec start;
+
+    if (maxus >= 0) {
+        getnowtimeofday(&start);
+    }
+
+    if (watermark < 1) {
+        watermark = 1;
+    }
+
+    for (;;) {
+        int i = 0;
+
+        if (logger->priorityring) {
+            while (i < logger->priorityweight && ringbufst_read_next(logger->priorityring, read_message_cb, logger) > 0) {
+                i++;
+            }
+        }
+
+        if (ringbufst_read_next(logger->ringbuffer, read_message_cb, logger) > 0) {
+            i++;
+        } else if (! i) {
+            break;
+        }
+
+        reads += i;
+        total += i;
+        if (reads >= watermark) {
+            reads = 0;
+            clog_logger_unpark(logger);
+
+            if (maxus >= 0 && clog_elapsed_usec(&start) >= maxus) {
+                break;
+            }
         }
-#endif
-        openlog(logger->ident->str, LOG_PID | LOG_NDELAY | LOG_NOWAIT, 0);
     }
 
-    /* success */
-    logger->loggerid = conf->loggerid;
-    logger_conf_final_release(conf);
+    clog_logger_unpark(logger);
 
-    /* start running logthread */
-    if (pthread_create(&logger->logthread, NULL, clog_threadfunc, (void*)logger) == -1) {
-        emerglog_exit("libclogger", "pthread_create failed");
+    return total;
+}
+
+
+/**
+ * logthread only: give back pages of empty rings. returns 0 to try again
+ *  if a ring is not empty or locked by caller.
+ */
+static int clog_logger_reclaim (clog_logger logger)
+{
+    int ok = 1;
+
+    if (ringbufst_reclaim(logger->ringbuffer) == 0 &&
+        ringbufst_resident(logger->ringbuffer) > RINGBUFST_PAGE_SIZE * 2) {
+        ok = 0;
     }
 
-    return logger;
+    if (logger->priorityring && ringbufst_reclaim(logger->priorityring) == 0 &&
+        ringbufst_resident(logger->priorityring) > RINGBUFST_PAGE_SIZE * 2) {
+        ok = 0;
+    }
+
+    return ok;
 }
 
 
-void clog_logger_destroy(clog_logger logger)
-{
-    pthread_mutex_unlock(&logger->shutdownlock);
-    unsema_post(&logger->sema);
-    pthread_join(logger->logthread, NULL);
-    unsema_uninit(&logger->sema);
-    cstrbufFree(&logger->ident);
-    rollingfile_uninit(&logger->logfile);
-    shmmaplog_uninit(logger->shmlog);
-    if (logger->bf.appendersyslog) {
-        closelog();
+static void * clog_threadfunc (void *arg)
+{
+    clog_logger logger = (clog_logger) arg;
+
+    time_t binflushsec = 0;
+    time_t ctlsec = 0;
+
+    /* last time messages read and if pages of rings given back since */
+    time_t readsec = time(NULL);
+    int reclaimed = 0;
+
+    while (pthread_mutex_trylock(&logger->shutdownlock) != 0) {
+        if (unsema_timedwait(&logger->sema, 1000) == 0) {
+            /* messages put before flush requested are in ringbuffer now */
+            int64_t flushseq = uatomic_int64_get(&logger->flushseq);
+
+            const clog_logger_settings *st = clog_logger_settings_get(logger);
+            if (st != logger->applied) {
+                clog_logger_apply_settings(logger, st);
+            }
+
+            /* bugfix(2025-02-13):
+             *   old: ringbufst_read_next(logger->ringbuffer, read_message_cb, logger);
+             * read all messages until no message(=0)
+             */
+            if (clog_logger_drain(logger, -1) && logger->ringreclaim) {
+                readsec = time(NULL);
+                reclaimed = 0;
+            }
+
+            if (flushseq != logger->flushack) {
+                clog_logger_flush_ack(logger, flushseq);
+            }
+        }
+
+        if (logger->binwriter) {
+            /* partial block is written out once a second at most */
+            struct timespec now;
+            getnowtimeofday(&now);
+
+            if (now.tv_sec != binflushsec) {
+                binflushsec = now.tv_sec;
+                logger_bin_writer_flush(logger->binwriter);
+            }
+        }
+
+        if (logger->dup.count) {
+            /* duplicates counted are reported when window is over */
+            const clog_logger_settings *st = logger->applied;
+            struct timespec now;
+            getnowtimeofday(&now);
+
+            if (! st->coalesce || (ub8) now.tv_sec * 1000000000ULL + now.tv_nsec - logger->dup.startts >= (ub8) st->coalesce * 1000000000ULL) {
+                clog_logger_repeated_flush(logger, st);
+                logger->dup.len = 0;
+            }
+        }
+
+        if (logger->ringreclaim && ! reclaimed && time(NULL) - readsec >= logger->ringreclaim) {
+            /* idle logger keeps only pages of headers */
+            reclaimed = clog_logger_reclaim(logger);
+        }
+
+        if (logger->ctl) {
+            /* stats and expired controls once a second */
+            time_t now = time(NULL);
+
+            if (now != ctlsec) {
+                ctlsec = now;
+
+                logger->ctl->messages = uatomic_int64_get(&logger->logmessages);
+                logger->ctl->dropped = uatomic_int64_get(&logger->dropped);
+                logger->ctl->ringresident = (int64_t) ringbufst_resident(logger->ringbuffer) +
+                        (logger->priorityring? (int64_t) ringbufst_resident(logger->priorityring) : 0);
+                logger->ctl->updated = (int64_t) now;
+
+                loggerctl_sweep(logger->ctlpage, logger->ctl, (int64_t) now);
+            }
+
+            /* follow controls set by cloggerctl */
+            clog_logger_follow_ctl(logger);
+        }
+
+        /* settings published while no message came are applied too */
+        if (clog_logger_settings_get(logger) != logger->applied) {
+            clog_logger_apply_settings(logger, clog_logger_settings_get(logger));
+        }
+        clog_logger_settings_reclaim(logger);
+    }
+
+    /* messages left by callers before destroy are not lost. no more come
+     *  since shutdown is set, but appenders might be too slow to take them.
+     */
+    if (clog_logger_settings_get(logger) != logger->applied) {
+        clog_logger_apply_settings(logger, clog_logger_settings_get(logger));
+    }
+    clog_logger_drain(logger, CLOG_SHUTDOWN_DRAINUS);
+
+    clog_logger_flush_ack(logger, uatomic_int64_get(&logger->flushseq));
+
+    pthread_mutex_destroy(&logger->shutdownlock);
+    return (void*) 0;
+}
+
+
+/**
+ * public helper api
+ */
+void clog_set_levelcolor(clog_logger logger, clog_level_t level, clog_color_t color)
+{
+    clog_logger_settings *st;
+
+    pthread_mutex_lock(&logger->settingslock);
+    st = clog_logger_settings_dup(clog_logger_settings_get(logger));
+    st->levelcolors[ level ] = color;
+    clog_logger_settings_publish(logger, st);
+    pthread_mutex_unlock(&logger->settingslock);
+}
+
+
+void clog_set_levelstyle(clog_logger logger, clog_level_t level, clog_style_t style)
+{
+    clog_logger_settings *st;
+
+    pthread_mutex_lock(&logger->settingslock);
+    st = clog_logger_settings_dup(clog_logger_settings_get(logger));
+    st->levelstyles[ level ] = style;
+    clog_logger_settings_publish(logger, st);
+    pthread_mutex_unlock(&logger->settingslock);
+}
+
+
+int clog_level_from_string (const char *levelstring, int length, clog_level_t *level)
+{
+    int lvl = cstr_findstr_in(levelstring, length, clog_level_strs, (int)(sizeof(clog_level_strs)/sizeof(clog_level_strs[0])), 1);
+
+    if (lvl != -1) {
+        *level = (clog_level_t) lvl;
+
+        /* success */
+        return 1;
+    }
+
+    /* failed as default */
+    return 0;
+}
+
+
+const char * clog_level_to_string (clog_level_t level, int *length)
+{
+    if (level < CLOG_LEVEL_OFF || level > CLOG_LEVEL_ALL || ! clog_level_strs[level]) {
+        *length = 0;
+        return "";
+    }
+
+    *length = clog_level_lens[level];
+    return clog_level_strs[level];
+}
+
+
+int clog_layout_from_string(const char *layoutstring, int length, clog_layout_t *layout)
+{
+    if (!cstr_compare_len(layoutstring, length, "PLAIN", 5, 1)) {
+        *layout = CLOG_LAYOUT_PLAIN;
+        return 1;
+    }
+
+    if (!cstr_compare_len(layoutstring, length, "DATED", 5, 1)) {
+        *layout = CLOG_LAYOUT_DATED;
+        return 1;
+    }
+
+    if (!cstr_compare_len(layoutstring, length, "JSON", 4, 1)) {
+        *layout = CLOG_LAYOUT_JSON;
+        return 1;
+    }
+
+    if (!cstr_compare_len(layoutstring, length, "BINARY", 6, 1)) {
+        *layout = CLOG_LAYOUT_BINARY;
+        return 1;
+    }
+
+    /* failed as default */
+    return 0;
+}
+
+
+int clog_kvformat_from_string(const char *kvfmtstring, int length, clog_kvformat_t *kvformat)
+{
+    if (!cstr_compare_len(kvfmtstring, length, "LOGFMT", 6, 1)) {
+        *kvformat = CLOG_KVFORMAT_LOGFMT;
+        return 1;
+    }
+
+    if (!cstr_compare_len(kvfmtstring, length, "JSON", 4, 1)) {
+        *kvformat = CLOG_KVFORMAT_JSON;
+        return 1;
+    }
+
+    /* failed as default */
+    return 0;
+}
+
+
+int clog_clocksource_from_string(const char *clksrcstring, int length, clog_clocksource_t *clocksource)
+{
+    if (!cstr_compare_len(clksrcstring, length, "REALTIME", 8, 1)) {
+        *clocksource = CLOG_CLOCKSOURCE_REALTIME;
+        return 1;
+    }
+
+    if (!cstr_compare_len(clksrcstring, length, "COARSE", 6, 1)) {
+        *clocksource = CLOG_CLOCKSOURCE_COARSE;
+        return 1;
+    }
+
+    if (!cstr_compare_len(clksrcstring, length, "TSC", 3, 1)) {
+        *clocksource = CLOG_CLOCKSOURCE_TSC;
+        return 1;
+    }
+
+    if (!cstr_compare_len(clksrcstring, length, "RTCLOCK", 7, 1)) {
+        *clocksource = CLOG_CLOCKSOURCE_RTCLOCK;
+        return 1;
+    }
+
+    /* failed as default */
+    return 0;
+}
+
+
+int clog_dateformat_from_string(const char *datefmtstring, int length, clog_dateformat_t *dateformat)
+{
+    if (!cstr_compare_len(datefmtstring, length, "UTC", 3, 1)) {
+        *dateformat = CLOG_DATEFMT_UNIVERSAL;
+        return 1;
+    }
+    if (!cstr_compare_len(datefmtstring, length, "UNIVERSAL", 9, 1)) {
+        *dateformat = CLOG_DATEFMT_UNIVERSAL;
+        return 1;
+    }
+
+    if (!cstr_compare_len(datefmtstring, length, "NUMERIC-1", 9, 1)) {
+        *dateformat = CLOG_DATEFMT_NUMERIC_1;
+        return 1;
+    }
+    if (!cstr_compare_len(datefmtstring, length, "NUMERIC", 7, 1)) {
+        *dateformat = CLOG_DATEFMT_NUMERIC_1;
+        return 1;
+    }
+
+    if (!cstr_compare_len(datefmtstring, length, "NUMERIC-2", 9, 1)) {
+        *dateformat = CLOG_DATEFMT_NUMERIC_2;
+        return 1;
+    }
+
+    if (!cstr_compare_len(datefmtstring, length, "RFC-3339", 8, 1)) {
+        *dateformat = CLOG_DATEFMT_RFC_3339;
+        return 1;
+    }
+    if (!cstr_compare_len(datefmtstring, length, "DEFAULT", 7, 1)) {
+        *dateformat = CLOG_DATEFMT_RFC_3339;
+        return 1;
+    }
+
+    if (!cstr_compare_len(datefmtstring, length, "ISO-8601", 8, 1)) {
+        *dateformat = CLOG_DATEFMT_ISO_8601;
+        return 1;
+    }
+
+    if (!cstr_compare_len(datefmtstring, length, "RFC-2822", 8, 1)) {
+        *dateformat = CLOG_DATEFMT_RFC_2822;
+        return 1;
+    }
+
+    /* failed as default */
+    return 0;
+}
+
+
+int clog_appender_from_string (const char *appenderstring, int length, int *appender)
+{
+    int appenders = 0;
+
+    cstrbuf apstr = cstrbufNew(0, appenderstring, length);
+    cstr_toupper(apstr->str, apstr->len);
+
+    if (cstr_containwith(apstr->str, apstr->len, "STDOUT", 6) != -1) {
+        appenders |= CLOG_APPENDER_STDOUT;
+    }
+    if (cstr_containwith(apstr->str, apstr->len, "ROFILE", 6) != -1) {
+        appenders |= CLOG_APPENDER_ROFILE;
+    }
+    if (cstr_containwith(apstr->str, apstr->len, "SYSLOG", 6) != -1) {
+        appenders |= CLOG_APPENDER_SYSLOG;
+    }
+    if (cstr_containwith(apstr->str, apstr->len, "SHMLOG", 6) != -1) {
+        appenders |= CLOG_APPENDER_SHMMAP;
+    }
+    if (cstr_containwith(apstr->str, apstr->len, "BINFILE", 7) != -1) {
+        appenders |= CLOG_APPENDER_BINFILE;
+    }
+
+    if (!appenders) {
+        /* failed as default */
+        cstrbufFree(&apstr);
+        return 0;
+    }
+
+    *appender = appenders;
+    cstrbufFree(&apstr);
+    return 1;
+}
+
+
+/* new settings from conf. colors and styles are copied from old settings */
+static clog_logger_settings * clog_logger_settings_new (clogger_conf conf, const clog_logger_settings *from)
+{
+    ub4 flags = (int) logger_conf_get_creatflags(conf);
+
+    clog_logger_settings *st = (clog_logger_settings *) mem_alloc_zero(1, sizeof(*st));
+
+    if (CLOG_TIMEUNIT_MSEC & flags) {
+        st->bf.timeunitms = 1;
+        st->bf.timeunitus = 0;
+    }
+    if (CLOG_TIMEUNIT_USEC & flags) {
+        st->bf.timeunitms = 0;
+        st->bf.timeunitus = 1;
+    }
+    if (CLOG_TIMESTAMP_ID & flags) {
+        st->bf.timestampid = 1;
+    }
+
+    if (CLOG_TIMEZONE_LOC & flags) {
+        st->bf.loctime = 1;
+    }
+
+    if (CLOG_ROLLING_SIZE_BASED & flags) {
+        st->bf.rollingsize = 1;
+    }
+    if (CLOG_ROLLING_TIME_BASED & flags) {
+        st->bf.rollingtime = 1;
+    }
+
+    if (CLOG_APPENDER_STDOUT & flags) {
+        st->bf.appenderstdout = 1;
+    }
+    if (CLOG_APPENDER_SYSLOG & flags) {
+        st->bf.appendersyslog = 1;
+    }
+    if (CLOG_APPENDER_ROFILE & flags) {
+        st->bf.appenderrofile = 1;
+    }
+    if (CLOG_APPENDER_SHMMAP & flags) {
+        st->bf.appendershmlog = 1;
+    }
+    if (CLOG_APPENDER_BINFILE & flags) {
+        /* BINFILE takes over rolling file from ROFILE */
+        st->bf.appenderrofile = 0;
+    }
+
+    if (CLOG_LEVEL_COLORS & flags) {
+        st->bf.levelcolors = 1;
+    }
+    if (CLOG_LEVEL_STYLES & flags) {
+        st->bf.levelstyles = 1;
+    }
+
+    if (CLOG_FILE_LINENO & flags) {
+        st->bf.filelineno = 1;
+    }
+    if (CLOG_FUNCTION_NAME & flags) {
+        st->bf.function = 1;
+    }
+
+    if (conf->autowrapline) {
+        st->bf.autowrapline = 1;
+    }
+
+    if (conf->hideident) {
+        st->bf.hideident = 1;
+    }
+
+#ifndef CLOGGER_NO_THREADNO
+    if (conf->processid) {
+        st->bf.processid = 1;
+    }
+
+    if (conf->threadno) {
+        st->bf.threadno = 1;
+    }
+#endif
+
+    st->level = conf->loglevel;
+    st->dateformat = conf->dateformat;
+    st->kvformat = conf->kvformat;
+
+    st->rollingtime = conf->rollingtime;
+    st->maxfilesize = conf->maxfilesize;
+    st->maxfilecount = conf->maxfilecount;
+    st->rollingappend = conf->rollingappend;
+
+    st->ratepolicy = conf->ratepolicy;
+    st->coalesce = conf->coalesce;
+
+    st->stdoutlevel = conf->stdoutlevel;
+    st->sysloglevel = conf->sysloglevel;
+    st->rofilelevel = conf->rofilelevel;
+    st->shmloglevel = conf->shmloglevel;
+    st->routeonly = conf->routeonly;
+
+    /* records are rendered as DATED by logthread */
+    if (conf->layout == CLOG_LAYOUT_DATED || conf->layout == CLOG_LAYOUT_BINARY || (CLOG_APPENDER_BINFILE & flags)) {
+        st->backtrace = conf->backtrace;
+        st->backtracems = conf->backtracems;
+        st->backtracelevel = conf->backtracelevel;
+    }
+
+    if (from) {
+        memcpy(st->levelcolors, from->levelcolors, sizeof(st->levelcolors));
+        memcpy(st->levelstyles, from->levelstyles, sizeof(st->levelstyles));
+    } else {
+        /* set default colors and styles */
+        st->levelcolors[CLOG_LEVEL_FATAL] = CLOG_COLOR_RED;
+        st->levelcolors[CLOG_LEVEL_ERROR] = CLOG_COLOR_PURPLE;
+        st->levelcolors[CLOG_LEVEL_WARN]  = CLOG_COLOR_YELLOW;
+        st->levelcolors[CLOG_LEVEL_INFO]  = CLOG_COLOR_CYAN;
+        st->levelcolors[CLOG_LEVEL_DEBUG] = CLOG_COLOR_GREEN;
+        st->levelcolors[CLOG_LEVEL_TRACE] = CLOG_COLOR_NOCLR;
+
+        st->levelstyles[CLOG_LEVEL_FATAL] = CLOG_STYLE_LIGHT;
+        st->levelstyles[CLOG_LEVEL_ERROR] = CLOG_STYLE_LIGHT;
+        st->levelstyles[CLOG_LEVEL_WARN]  = CLOG_STYLE_LIGHT;
+        st->levelstyles[CLOG_LEVEL_INFO]  = CLOG_STYLE_NORMAL;
+        st->levelstyles[CLOG_LEVEL_DEBUG] = CLOG_STYLE_NORMAL;
+        st->levelstyles[CLOG_LEVEL_TRACE] = CLOG_STYLE_NORMAL;
+    }
+
+    return st;
+}
+
+
+/**
+ * public api
+ */
+clog_logger clog_logger_create (clogger_conf conf, logger_manager mgr)
+{
+    clog_logger_t *logger;
+
+    struct timespec ts;
+
+    char timestr[22] = {0};
+
+    cstrbuf namepatternRep = 0;
+    cstrbuf pathprefixRep = 0;
+    cstrbuf shmlogfileRep = 0;
+
+    int flightrecovered = 0;
+
+    ub4 flags = (int) logger_conf_get_creatflags(conf);
+
+    CHKCONFIG_INT_VALUE(CLOG_MSGBUF_SIZE_DEFAULT, CLOG_MSGBUF_SIZE_MIN, CLOG_MSGBUF_SIZE_MAX, conf->maxmsgsize);
+
+    CHKCONFIG_INT_VALUE(128, 64, 1024, conf->maxconcurrents);
+    if (conf->maxconcurrents > conf->queuelength) {
+        conf->maxconcurrents = memapi_align_psize(conf->queuelength);
+    }
+
+    getnowtimeofday(&ts);
+    snprintf(timestr, sizeof(timestr), "%"PRId64, (int64_t)ts.tv_sec);
+
+    logger = (clog_logger_t *) mem_alloc_zero(1, sizeof(*logger));
+
+    logger->rtc = mgr->rtclock;
+    logger->btkey = (ub4) uatomic_int_add(&logger_bt_keys);
+
+    logger->pidcstrlen = snprintf(logger->pidcstr, sizeof(logger->pidcstr), "%d", getprocessid());
+
+    if (CLOG_APPENDER_ROFILE & flags) {
+        logger->bf.appenderrofile = 1;
+    }
+    if (CLOG_APPENDER_SHMMAP & flags) {
+        logger->bf.appendershmlog = 1;
+    }
+    if (CLOG_APPENDER_BINFILE & flags) {
+        /* BINFILE takes over rolling file from ROFILE */
+        logger->bf.appenderbinfile = 1;
+        logger->bf.appenderrofile = 0;
+    }
+
+    logger->maxmsgsize = conf->maxmsgsize;
+    logger->queuelength = conf->queuelength;
+
+    if (conf->maxspillsize > conf->maxmsgsize) {
+        logger->maxspillsize = (size_t) conf->maxspillsize;
+        logger->spillepoch = ((ub8) ts.tv_sec * 1000000000ULL + ts.tv_nsec) ^ ((ub8) getprocessid() << 40) ^ (ub8) logger->btkey;
+    }
+    logger->ident = cstrbufDup(0, conf->ident->str, conf->ident->len);
+
+    logger->mempool = ringbuf_init(conf->maxconcurrents);
+    logger->maxconcurrents = conf->maxconcurrents;
+
+    if (conf->flightrecorder) {
+        int recovered = 0;
+        cstrbuf frfileRep = clog_replace_string(cstrbufGetStr(conf->flightrecorder), 1, "<IDENT>", cstrbufGetStr(logger->ident));
+
+        logger->flightrecorder = cstrbufDup(0, conf->flightrecorder->str, conf->flightrecorder->len);
+        logger->ringbuffer = logger_fr_open(cstrbufGetStr(frfileRep), conf->queuelength, conf->maxmsgsize, conf->magickey, &recovered, &logger->flightfd);
+
+        if (logger->ringbuffer) {
+            logger->bf.flightrecorder = 1;
+            if (recovered) {
+                printf("(%s:%d) messages of last process recovered from flight recorder: %s\n", THIS_FILE, __LINE__, cstrbufGetStr(frfileRep));
+
+                /* logthread takes them first */
+                flightrecovered = 1;
+            }
+        } else if (errno == EWOULDBLOCK) {
+            printf("(%s:%d) flight recorder in use by other logger or process: %s\n", THIS_FILE, __LINE__, cstrbufGetStr(frfileRep));
+        } else {
+            printf("(%s:%d) flight recorder not mapped (errno=%d): %s\n", THIS_FILE, __LINE__, errno, cstrbufGetStr(frfileRep));
+        }
+
+        cstrbufFree(&frfileRep);
+    }
+
+    if (! logger->ringbuffer) {
+        /* pages are touched when used first (ringmemory) */
+        logger->ringbuffer = ringbufst_init_map(conf->queuelength, conf->maxmsgsize, conf->ringmemory);
+        if (! logger->ringbuffer) {
+            emerglog_exit("libclogger", "ringbufst_init_map failed(%d)", errno);
+        }
+    }
+
+    if (conf->prioritylane) {
+        /* not in flight recorder: fatal signals flush it to ROFILE */
+        logger->priorityring = ringbufst_init_map(conf->prioritylane, conf->maxmsgsize, conf->ringmemory);
+        if (! logger->priorityring) {
+            emerglog_exit("libclogger", "ringbufst_init_map failed(%d)", errno);
+        }
+        logger->priorityweight = conf->priorityweight;
+    }
+
+    if (! (conf->ringmemory & RINGBUFST_MAP_HUGEPAGE)) {
+        logger->ringreclaim = conf->ringreclaim;
+    }
+
+    /* rendered KV text may be longer than encoded fields due to escaping */
+    logger->renderbufsz = conf->maxmsgsize * 2;
+    logger->renderbuf = (char *) mem_alloc_unset(logger->renderbufsz);
+
+    if (logger->bf.appenderrofile || logger->bf.appenderbinfile) {
+        namepatternRep = clog_replace_string(cstrbufGetStr(conf->nameprefix), 3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+        pathprefixRep = clog_replace_string(cstrbufGetStr(conf->pathprefix),   3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+
+        rollingfile_init(&logger->logfile, cstrbufGetStr(pathprefixRep), cstrbufGetStr(namepatternRep));
+    }
+
+    if (logger->bf.appenderrofile) {
+        /* files of routes are in path of logfile */
+        for (; logger->numroutes < conf->numroutes; logger->numroutes++) {
+            cstrbuf routenameRep = clog_replace_string(cstrbufGetStr(conf->routes[logger->numroutes].nameprefix), 3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+
+            logger->routes[logger->numroutes].levels = conf->routes[logger->numroutes].levels;
+            logger->routes[logger->numroutes].nameprefix = cstrbufDup(0, conf->routes[logger->numroutes].nameprefix->str, conf->routes[logger->numroutes].nameprefix->len);
+            logger->routedlevels |= conf->routes[logger->numroutes].levels;
+
+            rollingfile_init(&logger->routes[logger->numroutes].logfile, cstrbufGetStr(pathprefixRep), cstrbufGetStr(routenameRep));
+
+            cstrbufFree(&routenameRep);
+        }
+    }
+
+    if (logger->bf.appendershmlog) {
+        int err;
+        md5sum_t ctx;
+
+        shmlogfileRep = clog_replace_string(cstrbufGetStr(conf->shmlogfile), 3, "<IDENT>", cstrbufGetStr(logger->ident), "<PID>", logger->pidcstr, "<DATE>", timestr);
+
+        md5sum_init(&ctx, conf->magickey);
+        md5sum_update(&ctx, (const uint8_t *) shmlogfileRep->str, shmlogfileRep->len);
+        md5sum_done(&ctx);
+
+        err = shmmaplog_init(cstrbufGetStr(pathprefixRep), cstrbufGetStr(shmlogfileRep), (conf->maxmsgsize * conf->queuelength), ctx.digest, &logger->shmlog);
+        if (err) {
+            mem_free(logger);
+            emerglog_exit("libclogger", "shmmaplog_init error(%d)", err);
+        }
+    }
+
+    cstrbufFree(&namepatternRep);
+    cstrbufFree(&pathprefixRep);
+    cstrbufFree(&shmlogfileRep);
+
+    if (unsema_init(&logger->sema, 0) != 0) {
+        emerglog_exit("libclogger", "unsema_init error(%d)", errno);
+    }
+
+    if (pthread_mutex_init(&logger->shutdownlock, NULL) == -1) {
+        emerglog_exit("libclogger", "pthread_mutex_init failed");
+    }
+
+    if (pthread_mutex_lock(&logger->shutdownlock) != 0) {
+        emerglog_exit("libclogger", "pthread_mutex_lock failed");
+    }
+
+    if (pthread_mutex_init(&logger->settingslock, NULL) == -1) {
+        emerglog_exit("libclogger", "pthread_mutex_init failed");
+    }
+
+    if (pthread_mutex_init(&logger->flushlock, NULL) == -1 || pthread_cond_init(&logger->flushcond, NULL) == -1) {
+        emerglog_exit("libclogger", "pthread_cond_init failed");
+    }
+
+    if (pthread_mutex_init(&logger->parklock, NULL) == -1 || pthread_cond_init(&logger->parkcond, NULL) == -1) {
+        emerglog_exit("libclogger", "pthread_cond_init failed");
+    }
+
+    clog_logger_settings_publish(logger, clog_logger_settings_new(conf, NULL));
+
+    /* copy config for logger */
+    logger->layout = conf->layout;
+
+    logger->clocksource = rtclock_source_check(logger->rtc, (rtclock_source_t) conf->clocksource);
+    if (logger->clocksource == RTCLOCK_SOURCE_RTCLOCK) {
+        /* published time is as accurate as tick of rtclock */
+        rtclock_set_frequency(logger->rtc, RTCLOCK_FREQ_MSEC);
+    }
+
+    if (logger->bf.appenderbinfile) {
+        logger->layout = CLOG_LAYOUT_BINARY;
+    }
+
+    /* rawtimestamp is formatted by logthread for DATED and JSON */
+    if (conf->rawtimestamp && (logger->layout == CLOG_LAYOUT_DATED || logger->layout == CLOG_LAYOUT_JSON)) {
+        logger->bf.rawtimestamp = 1;
+    }
+
+    /* logthread converts timestamp of message with options */
+    do {
+        logger_dated_opts *opts = &logger->datedopts;
+
+        opts->identlen = logger->ident->len;
+        opts->ident = logger->ident->str;
+        opts->pidcstrlen = logger->pidcstrlen;
+        opts->pidcstr = logger->pidcstr;
+
+        clog_logger_apply_settings(logger, clog_logger_settings_get(logger));
+
+        if (logger->bf.appenderbinfile) {
+            int blocksize = conf->binblocksize;
+
+            CHKCONFIG_INT_VALUE(LOGGER_BIN_BLOCKSIZE_DEFAULT, LOGGER_BIN_BLOCKSIZE_MIN, LOGGER_BIN_BLOCKSIZE_MAX, blocksize);
+            if (blocksize < conf->maxmsgsize * 2) {
+                blocksize = conf->maxmsgsize * 2;
+            }
+
+            logger->binwriter = logger_bin_writer_create(opts, (size_t) blocksize, (size_t) conf->maxmsgsize, write_binblock_cb, logger);
+        }
+    } while(0);
+
+    if (clog_logger_settings_get(logger)->bf.appendersyslog) {
+#if defined(__WINDOWS__)
+        if (conf->winsyslogconf) {
+            /* default: "localhost:514" */
+            set_syslog_conf_dir(cstrbufGetStr(conf->winsyslogconf));
+        }
+#endif
+        openlog(logger->ident->str, LOG_PID | LOG_NDELAY | LOG_NOWAIT, 0);
+        logger->syslogopen = 1;
+    }
+
+    if (conf->appenderqueue) {
+        /* sinks of other processes may block: written out by own workers */
+        if (clog_logger_settings_get(logger)->bf.appenderstdout) {
+            logger->stdoutsink = logger_sink_create(conf->appenderqueue, conf->maxmsgsize, clog_stdout_write, clog_stdout_idle, logger);
+        }
+        if (clog_logger_settings_get(logger)->bf.appendersyslog) {
+            logger->syslogsink = logger_sink_create(conf->appenderqueue, conf->maxmsgsize, clog_syslog_write, NULL, logger);
+        }
+    }
+
+    if (mgr->ctl) {
+        logger->ctl = loggerctl_attach(mgr->ctl, conf->loggerid, logger->ident->str);
+        logger->ctlpage = loggerctl_get_page(mgr->ctl);
+
+        clog_logger_update_gate(logger);
+    }
+
+    /* success */
+    logger->loggerid = conf->loggerid;
+    logger_conf_final_release(conf);
+
+    /* start running logthread */
+    if (pthread_create(&logger->logthread, NULL, clog_threadfunc, (void*)logger) == -1) {
+        emerglog_exit("libclogger", "pthread_create failed");
+    }
+
+    logger->flightslot = -1;
+
+    if (logger->bf.flightrecorder) {
+        int i, slot;
+
+        for (i = 0; i < CLOG_FLIGHT_LOGGERS_MAX; i++) {
+            slot = (logger->loggerid + i) % CLOG_FLIGHT_LOGGERS_MAX;
+            if (uatomic_ptr_comp_exch(&clog_flight_loggers[slot], NULL, logger) == NULL) {
+                logger->flightslot = slot;
+                break;
+            }
+        }
+
+        if (logger->flightslot == -1) {
+            /* messages are still kept in flight recorder file, but not flushed on fatal signals */
+            printf("(%s:%d) flight recorder not flushed on fatal signals: more than %d loggers with it.\n", THIS_FILE, __LINE__, CLOG_FLIGHT_LOGGERS_MAX);
+        } else if (uatomic_int_add(&clog_flight_count) == 1) {
+            logger_fr_catch_signals(clog_logger_fatal_flush);
+        }
+
+        if (flightrecovered) {
+            /* messages of last process are logged before any new one */
+            unsema_post(&logger->sema);
+        }
+    }
+
+    return logger;
+}
+
+
+void clog_logger_destroy(clog_logger logger)
+{
+    if (logger->flightslot != -1) {
+        uatomic_ptr_store_rel(&clog_flight_loggers[logger->flightslot], NULL);
+        if (uatomic_int_sub(&clog_flight_count) == 0) {
+            logger_fr_release_signals();
+        }
+    }
+
+    /* callers waiting for room give up and no message is taken */
+    uatomic_int_set(&logger->shutdown, 1);
+
+    pthread_mutex_unlock(&logger->shutdownlock);
+    unsema_post(&logger->sema);
+    pthread_join(logger->logthread, NULL);
+    unsema_uninit(&logger->sema);
+    if (logger->stdoutsink) {
+        logger_sink_free(logger->stdoutsink);
+    }
+    if (logger->syslogsink) {
+        logger_sink_free(logger->syslogsink);
+    }
+    logger_bin_writer_free(logger->binwriter);
+    cstrbufFree(&logger->ident);
+    rollingfile_uninit(&logger->logfile);
+    while (logger->numroutes-- > 0) {
+        rollingfile_uninit(&logger->routes[logger->numroutes].logfile);
+        cstrbufFree(&logger->routes[logger->numroutes].nameprefix);
+    }
+    shmmaplog_uninit(logger->shmlog);
+    if (logger->syslogopen) {
+        closelog();
+    }
+    if (logger->bf.flightrecorder) {
+        logger_fr_close(logger->ringbuffer, logger->flightfd);
+    } else {
+        ringbufst_uninit_map(logger->ringbuffer);
+    }
+
+    if (logger->priorityring) {
+        ringbufst_uninit_map(logger->priorityring);
+    }
+    cstrbufFree(&logger->flightrecorder);
+    ringbuf_uninit(logger->mempool);
+    mem_free(logger->renderbuf);
+    mem_free(logger->dup.buf);
+    logger_rate_free((logger_rate_hdl) logger->rates);
+    pthread_mutex_destroy(&logger->settingslock);
+    pthread_cond_destroy(&logger->flushcond);
+    pthread_mutex_destroy(&logger->flushlock);
+    pthread_cond_destroy(&logger->parkcond);
+    pthread_mutex_destroy(&logger->parklock);
+    while (logger->settings) {
+        clog_logger_settings *st = (clog_logger_settings *) logger->settings;
+        logger->settings = st->retired;
+        mem_free(st);
+    }
+    while (logger->reclaimlist) {
+        clog_logger_settings *st = logger->reclaimlist;
+        logger->reclaimlist = st->retired;
+        mem_free(st);
+    }
+    mem_free(logger);
+}
+
+
+/**
+ * publish settings of conf for running logger. returns 0 if all applied, or
+ *  1 if keys which need to recreate logger were changed (kept as created).
+ */
+int clog_logger_reload (clog_logger logger, clogger_conf conf)
+{
+    int restart = 0;
+
+    clog_logger_settings *st;
+
+    ub4 flags = (int) logger_conf_get_creatflags(conf);
+
+    clog_layout_t layout = ((CLOG_APPENDER_BINFILE & flags)? CLOG_LAYOUT_BINARY : conf->layout);
+    int rawtimestamp = (conf->rawtimestamp && (layout == CLOG_LAYOUT_DATED || layout == CLOG_LAYOUT_JSON))? 1 : 0;
+
+    CHKCONFIG_INT_VALUE(CLOG_MSGBUF_SIZE_DEFAULT, CLOG_MSGBUF_SIZE_MIN, CLOG_MSGBUF_SIZE_MAX, conf->maxmsgsize);
+
+    /* ringbuffer, layout and clock are used by callers without lock */
+    if (conf->maxmsgsize != logger->maxmsgsize || conf->queuelength != logger->queuelength ||
+        (conf->maxspillsize > conf->maxmsgsize? (size_t) conf->maxspillsize : 0) != logger->maxspillsize ||
+        (conf->prioritylane? 1 : 0) != (logger->priorityring? 1 : 0) ||
+        (conf->appenderqueue? 1 : 0) != ((logger->stdoutsink || logger->syslogsink)? 1 : 0) ||
+        layout != logger->layout || rawtimestamp != (int) logger->bf.rawtimestamp ||
+        rtclock_source_check(logger->rtc, (rtclock_source_t) conf->clocksource) != logger->clocksource) {
+        restart = 1;
+    }
+
+    pthread_mutex_lock(&logger->settingslock);
+
+    st = clog_logger_settings_new(conf, clog_logger_settings_get(logger));
+
+    /* rolling file and shared memory are opened only by create */
+    if (st->bf.appenderrofile && ! logger->bf.appenderrofile) {
+        st->bf.appenderrofile = 0;
+        restart = 1;
+    }
+    if (st->bf.appendershmlog && ! logger->bf.appendershmlog) {
+        st->bf.appendershmlog = 0;
+        restart = 1;
+    }
+
+    /* files of routes are opened only by create */
+    if (logger->bf.appenderrofile) {
+        int i;
+
+        if (conf->numroutes != logger->numroutes) {
+            restart = 1;
+        }
+
+        for (i = 0; ! restart && i < logger->numroutes; i++) {
+            if (conf->routes[i].levels != logger->routes[i].levels ||
+                cstr_compare_len(conf->routes[i].nameprefix->str, conf->routes[i].nameprefix->len, logger->routes[i].nameprefix->str, logger->routes[i].nameprefix->len, 0)) {
+                restart = 1;
+            }
+        }
+    }
+
+    /* ringbuffer is mapped only by create */
+    if ((conf->flightrecorder? 1 : 0) != (logger->flightrecorder? 1 : 0) ||
+        (conf->flightrecorder && cstr_compare_len(conf->flightrecorder->str, conf->flightrecorder->len, logger->flightrecorder->str, logger->flightrecorder->len, 0))) {
+        restart = 1;
+    }
+
+    if (st->bf.appendersyslog && ! logger->syslogopen) {
+        openlog(logger->ident->str, LOG_PID | LOG_NDELAY | LOG_NOWAIT, 0);
+        logger->syslogopen = 1;
+    }
+
+    clog_logger_settings_publish(logger, st);
+
+    pthread_mutex_unlock(&logger->settingslock);
+
+    /* wake up logthread to apply settings */
+    unsema_post(&logger->sema);
+
+    return restart;
+}
+
+
+void* logger_attach_data(clog_logger logger, void* data)
+{
+    void* old = logger->data;
+    logger->data = data;
+    return old;
+}
+
+int clog_logger_get_loggerid(clog_logger logger)
+{
+    return logger->loggerid;
+}
+
+
+const char * clog_logger_get_ident(clog_logger logger)
+{
+    return logger->ident->str;
+}
+
+
+int64_t clog_logger_get_logmessages(clog_logger logger, int64_t *round)
+{
+    if (round) {
+        *round = logger->logrounds;
+    }
+    return uatomic_int64_get(&logger->logmessages);
+}
+
+
+/* milliseconds left to abstime, -1 for forever */
+static int clog_timeout_left (int timeout_ms, const struct timespec *abstime)
+{
+    struct timespec now;
+    int64_t leftms;
+
+    if (timeout_ms < 0) {
+        return (-1);
+    }
+
+    getnowtimeofday(&now);
+    leftms = (int64_t)(abstime->tv_sec - now.tv_sec) * 1000 + (abstime->tv_nsec - now.tv_nsec) / 1000000;
+
+    return (leftms > 0? (int) leftms : 0);
+}
+
+
+static void clog_logger_batch_publish (clog_logger logger);
+
+
+int clog_logger_flush (clog_logger logger, int timeout_ms)
+{
+    int ret = 0;
+    struct timespec abstime;
+    int64_t flushseq;
+
+    if (logger_batch_owner() == (void *) logger) {
+        /* messages kept by batch of calling thread go first */
+        clog_logger_batch_publish(logger);
+    }
+
+    /* acknowledged after messages put before are read */
+    flushseq = uatomic_int64_add(&logger->flushseq);
+
+    if (timeout_ms >= 0) {
+        getnowtimeofday(&abstime);
+        abstime.tv_sec += timeout_ms / 1000;
+        abstime.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (abstime.tv_nsec >= 1000000000L) {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+        }
+    }
+
+    unsema_post(&logger->sema);
+
+    pthread_mutex_lock(&logger->flushlock);
+    while (logger->flushack < flushseq) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&logger->flushcond, &logger->flushlock);
+        } else if (pthread_cond_timedwait(&logger->flushcond, &logger->flushlock, &abstime) == ETIMEDOUT) {
+            ret = (logger->flushack < flushseq)? (-1) : 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&logger->flushlock);
+
+    /* lines taken by workers of appenders are written out by them */
+    if (ret == 0 && logger->stdoutsink) {
+        ret = logger_sink_sync(logger->stdoutsink, clog_timeout_left(timeout_ms, &abstime));
+    }
+    if (ret == 0 && logger->syslogsink) {
+        ret = logger_sink_sync(logger->syslogsink, clog_timeout_left(timeout_ms, &abstime));
+    }
+
+    return ret;
+}
+
+
+int clog_logger_get_maxmsgsize(clog_logger logger)
+{
+    return logger->maxmsgsize;
+}
+
+
+int clog_logger_level_enabled(clog_logger logger, clog_level_t level)
+{
+    const clog_logger_settings *st;
+    int enabled;
+
+    if (! logger) {
+        /* invalid logger */
+        return 0;
+    }
+
+    if (level == CLOG_LEVEL_OFF || level == CLOG_LEVEL_ALL) {
+        /* invalid qurey level */
+        return 0;
+    }
+
+    clog_logger_settings_enter(logger);
+    st = clog_logger_settings_get(logger);
+
+    /* check log level */
+    enabled = clog_logger_level_pass(logger, st, level, NULL, 0);
+
+    clog_logger_settings_leave(logger);
+    return enabled;
+}
+
+
+int clog_logger_site_gate_update (clog_logger logger, clog_sitegate_t *sitegate, const char *filename, int lineno)
+{
+    int sitegen = logger->head.sitegen;
+    int on = 0;
+
+    if (sitegen && logger->ctlpage) {
+        on = (loggerctl_site_flags(logger->ctlpage, filename, lineno) & LOGGERCTL_SITE_ON)? 1 : 0;
+    }
+
+    /* racing callers of same site store same value */
+    *sitegate = (sitegen << 1) | on;
+    return on;
+}
+
+
+int clog_logger_site_enabled (clog_logger logger, clog_level_t level, const char *filename, int lineno)
+{
+    int enabled;
+
+    if (! logger || level == CLOG_LEVEL_OFF || level == CLOG_LEVEL_ALL) {
+        return 0;
+    }
+
+    clog_logger_settings_enter(logger);
+    enabled = clog_logger_level_pass(logger, clog_logger_settings_get(logger), level, filename, lineno);
+    clog_logger_settings_leave(logger);
+
+    return enabled;
+}
+
+
+int clog_logger_set_site_rate (clog_logger logger, const char *filename, int lineno, int ratelimit, int rateburst, const char *sampling)
+{
+    logger_rate_policy policy;
+    logger_rate_hdl rates = clog_logger_get_rates(logger);
+
+    if (! rates) {
+        return -1;
+    }
+
+    bzero(&policy, sizeof(policy));
+
+    if (sampling && ! logger_rate_parse_sampling(sampling, &policy)) {
+        /* bad sampling */
+        return 0;
+    }
+
+    policy.ratelimit = (ratelimit > 0? ratelimit : 0);
+    policy.rateburst = (rateburst > 0? rateburst : 0);
+
+    return logger_rate_set_site(rates, filename, lineno, (logger_rate_policy_isset(&policy)? &policy : NULL));
+}
+
+
+const char * clog_logger_file_basename (const char *pathname, int *namelen)
+{
+    int pathlen = *namelen;
+    int i = pathlen;
+    while (i-- > 1) {
+        if (pathname[i] == '/' || pathname[i] == '\\') {
+            break;
+        }
+    }
+
+    if (i == 0) {
+        *namelen = pathlen;
+        return pathname;
+    } else {
+        *namelen = pathlen - i - 1;
+        return pathname + i + 1;
+    }
+}
+
+
+/**
+ * prepare DATED header of message:
+ *   datetime, level, ident, (file:line::func) and [pid/tid]
+ */
+static void clog_message_fmt_dated (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, clog_message_fmt *msgfmt)
+{
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+
+    msgfmt->level = level;
+    if (! st->bf.hideident) {
+        msgfmt->ident = logger->ident;
+    }
+    msgfmt->autowrapline = st->bf.autowrapline;
+
+    msgfmt->fmtlen = clog_format_datetime(logger, msgfmt, 1);
+
+    if (st->bf.levelcolors) {
+        clog_style_t style = CLOG_STYLE_NORMAL;
+        clog_style_t color = st->levelcolors[level];
+        if (st->bf.levelstyles) {
+            style = st->levelstyles[level];
+        }
+        msgfmt->startclrlen = snprintf(msgfmt->startclrfmt, sizeof(msgfmt->startclrfmt), "\033[%d;%dm", style, color);
+    }
+
+    if (st->bf.filelineno && filename) {
+        int basenamelen = cstr_length(filename, 256);
+        const char *basename = clog_logger_file_basename(filename, &basenamelen);
+        if (basenamelen > 84) {
+            basenamelen = 84;
+        }
+
+        if (st->bf.function) {
+            msgfmt->linenofmtlen = snprintf(msgfmt->linenofmt, sizeof(msgfmt->linenofmt), "(%.*s:%d::%.*s)", basenamelen, basename, lineno, cstr_length(funcname, 60), funcname);
+        } else {
+            msgfmt->linenofmtlen = snprintf(msgfmt->linenofmt, sizeof(msgfmt->linenofmt), "(%.*s:%d)", basenamelen, basename, lineno);
+        }
+    }
+
+#ifndef CLOGGER_NO_THREADNO
+    if (st->bf.processid) {
+        if (st->bf.threadno) {
+            msgfmt->threadnofmtlen = snprintf(msgfmt->threadnofmt, sizeof(msgfmt->threadnofmt), "[%.*s/%d]", logger->pidcstrlen, logger->pidcstr, (int)getthreadid());
+        } else {
+            msgfmt->threadnofmtlen = snprintf(msgfmt->threadnofmt, sizeof(msgfmt->threadnofmt), "[%.*s]", logger->pidcstrlen, logger->pidcstr);
+        }
+    }
+#endif
+
+    msgfmt->mdc = logger_mdc_text(st->kvformat, &msgfmt->mdclen);
+}
+
+
+/**
+ * prepare JSON line of message:
+ *   always one object per line whatever autowrapline is.
+ */
+static void clog_message_fmt_json (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, clog_message_fmt *msgfmt)
+{
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+
+    msgfmt->level = level;
+    if (! st->bf.hideident) {
+        msgfmt->ident = logger->ident;
+    }
+    msgfmt->autowrapline = 1;
+
+    msgfmt->fmtlen = clog_format_datetime(logger, msgfmt, 1);
+
+    if (filename) {
+        int basenamelen = cstr_length(filename, 256);
+        msgfmt->filename = clog_logger_file_basename(filename, &basenamelen);
+        msgfmt->filenamelen = basenamelen;
+        msgfmt->lineno = lineno;
+        msgfmt->funcname = funcname;
+        msgfmt->funcnamelen = cstr_length(funcname, 60);
+    }
+
+#ifndef CLOGGER_NO_THREADNO
+    msgfmt->threadnofmtlen = snprintf(msgfmt->threadnofmt, sizeof(msgfmt->threadnofmt), ",\"pid\":%.*s,\"tid\":%d", logger->pidcstrlen, logger->pidcstr, (int)getthreadid());
+    if (msgfmt->threadnofmtlen >= (int) sizeof(msgfmt->threadnofmt)) {
+        msgfmt->threadnofmtlen = 0;
+    }
+#endif
+
+    msgfmt->mdc = logger_mdc_text(CLOG_KVFORMAT_JSON, &msgfmt->mdclen);
+}
+
+
+/* max bytes of BINARY record in one ringbuffer entry */
+static size_t clog_message_bin_maxsize (clog_logger logger, const ringbuf_elt_t *msgbuf)
+{
+    size_t maxsize = logger->maxmsgsize - sizeof(clog_message_hdr) - sizeof(void *) * 2;
+    if (maxsize > msgbuf->size) {
+        maxsize = msgbuf->size;
+    }
+    return maxsize;
+}
+
+
+/**
+ * prepare BINARY record of message in recbuf:
+ *   raw timestamp, call site and format are copied, arguments are left to
+ *   caller. returns offset of arguments in recbuf.
+ */
+static size_t clog_message_bin_record (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, const char *format, int fmtlen, int recflags, char *recbuf, size_t recbufsz)
+{
+    logger_bin_record binrec;
+    struct timespec now;
+
+    char *p = recbuf + sizeof(binrec);
+
+    int filelen = 0;
+    int funclen = 0;
+    int mdclen = 0;
+
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+    const char *mdc = logger_mdc_fields(&mdclen);
+
+    rtclock_gettime(logger->rtc, logger->clocksource, &now);
+
+    binrec.timestamp = (ub8) now.tv_sec * 1000000000ULL + (ub8) now.tv_nsec;
+    binrec.stampid = 0;
+    if (st->bf.timestampid) {
+        struct timespec ts;
+        rtclock_ticktime(logger->rtc, &ts);
+        binrec.stampid = (ub8) ts.tv_sec * 1000000000ULL + (ub8) ts.tv_nsec;
+    }
+
+    binrec.threadid = (ub4) getthreadid();
+    binrec.lineno = (ub4) lineno;
+    binrec.level = (ub1) level;
+    binrec.flags = (ub1) recflags;
+
+    if (st->bf.filelineno && filename) {
+        filelen = cstr_length(filename, 256);
+        filename = clog_logger_file_basename(filename, &filelen);
+        if (filelen > 84) {
+            filelen = 84;
+        }
+        if (st->bf.function) {
+            funclen = cstr_length(funcname, 60);
+        }
+    }
+
+    if (mdc && mdclen <= (int)(recbufsz / 4)) {
+        /* context fields are rendered by logthread */
+        binrec.flags |= LOGGER_RECORD_MDC;
+    } else {
+        mdclen = 0;
+    }
+
+    binrec.filelen = (ub2) filelen;
+    binrec.funclen = (ub2) funclen;
+    binrec.mdclen = (ub2) mdclen;
+    binrec.fmtlen = (ub2) fmtlen;
+
+    memcpy(recbuf, &binrec, sizeof(binrec));
+
+    memcpy(p, filename, filelen);
+    p += filelen;
+    memcpy(p, funcname, funclen);
+    p += funclen;
+    memcpy(p, mdc, mdclen);
+    p += mdclen;
+    memcpy(p, format, fmtlen);
+    p += fmtlen;
+
+    return (size_t)(p - recbuf);
+}
+
+
+/* replace format of record prepared already. returns offset of arguments */
+static size_t clog_message_bin_setfmt (char *recbuf, const char *format, int fmtlen)
+{
+    logger_bin_record binrec;
+    char *p;
+
+    memcpy(&binrec, recbuf, sizeof(binrec));
+    binrec.fmtlen = (ub2) fmtlen;
+    memcpy(recbuf, &binrec, sizeof(binrec));
+
+    p = recbuf + sizeof(binrec) + binrec.filelen + binrec.funclen + binrec.mdclen;
+    memcpy(p, format, fmtlen);
+
+    return (size_t)(p + fmtlen - recbuf);
+}
+
+
+/* BINARY record of message text as argument of "%s" */
+static size_t clog_message_bin_text (clog_logger logger, clog_level_t level, int recflags, const char *message, int msglen, char *recbuf, size_t recbufsz)
+{
+    size_t offset = clog_message_bin_record(logger, level, NULL, 0, NULL, "%s", 2, recflags, recbuf, recbufsz);
+
+    if (msglen > (int)(recbufsz - offset - VARINT_SIZE_MAX)) {
+        msglen = (int)(recbufsz - offset - VARINT_SIZE_MAX);
+    }
+
+    offset += varint_encode64((ub8) msglen, (ub1 *) recbuf + offset);
+    memcpy(recbuf + offset, message, msglen);
+
+    return offset + msglen;
+}
+
+
+/**
+ * BINARY record of formatted message:
+ *   arguments are captured without formatting. message is formatted as text
+ *   if format has unsupported conversion or is too long.
+ */
+static size_t clog_message_bin_format (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, char *recbuf, size_t recbufsz, const char *format, va_list args)
+{
+    int msglen = -1;
+
+    size_t offset;
+    char *textbuf;
+    size_t textsize;
+
+    int fmtlen = cstr_length(format, recbufsz / 4);
+    int capture = (format[fmtlen]? 0 : 1);
+
+    offset = clog_message_bin_record(logger, level, filename, lineno, funcname, format, (capture? fmtlen : 0), 0, recbuf, recbufsz);
+
+    if (capture) {
+        va_list argscopy;
+
+        va_copy(argscopy, args);
+        msglen = logger_fmt_capture(format, argscopy, recbuf + offset, recbufsz - offset);
+        va_end(argscopy);
+
+        if (msglen != -1) {
+            return offset + msglen;
+        }
+    }
+
+    /* format text after room for varint length, then moved into place */
+    offset = clog_message_bin_setfmt(recbuf, "%s", 2);
+
+    textbuf = recbuf + offset + VARINT_SIZE_MAX;
+    textsize = recbufsz - offset - VARINT_SIZE_MAX;
+
+    msglen = vsnprintf(textbuf, textsize, format, args);
+    if (msglen == -1) {
+        msglen = snprintf(textbuf, textsize, "application error");
+    } else if (msglen >= (int) textsize) {
+        msglen = (int) textsize - 1;
+    }
+
+    offset += varint_encode64((ub8) msglen, (ub1 *) recbuf + offset);
+    memmove(recbuf + offset, textbuf, msglen);
+
+    return offset + msglen;
+}
+
+
+static size_t clog_message_bin_printf (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, char *recbuf, size_t recbufsz, const char *format, ...)
+{
+    size_t reclen;
+
+    va_list args;
+    va_start(args, format);
+    reclen = clog_message_bin_format(logger, level, filename, lineno, funcname, recbuf, recbufsz, format, args);
+    va_end(args);
+
+    return reclen;
+}
+
+
+/* maxwaitms of log api in microseconds, -1 for forever */
+static int64_t clog_msgwait_usec (ub2 maxwaitms)
+{
+    if (maxwaitms == (ub2) CLOG_MSGWAIT_INFINITE) {
+        return (-1);
+    }
+    return (int64_t) maxwaitms * 1000;
+}
+
+
+typedef struct
+{
+    ring_buffer_st *ring;
+    size_t chunksize;
+    void (*write_cb)(char *, size_t, void *);
+    const clog_message_fmt *msg;
+} clog_message_write_arg;
+
+
+static int clog_message_trywrite (void *arg)
+{
+    const clog_message_write_arg *wr = (const clog_message_write_arg *) arg;
+
+    return ringbufst_write(wr->ring, wr->chunksize, wr->write_cb, (void*) wr->msg);
+}
+
+
+/**
+ * ring is full or locked by other caller: spin, yield, then park on
+ *  parkcond until trywrite done after logthread frees room, waitus elapsed
+ *  or logger is destroyed.
+ */
+static int logger_wait_write (clog_logger logger, int (*trywrite)(void *), void *arg, int64_t waitus)
+{
+    int i, ok = 0;
+    struct timespec start;
+
+    for (i = 0; i < CLOG_WAIT_SPINS; i++) {
+        CPU_PAUSE();
+        if (trywrite(arg)) {
+            return 1;
+        }
+    }
+
+    getnowtimeofday(&start);
+
+    for (i = 0; i < CLOG_WAIT_YIELDS; i++) {
+        sched_yield();
+        if (trywrite(arg)) {
+            return 1;
+        }
+        if ((waitus >= 0 && clog_elapsed_usec(&start) >= waitus) || uatomic_int_get(&logger->shutdown)) {
+            return 0;
+        }
+    }
+
+    /* logthread must be running to free room */
+    unsema_post(&logger->sema);
+
+    pthread_mutex_lock(&logger->parklock);
+    uatomic_int_add(&logger->parked);
+
+    while (! (ok = trywrite(arg))) {
+        int64_t leftus = CLOG_WAIT_PARKUS;
+        struct timespec abstime;
+
+        if (uatomic_int_get(&logger->shutdown)) {
+            break;
+        }
+
+        if (waitus >= 0) {
+            leftus = waitus - clog_elapsed_usec(&start);
+            if (leftus <= 0) {
+                break;
+            }
+            if (leftus > CLOG_WAIT_PARKUS) {
+                leftus = CLOG_WAIT_PARKUS;
+            }
+        }
+
+        getnowtimeofday(&abstime);
+        abstime.tv_sec += (time_t)(leftus / 1000000);
+        abstime.tv_nsec += (long)(leftus % 1000000) * 1000L;
+        if (abstime.tv_nsec >= 1000000000L) {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&logger->parkcond, &logger->parklock, &abstime);
+    }
+
+    uatomic_int_sub(&logger->parked);
+    pthread_mutex_unlock(&logger->parklock);
+
+    return ok;
+}
+
+
+/* entries of batch of calling thread not given yet are written as many as room */
+static int clog_batch_trywrite (void *arg)
+{
+    clog_logger logger = (clog_logger) arg;
+
+    size_t entriessz;
+    int64_t waitus;
+    const char *entries = logger_batch_entries(&entriessz, &waitus);
+
+    ssize_t written = ringbufst_write_entries(logger->ringbuffer, entries, entriessz);
+
+    if (written < 0) {
+        /* should never run to this */
+        uatomic_int64_add_n(&logger->dropped, logger_batch_discard());
+        return 1;
+    }
+
+    logger_batch_consume((size_t) written);
+    return (written == (ssize_t) entriessz);
+}
+
+
+/* messages kept by calling thread go to ringbuffer with one wakeup of logthread */
+static void clog_logger_batch_publish (clog_logger logger)
+{
+    size_t entriessz;
+    int64_t waitus;
+
+    logger_batch_entries(&entriessz, &waitus);
+    if (! entriessz) {
+        return;
+    }
+
+    if (uatomic_int_get(&logger->shutdown)) {
+        uatomic_int64_add_n(&logger->dropped, logger_batch_discard());
+        return;
+    }
+
+    if (! clog_batch_trywrite(logger)) {
+        if (! waitus || ! logger_wait_write(logger, clog_batch_trywrite, logger, waitus)) {
+            /* failed with nowait or max wait of messages elapsed */
+            uatomic_int64_add_n(&logger->dropped, logger_batch_discard());
+        }
+    }
+
+    unsema_post(&logger->sema);
+}
+
+
+/**
+ * message in batch of calling thread is kept in buffer of thread. batch is
+ *  given when buffer is full, ahead of message of priority lane and after
+ *  WARN and above. returns 0 if not kept.
+ */
+static int logger_batch_message (clog_logger logger, const clog_message_fmt *msg, ring_buffer_st *ring, size_t chunksize, void (*write_cb)(char *, size_t, void *), int64_t maxwaitus)
+{
+    char *chunk;
+
+    if (ring != logger->ringbuffer) {
+        clog_logger_batch_publish(logger);
+        return 0;
+    }
+
+    chunk = logger_batch_reserve(chunksize);
+    if (! chunk) {
+        clog_logger_batch_publish(logger);
+
+        chunk = logger_batch_reserve(chunksize);
+        if (! chunk) {
+            return 0;
+        }
+    }
+
+    write_cb(chunk, chunksize, (void*) msg);
+    logger_batch_commit(chunksize, maxwaitus);
+
+    if (msg->msglevel <= CLOG_LEVEL_WARN) {
+        clog_logger_batch_publish(logger);
+    }
+
+    return 1;
+}
+
+
+/* text of msglen bytes longer than msgbuf can be logged whole (maxspillsize) */
+static int clog_logger_spillable (clog_logger logger, size_t msglen)
+{
+    return (logger->maxspillsize && logger->layout != CLOG_LAYOUT_BINARY && msglen <= logger->maxspillsize);
+}
+
+
+/* text of msglen bytes sized by first pass is made by write_message_cb */
+static void clog_message_spill_text (clog_message_fmt *msg, const char *format, va_list *args, int64_t suppressed)
+{
+    msg->spillformat = format;
+    msg->spillargs = args;
+    msg->spilltextlen = msg->msglen;
+    msg->spillsuppressed = suppressed;
+
+    if (suppressed) {
+        msg->msglen += CLOG_SUPPRESSED_SIZE;
+    }
+}
+
+
+/**
+ * oversize message is made on heap and only its address goes to ring.
+ *  bytes of chunks not yet logged are bounded by CLOG_SPILL_INFLIGHT times
+ *  of maxspillsize. returns 0 if not spilled.
+ */
+static int clog_logger_spill_chunk (clog_logger logger, const clog_message_fmt *msg, void (*write_cb)(char *, size_t, void *), clog_message_spill *spill)
+{
+    size_t chunksize;
+
+    /* length of text is bounded by caller */
+    if (msg->kind != CLOG_MSGKIND_TEXT || ! logger->maxspillsize) {
+        return 0;
+    }
+
+    if (logger->layout == CLOG_LAYOUT_JSON) {
+        chunksize = clog_message_json_chunksize(msg, (size_t) -1);
+    } else {
+        chunksize = clog_message_fmt_chunksize(msg, (size_t) -1);
+    }
+
+    if (uatomic_int64_add_n(&logger->spillbytes, chunksize) > (int64_t) logger->maxspillsize * CLOG_SPILL_INFLIGHT) {
+        /* logthread is behind */
+        uatomic_int64_sub_n(&logger->spillbytes, chunksize);
+        return 0;
+    }
+
+    spill->epoch = logger->spillepoch;
+    spill->chunksize = chunksize;
+    spill->chunk = (clog_message_hdr *) mem_alloc_unset(chunksize);
+
+    write_cb((char *) spill->chunk, chunksize, (void*) msg);
+    return 1;
+}
+
+
+static void logger_commit_message (clog_logger logger, clog_message_fmt *msg, int64_t maxwaitus)
+{
+    size_t chunksize;
+    void (*write_cb)(char *, size_t, void *);
+    ring_buffer_st *ring = logger->ringbuffer;
+    clog_message_spill spill;
+
+    if (uatomic_int_get(&logger->shutdown)) {
+        /* logger is being destroyed */
+        uatomic_int64_add(&logger->dropped);
+        return;
+    }
+
+    if (logger->priorityring) {
+        /* WARN and above never queue behind lower levels */
+        if (msg->msglevel <= CLOG_LEVEL_WARN || msg->urgent) {
+            ring = logger->priorityring;
+            msg->seq = (ub8) uatomic_int64_add(&logger->msgseq);
+        } else {
+            /* goes after lane message of same seq: read only, no RMW */
+            msg->seq = (ub8) uatomic_int64_load_acq(&logger->msgseq);
+        }
+    }
+
+    if (msg->kind == CLOG_MSGKIND_BIN) {
+        chunksize = memapi_align_psize(sizeof(clog_message_hdr) + msg->msglen);
+        if (chunksize >= logger->maxmsgsize) {
+            chunksize = -1;
+        }
+        write_cb = write_message_bin_cb;
+    } else if (logger->layout == CLOG_LAYOUT_JSON) {
+        chunksize = clog_message_json_chunksize(msg, logger->maxmsgsize);
+        write_cb = write_message_json_cb;
+    } else {
+        chunksize = clog_message_fmt_chunksize(msg, logger->maxmsgsize);
+        write_cb = write_message_cb;
+    }
+
+    if (chunksize == -1) {
+        if (! clog_logger_spill_chunk(logger, msg, write_cb, &spill)) {
+            /* message is oversize */
+            uatomic_int64_add(&logger->dropped);
+            return;
+        }
+
+        chunksize = memapi_align_psize(sizeof(clog_message_hdr) + sizeof(spill));
+        write_cb = write_message_spill_cb;
+        msg->spill = &spill;
+
+        if (logger_batch_owner() == (void *) logger) {
+            /* chunk must not be left in batch discarded */
+            clog_logger_batch_publish(logger);
+        }
+    } else if (logger_batch_owner() == (void *) logger && logger_batch_message(logger, msg, ring, chunksize, write_cb, maxwaitus)) {
+        return;
     }
-    ringbufst_uninit(logger->ringbuffer);
-    ringbuf_uninit(logger->mempool);
-    mem_free(logger);
-}
 
+    if (! ringbufst_write(ring, chunksize, write_cb, (void*) msg)) {
+        clog_message_write_arg wr;
 
-void* logger_attach_data(clog_logger logger, void* data)
-{
-    void* old = logger->data;
-    logger->data = data;
-    return old;
-}
+        wr.ring = ring;
+        wr.chunksize = chunksize;
+        wr.write_cb = write_cb;
+        wr.msg = msg;
 
-int clog_logger_get_loggerid(clog_logger logger)
-{
-    return logger->loggerid;
+        if (! maxwaitus || ! logger_wait_write(logger, clog_message_trywrite, &wr, maxwaitus)) {
+            /* failed push msg with nowait or maxwaitus elapsed */
+            uatomic_int64_add(&logger->dropped);
+
+            if (msg->spill) {
+                clog_logger_spill_free(logger, &spill);
+            }
+        }
+    }
+
+    unsema_post(&logger->sema);
 }
 
 
-const char * clog_logger_get_ident(clog_logger logger)
+/* thread exits in batch */
+static void clog_batch_flush (void *owner)
 {
-    return logger->ident->str;
+    clog_logger_batch_publish((clog_logger) owner);
 }
 
 
-int64_t clog_logger_get_logmessages(clog_logger logger, int64_t *round)
+int clog_batch_begin (clog_logger logger)
 {
-    if (round) {
-        *round = logger->logrounds;
+    if (logger_batch_begin((void *) logger, RINGBUFST_ALIGN_ENTRYSIZE(logger->maxmsgsize), clog_batch_flush) == -1) {
+        return (-1);
     }
-    return uatomic_int64_get(&logger->logmessages);
+    return 0;
 }
 
 
-int clog_logger_get_maxmsgsize(clog_logger logger)
+void clog_batch_end (void)
 {
-    return logger->maxmsgsize;
+    clog_logger logger = (clog_logger) logger_batch_owner();
+
+    if (logger && logger_batch_leave() == 0) {
+        clog_logger_batch_publish(logger);
+    }
 }
 
 
-int clog_logger_level_enabled(clog_logger logger, clog_level_t level)
+/* keep record not logged in backtrace ring of calling thread */
+static void clog_logger_bt_capture (clog_logger logger, clog_level_t level, const char *filename, int lineno, const char *funcname, const char *format, va_list args)
 {
-    if (! logger) {
-        /* invalid logger */
-        return 0;
-    }
+    logger_bin_record binrec;
 
-    if (level == CLOG_LEVEL_OFF || level == CLOG_LEVEL_ALL) {
-        /* invalid qurey level */
-        return 0;
-    }
+    char *recbuf = logger_bt_reserve();
+    size_t recbufsz = logger->maxmsgsize - sizeof(clog_message_hdr) - sizeof(void *) * 2;
+    size_t reclen;
 
-    if (logger->level == CLOG_LEVEL_OFF) {
-        /* disable all logger levels */
-        return 0;
+    if (recbufsz > LOGGERBT_RECSIZE) {
+        recbufsz = LOGGERBT_RECSIZE;
     }
 
-    /* check log level */
-    if (logger->level == CLOG_LEVEL_ALL || level <= logger->level) {
-        return 1;
-    }
+    reclen = clog_message_bin_format(logger, level, filename, lineno, funcname, recbuf, recbufsz, format, args);
 
-    /* level is disabled */
-    return 0;
+    memcpy(&binrec, recbuf, sizeof(binrec));
+    logger_bt_commit(logger->btkey, binrec.timestamp, reclen);
 }
 
 
-const char * clog_logger_file_basename (const char *pathname, int *namelen)
+typedef struct
 {
-    int pathlen = *namelen;
-    int i = pathlen;
-    while (i-- > 1) {
-        if (pathname[i] == '/' || pathname[i] == '\\') {
-            break;
-        }
-    }
-
-    if (i == 0) {
-        *namelen = pathlen;
-        return pathname;
-    } else {
-        *namelen = pathlen - i - 1;
-        return pathname + i + 1;
-    }
-}
+    clog_logger logger;
+    int64_t maxwaitus;
+} clog_bt_drain_arg;
 
 
-static void logger_commit_message (clog_logger logger, const clog_message_fmt *msg, ub2 maxwaitms, int intervalms)
+static void clog_logger_bt_commit_cb (char *record, size_t reclen, void *arg)
 {
-    int waitms = 0;
+    clog_bt_drain_arg *drain = (clog_bt_drain_arg *) arg;
 
-    size_t chunksize  = clog_message_fmt_chunksize(msg, logger->maxmsgsize);
-    if (chunksize == -1) {
-        /* message is oversize */
-        return;
-    }
+    logger_bin_record binrec;
+    clog_message_fmt msgfmt;
 
-    while (! ringbufst_write(logger->ringbuffer, chunksize, write_message_cb, (void*) msg)) {
-        if (! maxwaitms) {
-            /* failed push msg with nowait */
-            break;
-        }
+    memcpy(&binrec, record, sizeof(binrec));
+    binrec.flags |= LOGGER_RECORD_BACKTRACE;
+    memcpy(record, &binrec, sizeof(binrec));
 
-        if (maxwaitms == CLOG_MSGWAIT_INFINITE) {
-            /* wait forever until push msg ok */
-            sleep_msec(intervalms);
-            continue;
-        }
+    bzero(&msgfmt, sizeof(msgfmt));
+    msgfmt.msglevel = (clog_level_t) binrec.level;
+    msgfmt.kind = CLOG_MSGKIND_BIN;
+    msgfmt.msglen = (int) reclen;
+    msgfmt.message = record;
 
-        if (waitms < (int)maxwaitms) {
-            int ms = (int)maxwaitms - waitms;
-            if (ms < intervalms) {
-                sleep_msec(ms);
-                waitms += ms;
-            } else {
-                sleep_msec(intervalms);
-                waitms += intervalms;
-            }
-            continue;
-        }
+    /* logged just ahead of ERROR in the same lane */
+    msgfmt.urgent = 1;
 
-        /* failed push msg with maxwaitms elapsed */
-        break;
+    logger_commit_message(drain->logger, &msgfmt, drain->maxwaitus);
+}
+
+
+/* records kept by calling thread go ahead of ERROR or FATAL */
+static void clog_logger_bt_dump (clog_logger logger, const clog_logger_settings *st, int64_t maxwaitus)
+{
+    ub8 since = 0;
+    clog_bt_drain_arg drain;
+
+    if (st->backtracems > 0) {
+        struct timespec now;
+        rtclock_gettime(logger->rtc, logger->clocksource, &now);
+
+        since = (ub8) now.tv_sec * 1000000000ULL + (ub8) now.tv_nsec;
+        since = (since > (ub8) st->backtracems * 1000000ULL? since - (ub8) st->backtracems * 1000000ULL : 0);
     }
 
-    unsema_post(&logger->sema);
+    drain.logger = logger;
+    drain.maxwaitus = maxwaitus;
+
+    logger_bt_drain(logger->btkey, st->backtrace, since, clog_logger_bt_commit_cb, &drain);
 }
 
 
-void clog_logger_log_message (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *message, int msglen)
+static void clog_logger_log_message_wait (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *message, int msglen)
 {
-    if (level > logger->level) {
+    clog_logger_settings_enter(logger);
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+
+    int maxlen = (int)logger->maxmsgsize - 1;
+
+    if (! clog_logger_level_pass(logger, st, level, NULL, 0)) {
         /* logger not enabled for given level */
-        return;
+        goto leave_settings;
+    }
+    if (level <= CLOG_LEVEL_ERROR && st->backtrace) {
+        clog_logger_bt_dump(logger, st, maxwaitus);
+    }
+    if (clog_logger_spillable(logger, logger->maxspillsize)) {
+        maxlen = (int)logger->maxspillsize;
     }
     if (msglen < 0) {
-        msglen = cstr_length(message, logger->maxmsgsize - 1);
+        msglen = cstr_length(message, maxlen);
     }
     if (! msglen) {
-        return;
+        goto leave_settings;
     }
-    if (msglen >= (int)logger->maxmsgsize) {
+    if (msglen > maxlen) {
         /* need to truncate message */
-        msglen = (int)logger->maxmsgsize - 1;
+        msglen = maxlen;
     }
 
     if (logger->layout == CLOG_LAYOUT_PLAIN) {
         clog_message_fmt msgfmt;
         bzero(&msgfmt, sizeof(msgfmt));
+        msgfmt.msglevel = level;
 
-        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt.dateminfmt, NULL, NULL);
+        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt, 0);
         msgfmt.msglen = msglen;
         msgfmt.message = (char*) message;
 
-        logger_commit_message(logger, &msgfmt, maxwaitms, (int)CLOG_MSGWAIT_INSTANT);
+        logger_commit_message(logger, &msgfmt, maxwaitus);
     } else if (logger->layout == CLOG_LAYOUT_DATED) {
         clog_message_fmt msgfmt;
         bzero(&msgfmt, sizeof(msgfmt));
+        msgfmt.msglevel = level;
 
         msgfmt.level = level;
-        if (! logger->bf.hideident) {
+        if (! st->bf.hideident) {
             msgfmt.ident = logger->ident;
         }
-        msgfmt.autowrapline = logger->bf.autowrapline;
+        msgfmt.autowrapline = st->bf.autowrapline;
 
-        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt.dateminfmt, &msgfmt.datetimefmt, &msgfmt.stampidfmt);
+        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt, 1);
         msgfmt.msglen = msglen;
         msgfmt.message = (char*) message;
+        msgfmt.mdc = logger_mdc_text(st->kvformat, &msgfmt.mdclen);
 
-        if (logger->bf.levelcolors) {
+        if (st->bf.levelcolors) {
             clog_style_t style = CLOG_STYLE_NORMAL;
-            clog_style_t color = logger->levelcolors[level];
-            if (logger->bf.levelstyles) {
-                style = logger->levelstyles[level];
+            clog_style_t color = st->levelcolors[level];
+            if (st->bf.levelstyles) {
+                style = st->levelstyles[level];
             }
             msgfmt.startclrlen = snprintf(msgfmt.startclrfmt, sizeof(msgfmt.startclrfmt), "\033[%d;%dm", style, color);
         }
 
-        logger_commit_message(logger, &msgfmt, maxwaitms, (int)CLOG_MSGWAIT_INSTANT);
+        logger_commit_message(logger, &msgfmt, maxwaitus);
+    } else if (logger->layout == CLOG_LAYOUT_JSON) {
+        clog_message_fmt msgfmt;
+        bzero(&msgfmt, sizeof(msgfmt));
+        msgfmt.msglevel = level;
+
+        clog_message_fmt_json(logger, level, NULL, 0, NULL, &msgfmt);
+
+        msgfmt.msglen = msglen;
+        msgfmt.message = (char*) message;
+        msgfmt.msgesclen = json_escape_length(message, msglen);
+
+        logger_commit_message(logger, &msgfmt, maxwaitus);
+    } else if (logger->layout == CLOG_LAYOUT_BINARY) {
+        clog_message_fmt msgfmt;
+        ringbuf_elt_t *msgbuf;
+
+        bzero(&msgfmt, sizeof(msgfmt));
+        msgfmt.msglevel = level;
+        msgbuf = clog_logger_msgbuf_pop(logger);
+
+        msgfmt.kind = CLOG_MSGKIND_BIN;
+        msgfmt.msglen = clog_message_bin_text(logger, level, LOGGER_RECORD_NOTHREAD, message, msglen, msgbuf->data, clog_message_bin_maxsize(logger, msgbuf));
+        msgfmt.message = msgbuf->data;
+
+        logger_commit_message(logger, &msgfmt, maxwaitus);
+
+        ringbuf_push_always(logger->mempool, msgbuf);
     }
+
+leave_settings:
+    clog_logger_settings_leave(logger);
+}
+
+
+void clog_logger_log_message (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *message, int msglen)
+{
+    clog_logger_log_message_wait(logger, level, clog_msgwait_usec(maxwaitms), message, msglen);
+}
+
+
+void clog_logger_log_message_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *message, int msglen)
+{
+    clog_logger_log_message_wait(logger, level, maxwaitus, message, msglen);
 }
 
 
@@ -1103,31 +3789,59 @@ void clog_logger_get_localtime(clog_logger logger, int timezone, int daylight, s
  * Sample:
  *   20191222-17:35:28.188 GMT+8 INFO client- (main.c:69) <runforever> [1899/1] Cannot open file: invalid path - '/cygdrive/c/test/log'
  */
-void clog_logger_log_format(clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *filename, int lineno, const char *funcname, const char *format, ...)
+static void clog_logger_log_vformat_wait (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *filename, int lineno, const char *funcname, const char *format, va_list ap)
 {
     int msglen = 0;
+    int64_t suppressed;
+
+    clog_logger_settings_enter(logger);
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
 
-    if (level > logger->level) {
+    if (! clog_logger_level_pass(logger, st, level, filename, lineno)) {
+        if (st->backtrace && level <= st->backtracelevel) {
+            va_list args;
+            va_copy(args, ap);
+            clog_logger_bt_capture(logger, level, filename, lineno, funcname, format, args);
+            va_end(args);
+        }
         /* logger not enabled for given level */
-        return;
+        goto leave_settings;
+    }
+
+    if (! clog_logger_rate_pass(logger, st, level, filename, lineno, &suppressed)) {
+        /* call site is limited */
+        goto leave_settings;
+    }
+
+    if (level <= CLOG_LEVEL_ERROR && st->backtrace) {
+        clog_logger_bt_dump(logger, st, maxwaitus);
     }
 
     if (logger->layout == CLOG_LAYOUT_PLAIN) {
         clog_message_fmt msgfmt;
         ringbuf_elt_t *msgbuf;
 
+        va_list spillargs;
+        size_t msgsize;
+
         bzero(&msgfmt, sizeof(msgfmt));
-        ringbuf_pop_always(logger->mempool, msgbuf);
+        msgfmt.msglevel = level;
+        msgbuf = clog_logger_msgbuf_pop(logger);
+        msgsize = msgbuf->size;
 
-        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt.dateminfmt, NULL, NULL);
+        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt, 0);
 
         va_list args;
-        va_start(args, format);
+        va_copy(args, ap);
         msgfmt.msglen = vsnprintf(msgbuf->data, msgbuf->size, format, args);
         va_end(args);
 
         if (msgfmt.msglen == -1) {
             msgfmt.msglen = snprintf(msgbuf->data, msgbuf->size, "application error");
+        } else if (msgfmt.msglen >= msgbuf->size && clog_logger_spillable(logger, msgfmt.msglen)) {
+            /* formatted as a whole only into spill chunk */
+            va_copy(spillargs, ap);
+            clog_message_spill_text(&msgfmt, format, &spillargs, suppressed);
         } else if (msgfmt.msglen >= msgbuf->size) {
             /* message was truncated due to maxmsgsize limit */
             msgfmt.msglen = logger->maxmsgsize - 1;
@@ -1137,67 +3851,86 @@ void clog_logger_log_format(clog_logger logger, clog_level_t level, uint16_t max
             msgbuf->data[msgfmt.msglen - 1] = '.';
         }
 
-        msgbuf->data[msgfmt.msglen] = '\0';
-        msgfmt.message = msgbuf->data;
+        if (! msgfmt.spillformat) {
+            msgfmt.message = msgbuf->data;
+            msgfmt.message[msgfmt.msglen] = '\0';
+
+            if (suppressed) {
+                msgfmt.msglen = clog_message_add_suppressed(msgfmt.message, msgfmt.msglen, (int) msgsize, suppressed);
+            }
+        }
 
-        logger_commit_message(logger, &msgfmt, maxwaitms, (int)CLOG_MSGWAIT_INSTANT);
+        logger_commit_message(logger, &msgfmt, maxwaitus);
 
+        if (msgfmt.spillformat) {
+            va_end(spillargs);
+        }
         ringbuf_push_always(logger->mempool, msgbuf);
-    } else if (logger->layout == CLOG_LAYOUT_DATED) {
+    } else if (logger->layout == CLOG_LAYOUT_BINARY) {
         clog_message_fmt msgfmt;
         ringbuf_elt_t *msgbuf;
 
         bzero(&msgfmt, sizeof(msgfmt));
-        ringbuf_pop_always(logger->mempool, msgbuf);
+        msgfmt.msglevel = level;
+        msgbuf = clog_logger_msgbuf_pop(logger);
 
-        msgfmt.level = level;
-        if (! logger->bf.hideident) {
-            msgfmt.ident = logger->ident;
-        }
-        msgfmt.autowrapline = logger->bf.autowrapline;
+        va_list args;
+        va_copy(args, ap);
+        msgfmt.msglen = clog_message_bin_format(logger, level, filename, lineno, funcname, msgbuf->data, clog_message_bin_maxsize(logger, msgbuf), format, args);
+        va_end(args);
 
-        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt.dateminfmt, &msgfmt.datetimefmt, &msgfmt.stampidfmt);
+        msgfmt.kind = CLOG_MSGKIND_BIN;
+        msgfmt.message = msgbuf->data;
 
-        if (logger->bf.levelcolors) {
-            clog_style_t style = CLOG_STYLE_NORMAL;
-            clog_style_t color = logger->levelcolors[level];
-            if (logger->bf.levelstyles) {
-                style = logger->levelstyles[level];
-            }
-            msgfmt.startclrlen = snprintf(msgfmt.startclrfmt, sizeof(msgfmt.startclrfmt), "\033[%d;%dm", style, color);
+        logger_commit_message(logger, &msgfmt, maxwaitus);
+
+        if (suppressed) {
+            /* arguments are not captured as text: count goes in next record */
+            msgfmt.msglen = clog_message_bin_printf(logger, level, filename, lineno, funcname, msgbuf->data, clog_message_bin_maxsize(logger, msgbuf), "[suppressed %" PRId64 "]", suppressed);
+            logger_commit_message(logger, &msgfmt, maxwaitus);
         }
 
-        if (logger->bf.filelineno && filename) {
-            int basenamelen = cstr_length(filename, 256);
-            const char *basename = clog_logger_file_basename(filename, &basenamelen);
-            if (basenamelen > 84) {
-                basenamelen = 84;
-            }
+        ringbuf_push_always(logger->mempool, msgbuf);
+    } else {
+        clog_message_fmt msgfmt;
+        ringbuf_elt_t *msgbuf;
 
-            if (logger->bf.function) {
-                msgfmt.linenofmtlen = snprintf(msgfmt.linenofmt, sizeof(msgfmt.linenofmt), "(%.*s:%d::%.*s)", basenamelen, basename, lineno, cstr_length(funcname, 60), funcname);
-            } else {
-                msgfmt.linenofmtlen = snprintf(msgfmt.linenofmt, sizeof(msgfmt.linenofmt), "(%.*s:%d)", basenamelen, basename, lineno);
-            }
-        }
+        char *spillbuf = NULL;
+        va_list spillargs;
+        size_t msgsize;
 
-#ifndef CLOGGER_NO_THREADNO
-        if (logger->bf.processid) {
-            if (logger->bf.threadno) {
-                msgfmt.threadnofmtlen = snprintf(msgfmt.threadnofmt, sizeof(msgfmt.threadnofmt), "[%.*s/%d]", logger->pidcstrlen, logger->pidcstr, (int)getthreadid());
-            } else {
-                msgfmt.threadnofmtlen = snprintf(msgfmt.threadnofmt, sizeof(msgfmt.threadnofmt), "[%.*s]", logger->pidcstrlen, logger->pidcstr);
-            }
+        bzero(&msgfmt, sizeof(msgfmt));
+        msgfmt.msglevel = level;
+        msgbuf = clog_logger_msgbuf_pop(logger);
+        msgsize = msgbuf->size;
+
+        if (logger->layout == CLOG_LAYOUT_JSON) {
+            clog_message_fmt_json(logger, level, filename, lineno, funcname, &msgfmt);
+        } else {
+            clog_message_fmt_dated(logger, level, filename, lineno, funcname, &msgfmt);
         }
-#endif
 
         va_list args;
-        va_start(args, format);
+        va_copy(args, ap);
         msgfmt.msglen = vsnprintf(msgbuf->data, msgbuf->size, format, args);
         va_end(args);
 
         if (msgfmt.msglen == -1) {
             msgfmt.msglen = snprintf(msgbuf->data, msgbuf->size, "application error");
+        } else if (msgfmt.msglen >= msgbuf->size && clog_logger_spillable(logger, msgfmt.msglen)) {
+            if (logger->layout == CLOG_LAYOUT_JSON) {
+                /* text is escaped into chunk: made again as a whole once */
+                msgsize = msgfmt.msglen + CLOG_SUPPRESSED_SIZE;
+                spillbuf = (char *) mem_alloc_unset(msgsize);
+
+                va_copy(args, ap);
+                vsnprintf(spillbuf, msgfmt.msglen + 1, format, args);
+                va_end(args);
+            } else {
+                /* formatted as a whole only into spill chunk */
+                va_copy(spillargs, ap);
+                clog_message_spill_text(&msgfmt, format, &spillargs, suppressed);
+            }
         } else if (msgfmt.msglen >= msgbuf->size) {
             /* message was truncated due to maxmsgsize limit */
             msgfmt.msglen = logger->maxmsgsize - 1;
@@ -1207,11 +3940,203 @@ void clog_logger_log_format(clog_logger logger, clog_level_t level, uint16_t max
             msgbuf->data[msgfmt.msglen - 1] = '.';
         }
 
-        msgbuf->data[msgfmt.msglen] = '\0';
-        msgfmt.message = msgbuf->data;
+        if (! msgfmt.spillformat) {
+            msgfmt.message = (spillbuf? spillbuf : msgbuf->data);
+            msgfmt.message[msgfmt.msglen] = '\0';
+
+            if (suppressed) {
+                msgfmt.msglen = clog_message_add_suppressed(msgfmt.message, msgfmt.msglen, (int) msgsize, suppressed);
+            }
+
+            if (logger->layout == CLOG_LAYOUT_JSON) {
+                msgfmt.msgesclen = json_escape_length(msgfmt.message, msgfmt.msglen);
+            }
+        }
+
+        logger_commit_message(logger, &msgfmt, maxwaitus);
+
+        if (msgfmt.spillformat) {
+            va_end(spillargs);
+        }
+        mem_free(spillbuf);
+        ringbuf_push_always(logger->mempool, msgbuf);
+    }
+
+leave_settings:
+    clog_logger_settings_leave(logger);
+}
+
+
+void clog_logger_log_format (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *filename, int lineno, const char *funcname, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    clog_logger_log_vformat_wait(logger, level, clog_msgwait_usec(maxwaitms), filename, lineno, funcname, format, ap);
+    va_end(ap);
+}
+
+
+void clog_logger_log_format_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *filename, int lineno, const char *funcname, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    clog_logger_log_vformat_wait(logger, level, maxwaitus, filename, lineno, funcname, format, ap);
+    va_end(ap);
+}
+
 
-        logger_commit_message(logger, &msgfmt, maxwaitms, (int)CLOG_MSGWAIT_INSTANT);
+/**
+ * log structured key-value fields
+ * Format:
+ *   DATED header + rendered fields by logthread:
+ *     2019-12-22 17:35:28.188+08:00 INFO <client> (main.c:69::runforever) event=login uid=1001
+ */
+static void clog_logger_log_vkv_wait (clog_logger logger, clog_level_t level, int64_t maxwaitus, const clog_callsite_t *site, int nfields, va_list ap)
+{
+    clog_message_fmt msgfmt;
+    ringbuf_elt_t *msgbuf;
+    size_t hdrsize, maxkvlen;
+
+    va_list args;
+    int64_t suppressed;
+    clog_kvfield_t supfield;
+
+    clog_logger_settings_enter(logger);
+    const clog_logger_settings *st = clog_logger_settings_get(logger);
+
+    if (nfields <= 0 || ! clog_logger_level_pass(logger, st, level, (site? site->filename : NULL), (site? site->lineno : 0))) {
+        /* logger not enabled for given level */
+        goto leave_settings;
+    }
+
+    if (site && ! clog_logger_rate_pass(logger, st, level, site->filename, site->lineno, &suppressed)) {
+        /* call site is limited */
+        goto leave_settings;
+    }
+
+    if (level <= CLOG_LEVEL_ERROR && st->backtrace) {
+        clog_logger_bt_dump(logger, st, maxwaitus);
+    }
+
+    /* lines suppressed since last one go as last field */
+    bzero(&supfield, sizeof(supfield));
+    supfield.key = "suppressed";
+    supfield.type = CLOG_KV_INT64;
+    supfield.value.i64 = (site? suppressed : 0);
+
+    bzero(&msgfmt, sizeof(msgfmt));
+    msgfmt.msglevel = level;
+
+    if (logger->layout == CLOG_LAYOUT_BINARY) {
+        size_t offset, maxsize;
+
+        msgbuf = clog_logger_msgbuf_pop(logger);
+        maxsize = clog_message_bin_maxsize(logger, msgbuf);
+
+        if (site) {
+            offset = clog_message_bin_record(logger, level, site->filename, site->lineno, site->funcname, "", 0, LOGGER_RECORD_KV, msgbuf->data, maxsize);
+        } else {
+            offset = clog_message_bin_record(logger, level, NULL, 0, NULL, "", 0, LOGGER_RECORD_KV, msgbuf->data, maxsize);
+        }
+        msgfmt.msglen = offset;
+
+        va_copy(args, ap);
+        while (nfields-- > 0) {
+            clog_kvfield_t field = va_arg(args, clog_kvfield_t);
+
+            /* field with no room left is skipped, smaller ones might fit */
+            msgfmt.msglen += logger_kv_encode(&field, msgbuf->data + msgfmt.msglen, maxsize - msgfmt.msglen);
+        }
+        va_end(args);
+
+        if (supfield.value.i64) {
+            msgfmt.msglen += logger_kv_encode(&supfield, msgbuf->data + msgfmt.msglen, maxsize - msgfmt.msglen);
+        }
+
+        if (msgfmt.msglen > offset) {
+            msgfmt.kind = CLOG_MSGKIND_BIN;
+            msgfmt.message = msgbuf->data;
+            logger_commit_message(logger, &msgfmt, maxwaitus);
+        }
 
         ringbuf_push_always(logger->mempool, msgbuf);
+        goto leave_settings;
+    }
+
+    msgfmt.kind = CLOG_MSGKIND_KV;
+
+    if (logger->layout == CLOG_LAYOUT_DATED) {
+        if (site) {
+            clog_message_fmt_dated(logger, level, site->filename, site->lineno, site->funcname, &msgfmt);
+        } else {
+            clog_message_fmt_dated(logger, level, NULL, 0, NULL, &msgfmt);
+        }
+    } else if (logger->layout == CLOG_LAYOUT_JSON) {
+        if (site) {
+            clog_message_fmt_json(logger, level, site->filename, site->lineno, site->funcname, &msgfmt);
+        } else {
+            clog_message_fmt_json(logger, level, NULL, 0, NULL, &msgfmt);
+        }
+    } else {
+        msgfmt.fmtlen = clog_format_datetime(logger, &msgfmt, 0);
+    }
+
+    /* room for encoded fields in a single ringbuffer entry */
+    if (logger->layout == CLOG_LAYOUT_JSON) {
+        hdrsize = clog_message_json_chunksize(&msgfmt, logger->maxmsgsize);
+    } else {
+        hdrsize = clog_message_fmt_chunksize(&msgfmt, logger->maxmsgsize);
+    }
+    if (hdrsize == -1) {
+        goto leave_settings;
+    }
+    maxkvlen = logger->maxmsgsize - hdrsize - sizeof(void *);
+
+    msgbuf = clog_logger_msgbuf_pop(logger);
+    if (maxkvlen > msgbuf->size) {
+        maxkvlen = msgbuf->size;
+    }
+
+    va_copy(args, ap);
+    while (nfields-- > 0) {
+        clog_kvfield_t field = va_arg(args, clog_kvfield_t);
+
+        /* field with no room left is skipped, smaller ones might fit */
+        msgfmt.msglen += logger_kv_encode(&field, msgbuf->data + msgfmt.msglen, maxkvlen - msgfmt.msglen);
+    }
+    va_end(args);
+
+    if (supfield.value.i64) {
+        msgfmt.msglen += logger_kv_encode(&supfield, msgbuf->data + msgfmt.msglen, maxkvlen - msgfmt.msglen);
+    }
+
+    if (msgfmt.msglen) {
+        /* encoded fields are copied as they are */
+        msgfmt.msgesclen = msgfmt.msglen;
+        msgfmt.message = msgbuf->data;
+        logger_commit_message(logger, &msgfmt, maxwaitus);
     }
+
+    ringbuf_push_always(logger->mempool, msgbuf);
+
+leave_settings:
+    clog_logger_settings_leave(logger);
+}
+
+
+void clog_logger_log_kv (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const clog_callsite_t *site, int nfields, ...)
+{
+    va_list ap;
+    va_start(ap, nfields);
+    clog_logger_log_vkv_wait(logger, level, clog_msgwait_usec(maxwaitms), site, nfields, ap);
+    va_end(ap);
+}
+
+
+void clog_logger_log_kv_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const clog_callsite_t *site, int nfields, ...)
+{
+    va_list ap;
+    va_start(ap, nfields);
+    clog_logger_log_vkv_wait(logger, level, maxwaitus, site, nfields, ap);
+    va_end(ap);
 }
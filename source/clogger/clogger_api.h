@@ -96,6 +96,13 @@ typedef struct _logger_conf_t    * clogger_conf;
 # define CLOG_MSGBUF_SIZE_MAX        32640
 #endif
 
+/* max size of message kept out of ring buffer (maxspillsize).
+ *  only TEXT records spill: KV record keeps only fields fit in maxmsgsize
+ *  and BINARY record has text cut at maxmsgsize, both without notice. */
+#ifndef CLOG_SPILL_SIZE_MAX
+# define CLOG_SPILL_SIZE_MAX         67108864
+#endif
+
 /* max and enough size for datetime format */
 #define CLOG_DATEFMT_SIZE_MAX        48
 
@@ -105,9 +112,10 @@ typedef struct _logger_conf_t    * clogger_conf;
 /* nowait to log one message */
 #define CLOG_MSGWAIT_NOWAIT          0
 
-/* wait interval in ms to push msg: 1 up to 50 is good */
+/* wait at most 1 ms to push msg when queue is full */
 #define CLOG_MSGWAIT_INSTANT         (1)
 
+
 /**
  * bit flags configuration for logger
  */
@@ -156,6 +164,15 @@ typedef struct _logger_conf_t    * clogger_conf;
 /* __FUNCTION__ */
 #define CLOG_FUNCTION_NAME           0x2000
 
+/* rolling file of binary blocks decoded by clogcat */
+#define CLOG_APPENDER_BINFILE        0x4000
+
+/* logger_manager_autoreload: reload when config file is written */
+#define CLOG_RELOAD_CFGFILE          0x01
+
+/* logger_manager_autoreload: reload when SIGHUP is received */
+#define CLOG_RELOAD_SIGHUP           0x02
+
 
 /**
  * never change below lines
@@ -181,12 +198,89 @@ typedef struct _logger_conf_t    * clogger_conf;
 #define ROF_MAXFILECOUNT           1000000
 
 
+/**
+ * layout of message:
+ *   PLAIN: message only
+ *   DATED: 2019-12-26 14:33:56+08:00 INFO <ident> (main.c:69::main) [1899/1] message
+ *   JSON:  {"ts":"2019-12-26 14:33:56+08:00","level":"INFO","ident":"app","file":"main.c","line":69,"func":"main","pid":1899,"tid":1,"msg":"message"}
+ *   BINARY: raw timestamp, call site, format and captured arguments. text
+ *           appenders get DATED line formatted by logthread.
+ */
 typedef enum {
-    CLOG_LAYOUT_PLAIN = 0,
-    CLOG_LAYOUT_DATED = 1
+    CLOG_LAYOUT_PLAIN  = 0,
+    CLOG_LAYOUT_DATED  = 1,
+    CLOG_LAYOUT_JSON   = 2,
+    CLOG_LAYOUT_BINARY = 3
 } clog_layout_t;
 
 
+/**
+ * how key-value fields are rendered by backend:
+ *   LOGFMT: key1=123 key2="hello world" key3=true
+ *   JSON:   {"key1":123,"key2":"hello world","key3":true}
+ */
+typedef enum {
+    CLOG_KVFORMAT_LOGFMT = 0,
+    CLOG_KVFORMAT_JSON   = 1
+} clog_kvformat_t;
+
+
+/**
+ * clock source for timestamp of message:
+ *   REALTIME: clock_gettime(CLOCK_REALTIME) (default)
+ *   COARSE:   CLOCK_REALTIME_COARSE, resolution of kernel tick (1-4 ms)
+ *   TSC:      invariant TSC converted by calibration of rtclock thread
+ *   RTCLOCK:  time published by rtclock thread every millisecond
+ */
+typedef enum {
+    CLOG_CLOCKSOURCE_REALTIME = 0,
+    CLOG_CLOCKSOURCE_COARSE   = 1,
+    CLOG_CLOCKSOURCE_TSC      = 2,
+    CLOG_CLOCKSOURCE_RTCLOCK  = 3
+} clog_clocksource_t;
+
+
+/**
+ * value types for key-value field
+ */
+typedef enum {
+    CLOG_KV_INT64  = 1,
+    CLOG_KV_DOUBLE = 2,
+    CLOG_KV_STRING = 3,
+    CLOG_KV_BOOL   = 4
+} clog_kvtype_t;
+
+
+/**
+ * one typed key-value field for structured logging.
+ *   string value is a slice: (str, length). length = -1 means strlen(str).
+ *   see: CLOG_KV_INT, CLOG_KV_DBL, CLOG_KV_STR, ... in logger_helper.h
+ */
+typedef struct
+{
+    const char *key;
+    clog_kvtype_t type;
+    int length;
+
+    union {
+        int64_t i64;
+        double dbl;
+        const char *str;
+    } value;
+} clog_kvfield_t;
+
+
+/**
+ * static call site of a log statement
+ */
+typedef struct
+{
+    const char *filename;
+    const char *funcname;
+    int lineno;
+} clog_callsite_t;
+
+
 typedef enum {
     CLOG_DATEFMT_RFC_3339  = 0,    /* `date --rfc-3339=seconds` = "2019-12-26 10:13:41+08:00" */
     CLOG_DATEFMT_ISO_8601  = 1,    /* `date --iso-8601=seconds  = "2019-12-26T10:14:32+08:00" */
@@ -209,6 +303,35 @@ typedef enum {
 } clog_level_t;
 
 
+/**
+ * stable head of every clog_logger. gatelevel is the highest level which can
+ *  pass now: level of settings or level set by cloggerctl. sitegen is not 0
+ *  while call sites are switched by cloggerctl, and changes with them.
+ */
+typedef struct _clog_logger_head_t
+{
+    volatile int gatelevel;
+    volatile int sitegen;
+} clog_logger_head;
+
+/* inline check without calling into library. callee checks level fully */
+#define clog_logger_level_gate(logger, level)  \
+    ((logger) && ((const clog_logger_head *)(logger))->gatelevel >= (int)(level))
+
+
+/* static of call site: (sitegen << 1) | 1 if site was switched on */
+typedef volatile int clog_sitegate_t;
+
+/**
+ * inline check of call site below gatelevel. site is looked up by library
+ *  only once after sitegen changes.
+ */
+#define clog_logger_site_gate(logger, sitegate, filename, lineno)  \
+    ((logger) && ((const clog_logger_head *)(logger))->sitegen && \
+        ((*(sitegate) >> 1) == ((const clog_logger_head *)(logger))->sitegen? \
+            (*(sitegate) & 1) : clog_logger_site_gate_update((logger), (sitegate), (filename), (lineno))))
+
+
 /**
  * "\033[0;31m RED         \033[0m"
  * "\033[1;31m LIGHT RED   \033[0m"
@@ -284,7 +407,8 @@ CLOGGER_API const char * logger_manager_init (const char *logger_cfg, ...);
  *
  *    YOU SHOULD NEVER CALL THIS METHOD IN ANY DLL (OR SO) MODULES.
  *
- *     Finalize all loggers within manager.
+ *     Finalize all loggers within manager. Messages queued are written to
+ *       appenders before loggers are destroyed.
  *     This function should be called like the following:
  *         atexit(logger_manager_uninit);
  *
@@ -336,6 +460,46 @@ CLOGGER_API clog_logger  logger_manager_get (int loggerid);
 CLOGGER_API int logger_manager_get_stampid (char *stampidfmt, int fmtsize);
 
 
+/*!
+ * @brief logger_manager_reload
+ *     Parse config file again and publish new settings to loaded loggers.
+ *     loglevel, appender, rollingpolicy, dateformat, kvformat, timeunit and
+ *       flags are applied. Callers never wait for reloading.
+ *     maxmsgsize, queuelength, layout, clocksource, rawtimestamp and ROFILE
+ *       or SHMLOG not opened by load are kept until process restarted.
+ *
+ * @return
+ *    -<em>count of loggers with kept keys (0 if all applied)</em> succeed
+ *    -<em>-1</em> fail
+ */
+CLOGGER_API int logger_manager_reload (void);
+
+
+/*!
+ * @brief logger_manager_autoreload
+ *     Start a thread calling logger_manager_reload() on events of flags:
+ *       CLOG_RELOAD_CFGFILE | CLOG_RELOAD_SIGHUP. Stop it if flags is 0.
+ *
+ * @return
+ *    -<em>0</em> succeed
+ *    -<em>-1</em> fail
+ */
+CLOGGER_API int logger_manager_autoreload (int flags);
+
+
+/*!
+ * @brief logger_manager_flush_all
+ *     Wait until messages logged before this call by all loaded loggers are
+ *       written to appenders (see: clog_logger_flush). timeout_ms is shared
+ *       by all loggers, -1 for no timeout.
+ *
+ * @return
+ *    -<em>0</em> all flushed
+ *    -<em>-1</em> timeout or not initialized
+ */
+CLOGGER_API int logger_manager_flush_all (int timeout_ms);
+
+
 /**
  * logger conf api
  */
@@ -350,6 +514,7 @@ CLOGGER_API int  logger_conf_load_config (const char *cfgfile, const char *ident
  */
 CLOGGER_API clog_logger clog_logger_create (clogger_conf conf, logger_manager mgr);
 CLOGGER_API void clog_logger_destroy (clog_logger logger);
+CLOGGER_API int clog_logger_reload (clog_logger logger, clogger_conf conf);
 
 CLOGGER_API void* logger_attach_data(clog_logger logger, void* data);
 
@@ -358,9 +523,72 @@ CLOGGER_API const char * clog_logger_get_ident (clog_logger logger);
 CLOGGER_API int clog_logger_get_maxmsgsize (clog_logger logger);
 CLOGGER_API int64_t clog_logger_get_logmessages (clog_logger logger, int64_t *round);
 CLOGGER_API int clog_logger_level_enabled(clog_logger logger, clog_level_t level);
+CLOGGER_API int clog_logger_site_enabled(clog_logger logger, clog_level_t level, const char *filename, int lineno);
+
+/* called by clog_logger_site_gate: returns 1 if site is switched on */
+CLOGGER_API int clog_logger_site_gate_update(clog_logger logger, clog_sitegate_t *sitegate, const char *filename, int lineno);
+
+/**
+ * limit lines of call site (source file basename and line) per second and
+ *  sample them as "1/N" or by probability like "0.05". site policy overrides
+ *  ratelimit, rateburst and sampling of logger. removes policy of site if no
+ *  limit given. returns 1 if set, 0 if sampling is bad, -1 if no room.
+ */
+CLOGGER_API int clog_logger_set_site_rate (clog_logger logger, const char *filename, int lineno, int ratelimit, int rateburst, const char *sampling);
+
+/**
+ * wait until messages logged before this call are written to appenders by
+ *  logthread (partial block of BINFILE and duplicates counted included).
+ *  timeout_ms -1 waits forever. returns 0 if flushed or -1 for timeout.
+ */
+CLOGGER_API int clog_logger_flush (clog_logger logger, int timeout_ms);
+
+/**
+ * messages logged to logger by calling thread between clog_batch_begin and
+ *  clog_batch_end are kept in order in a buffer of the thread and given to
+ *  logthread by one ring write and one wakeup at end, or earlier when the
+ *  buffer is full, before message of priority lane and after WARN and above.
+ *  batch may be nested and must end before logger is destroyed.
+ *  clog_batch_begin returns 0, or -1 if thread is in batch of other logger.
+ */
+CLOGGER_API int clog_batch_begin (clog_logger logger);
+CLOGGER_API void clog_batch_end (void);
+
+/**
+ * maxwaitms: milliseconds (0 .. 65534) caller waits for room when queue is
+ *  full, CLOG_MSGWAIT_INFINITE (65535) waits forever. caller spins, yields
+ *  and then parks till logthread frees room.
+ * functions of _usec take maxwaitus in microseconds instead, -1 forever.
+ */
 CLOGGER_API void clog_logger_log_message (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *message, int msglen);
 CLOGGER_API void clog_logger_log_format (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const char *filename, int lineno, const char *funcname, const char *format, ...);
 
+CLOGGER_API void clog_logger_log_message_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *message, int msglen);
+CLOGGER_API void clog_logger_log_format_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const char *filename, int lineno, const char *funcname, const char *format, ...);
+
+/*!
+ * @brief clog_logger_log_kv
+ *     Log nfields of clog_kvfield_t (passed by value) as a structured message.
+ *     Fields are stored in compact binary form and rendered by the logger thread
+ *     as logfmt or json (see: kvformat in clogger.cfg). No vsnprintf is called.
+ */
+CLOGGER_API void clog_logger_log_kv (clog_logger logger, clog_level_t level, uint16_t maxwaitms, const clog_callsite_t *site, int nfields, ...);
+CLOGGER_API void clog_logger_log_kv_usec (clog_logger logger, clog_level_t level, int64_t maxwaitus, const clog_callsite_t *site, int nfields, ...);
+
+
+/**
+ * diagnostic context (MDC) of calling thread: fields put are appended to
+ *  every message logged by the thread (DATED, JSON and BINARY layout) as
+ *  "[reqid=abc tenant=t1]" or "mdc":{...}. value NULL removes key.
+ *  push saves fields for a nested scope and pop restores them.
+ * returns:
+ *  clog_mdc_put: 1 if done, 0 if no room. clog_mdc_push: depth or -1.
+ */
+CLOGGER_API int clog_mdc_put (const char *key, const char *value);
+CLOGGER_API void clog_mdc_clear (void);
+CLOGGER_API int clog_mdc_push (void);
+CLOGGER_API void clog_mdc_pop (void);
+
 
 /**
  * real time clock api
@@ -381,7 +609,11 @@ CLOGGER_API const char * clog_logger_file_basename (const char *pathfile, int *n
 CLOGGER_API void clog_set_levelcolor (clog_logger logger, clog_level_t level, clog_color_t color);
 CLOGGER_API void clog_set_levelstyle (clog_logger logger, clog_level_t level, clog_style_t style);
 CLOGGER_API int clog_level_from_string (const char *levelstring, int length, clog_level_t *level);
+CLOGGER_API const char * clog_level_to_string (clog_level_t level, int *length);
 CLOGGER_API int clog_layout_from_string (const char *layoutstring, int length, clog_layout_t *layout);
+CLOGGER_API int clog_kvformat_from_string (const char *kvfmtstring, int length, clog_kvformat_t *kvformat);
+
+CLOGGER_API int clog_clocksource_from_string (const char *clksrcstring, int length, clog_clocksource_t *clocksource);
 CLOGGER_API int clog_dateformat_from_string (const char *datefmtstring, int length, clog_dateformat_t *dateformat);
 CLOGGER_API int clog_appender_from_string (const char *appenderstring, int length, int *appender);
 
@@ -44,6 +44,24 @@ extern "C" {
 
 #include "clogger_api.h"
 
+/**
+ * calls of levels above CLOG_COMPILE_LEVEL are removed by compiler and their
+ *  arguments never evaluated, for example keep INFO and above:
+ *
+ *   cc -DCLOG_COMPILE_LEVEL=CLOG_LEVEL_INFO ...
+ */
+#ifndef CLOG_COMPILE_LEVEL
+# define CLOG_COMPILE_LEVEL  CLOG_LEVEL_ALL
+#endif
+
+/**
+ * log statement passes if level is enabled or if its call site is switched
+ *  on by cloggerctl. sitegate is static of the statement.
+ */
+#define CLOG_SITE_PASS(logger, level, sitegate)  \
+    (clog_logger_level_gate((logger), (level)) || \
+        clog_logger_site_gate((logger), (sitegate), __FILE__, __LINE__))
+
 #ifndef CLOG_TRACE_MSGWAIT
 # define CLOG_TRACE_MSGWAIT  CLOG_MSGWAIT_NOWAIT
 #endif
@@ -72,49 +90,56 @@ extern "C" {
 #if defined(_MSC_VER) // MSVC (Windows) =>
 
 #define CLOG_TRACE(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_TRACE)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_TRACE && CLOG_SITE_PASS((logger), CLOG_LEVEL_TRACE, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_TRACE, CLOG_TRACE_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_DEBUG(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_DEBUG)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_DEBUG && CLOG_SITE_PASS((logger), CLOG_LEVEL_DEBUG, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_DEBUG, CLOG_DEBUG_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_INFO(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_INFO)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_INFO && CLOG_SITE_PASS((logger), CLOG_LEVEL_INFO, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_INFO, CLOG_INFO_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_WARN(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_WARN)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_WARN && CLOG_SITE_PASS((logger), CLOG_LEVEL_WARN, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_WARN, CLOG_WARN_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_ERROR(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_ERROR)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_ERROR && CLOG_SITE_PASS((logger), CLOG_LEVEL_ERROR, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_ERROR, CLOG_ERROR_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_FATAL(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_FATAL)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_FATAL && CLOG_SITE_PASS((logger), CLOG_LEVEL_FATAL, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_FATAL, CLOG_FATAL_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
             } while(0)
 
 
 #define CLOG_FATAL_EXIT(logger, message, ...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_FATAL)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_FATAL && CLOG_SITE_PASS((logger), CLOG_LEVEL_FATAL, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_FATAL, CLOG_FATAL_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__); \
                 } \
                 exit(EXIT_FAILURE); \
@@ -123,49 +148,56 @@ extern "C" {
 #else  // GCC (Linux, MingW)
 
 #define CLOG_TRACE(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_TRACE)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_TRACE && CLOG_SITE_PASS((logger), CLOG_LEVEL_TRACE, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_TRACE, CLOG_TRACE_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_DEBUG(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_DEBUG)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_DEBUG && CLOG_SITE_PASS((logger), CLOG_LEVEL_DEBUG, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_DEBUG, CLOG_DEBUG_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_INFO(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_INFO)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_INFO && CLOG_SITE_PASS((logger), CLOG_LEVEL_INFO, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_INFO, CLOG_INFO_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_WARN(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_WARN)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_WARN && CLOG_SITE_PASS((logger), CLOG_LEVEL_WARN, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_WARN, CLOG_WARN_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_ERROR(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_ERROR)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_ERROR && CLOG_SITE_PASS((logger), CLOG_LEVEL_ERROR, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_ERROR, CLOG_ERROR_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_FATAL(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_FATAL)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_FATAL && CLOG_SITE_PASS((logger), CLOG_LEVEL_FATAL, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_FATAL, CLOG_FATAL_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
             } while(0)
 
 
 #define CLOG_FATAL_EXIT(logger, message, args...)  do { \
-                if (clog_logger_level_enabled((logger), CLOG_LEVEL_FATAL)) { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= CLOG_LEVEL_FATAL && CLOG_SITE_PASS((logger), CLOG_LEVEL_FATAL, &clog_sitegate_)) { \
                     clog_logger_log_format((logger), CLOG_LEVEL_FATAL, CLOG_FATAL_MSGWAIT, __FILE__, __LINE__, __FUNCTION__, message, ##args); \
                 } \
                 exit(EXIT_FAILURE); \
@@ -175,6 +207,95 @@ extern "C" {
 ///////////////////////////////////////////////////////////////////////
 
 
+/**
+ * typed key-value fields for structured logging:
+ *
+ *   CLOG_INFO_KV(logger, CLOG_KV_STR("event", "login"), CLOG_KV_INT("uid", uid), CLOG_KV_DBL("cost", 0.25));
+ *
+ * output for kvformat=logfmt:
+ *   ... INFO <ident> (main.c:69::main) event=login uid=1001 cost=0.25
+ *
+ * fields are made by inline functions (clog_kv_int, clog_kv_str, ...) in
+ *  both C and C++. CLOG_KV_NFIELDS needs C++11 (variadic template) in C++.
+ */
+#if defined(_MSC_VER) && !defined(__cplusplus)
+# define CLOG_KV_INLINE  static __inline
+#else
+# define CLOG_KV_INLINE  static inline
+#endif
+
+CLOG_KV_INLINE clog_kvfield_t clog_kv_field (const char *key, clog_kvtype_t type, int length)
+{
+    clog_kvfield_t field;
+    field.key = key;
+    field.type = type;
+    field.length = length;
+    field.value.i64 = 0;
+    return field;
+}
+
+CLOG_KV_INLINE clog_kvfield_t clog_kv_int (const char *key, int64_t v)
+{
+    clog_kvfield_t field = clog_kv_field(key, CLOG_KV_INT64, 0);
+    field.value.i64 = v;
+    return field;
+}
+
+CLOG_KV_INLINE clog_kvfield_t clog_kv_dbl (const char *key, double v)
+{
+    clog_kvfield_t field = clog_kv_field(key, CLOG_KV_DOUBLE, 0);
+    field.value.dbl = v;
+    return field;
+}
+
+CLOG_KV_INLINE clog_kvfield_t clog_kv_bool (const char *key, int b)
+{
+    clog_kvfield_t field = clog_kv_field(key, CLOG_KV_BOOL, 0);
+    field.value.i64 = (b? 1 : 0);
+    return field;
+}
+
+/* string of length n, or strlen(s) if n = -1 */
+CLOG_KV_INLINE clog_kvfield_t clog_kv_strn (const char *key, const char *s, int n)
+{
+    clog_kvfield_t field = clog_kv_field(key, CLOG_KV_STRING, n);
+    field.value.str = s;
+    return field;
+}
+
+#define CLOG_KV_INT(key, v)        clog_kv_int((key), (int64_t)(v))
+#define CLOG_KV_DBL(key, v)        clog_kv_dbl((key), (double)(v))
+#define CLOG_KV_BOOL(key, b)       clog_kv_bool((key), ((b)? 1 : 0))
+#define CLOG_KV_STR(key, s)        clog_kv_strn((key), (s), -1)
+#define CLOG_KV_STRN(key, s, n)    clog_kv_strn((key), (s), (int)(n))
+
+/* count of fields in args (not evaluated) */
+#ifdef __cplusplus
+extern "C++" {
+    template <typename... T> char (&clog_kv_nfields_ (const T&...))[sizeof...(T)];
+}
+# define CLOG_KV_NFIELDS(...)  ((int) sizeof(clog_kv_nfields_(__VA_ARGS__)))
+#else
+# define CLOG_KV_NFIELDS(...)  ((int)(sizeof((clog_kvfield_t[]){__VA_ARGS__}) / sizeof(clog_kvfield_t)))
+#endif
+
+
+#define CLOG_LOG_KV(logger, level, maxwaitms, ...)  do { \
+                static clog_sitegate_t clog_sitegate_ = 0; \
+                if (CLOG_COMPILE_LEVEL >= (level) && CLOG_SITE_PASS((logger), (level), &clog_sitegate_)) { \
+                    static const clog_callsite_t clog_kvsite_ = {__FILE__, __FUNCTION__, __LINE__}; \
+                    clog_logger_log_kv((logger), (level), (maxwaitms), &clog_kvsite_, CLOG_KV_NFIELDS(__VA_ARGS__), __VA_ARGS__); \
+                } \
+            } while(0)
+
+#define CLOG_TRACE_KV(logger, ...)  CLOG_LOG_KV(logger, CLOG_LEVEL_TRACE, CLOG_TRACE_MSGWAIT, __VA_ARGS__)
+#define CLOG_DEBUG_KV(logger, ...)  CLOG_LOG_KV(logger, CLOG_LEVEL_DEBUG, CLOG_DEBUG_MSGWAIT, __VA_ARGS__)
+#define CLOG_INFO_KV(logger, ...)   CLOG_LOG_KV(logger, CLOG_LEVEL_INFO,  CLOG_INFO_MSGWAIT,  __VA_ARGS__)
+#define CLOG_WARN_KV(logger, ...)   CLOG_LOG_KV(logger, CLOG_LEVEL_WARN,  CLOG_WARN_MSGWAIT,  __VA_ARGS__)
+#define CLOG_ERROR_KV(logger, ...)  CLOG_LOG_KV(logger, CLOG_LEVEL_ERROR, CLOG_ERROR_MSGWAIT, __VA_ARGS__)
+#define CLOG_FATAL_KV(logger, ...)  CLOG_LOG_KV(logger, CLOG_LEVEL_FATAL, CLOG_FATAL_MSGWAIT, __VA_ARGS__)
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,211 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbatch.c
+**  messages of calling thread kept for one ring write.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 23:40:12
+** @date      2026-10-18 23:40:12
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/ringbufst.h>
+
+#include <pthread.h>
+
+#include "loggerbatch.h"
+
+
+typedef struct
+{
+    void *owner;
+    int depth;
+
+    /* gives entries kept to owner if thread exits in batch */
+    logger_batch_flush_cb flush_cb;
+
+    /* max wait of entries kept, -1 for infinite */
+    int64_t waitus;
+
+    /* entries kept from head to tail */
+    size_t head;
+    size_t tail;
+
+    size_t size;
+    char *entries;
+} logger_batch_t;
+
+
+static THREAD_LOCAL logger_batch_t threadbatch;
+
+static pthread_once_t batchonce = PTHREAD_ONCE_INIT;
+static pthread_key_t batchkey;
+
+
+/* thread exits: batch not ended is given to owner before buffer is freed */
+static void logger_batch_free_entries (void *arg)
+{
+    logger_batch_t *batch = (logger_batch_t *) arg;
+
+    if (batch->owner && batch->head < batch->tail) {
+        batch->flush_cb(batch->owner);
+    }
+
+    mem_free(batch->entries);
+    bzero(batch, sizeof(*batch));
+}
+
+
+static void logger_batch_init_once (void)
+{
+    pthread_key_create(&batchkey, logger_batch_free_entries);
+}
+
+
+int logger_batch_begin (void *owner, size_t entrysize, logger_batch_flush_cb flush_cb)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    if (batch->depth) {
+        if (batch->owner != owner) {
+            return (-1);
+        }
+        return ++batch->depth;
+    }
+
+    if (entrysize < LOGGERBATCH_SIZE) {
+        entrysize = LOGGERBATCH_SIZE;
+    }
+
+    if (batch->size < entrysize) {
+        if (! batch->entries) {
+            pthread_once(&batchonce, logger_batch_init_once);
+            pthread_setspecific(batchkey, batch);
+        }
+
+        /* entries left are given already */
+        mem_free(batch->entries);
+
+        batch->entries = (char *) mem_alloc_unset(entrysize);
+        batch->size = entrysize;
+        batch->head = batch->tail = 0;
+    }
+
+    batch->owner = owner;
+    batch->flush_cb = flush_cb;
+    batch->depth = 1;
+    return 1;
+}
+
+
+int logger_batch_leave (void)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    if (batch->depth && --batch->depth == 0) {
+        batch->owner = NULL;
+    }
+
+    return batch->depth;
+}
+
+
+void * logger_batch_owner (void)
+{
+    return threadbatch.owner;
+}
+
+
+char * logger_batch_reserve (size_t chunksize)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    if (batch->tail + RINGBUFST_ALIGN_ENTRYSIZE(chunksize) > batch->size) {
+        return NULL;
+    }
+
+    return ((ringbuf_entry_st *) (batch->entries + batch->tail))->chunk;
+}
+
+
+void logger_batch_commit (size_t chunksize, int64_t waitus)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    ringbuf_entry_st *entry = (ringbuf_entry_st *) (batch->entries + batch->tail);
+
+    if (batch->head == batch->tail) {
+        /* first entry */
+        batch->waitus = waitus;
+    } else if (batch->waitus >= 0 && (waitus < 0 || waitus > batch->waitus)) {
+        batch->waitus = waitus;
+    }
+
+    entry->size = chunksize;
+    batch->tail += RINGBUFST_ALIGN_ENTRYSIZE(chunksize);
+}
+
+
+const char * logger_batch_entries (size_t *entriessz, int64_t *waitus)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    *entriessz = batch->tail - batch->head;
+    *waitus = batch->waitus;
+
+    return batch->entries + batch->head;
+}
+
+
+void logger_batch_consume (size_t bytes)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    batch->head += bytes;
+
+    if (batch->head >= batch->tail) {
+        batch->head = batch->tail = 0;
+    }
+}
+
+
+int logger_batch_discard (void)
+{
+    logger_batch_t *batch = &threadbatch;
+
+    int num = 0;
+
+    while (batch->head < batch->tail) {
+        const ringbuf_entry_st *entry = (const ringbuf_entry_st *) (batch->entries + batch->head);
+
+        batch->head += RINGBUFST_ALIGN_ENTRYSIZE(entry->size);
+        num++;
+    }
+
+    batch->head = batch->tail = 0;
+    return num;
+}
@@ -0,0 +1,109 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbatch.h
+**  private api for messages of calling thread kept between
+**  clog_batch_begin and clog_batch_end.
+**
+**  Messages are made into ring entries in a buffer of thread and given to
+**  logthread by one ringbufst_write_entries() when the batch ends or the
+**  buffer is full.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 23:40:12
+** @date      2026-10-18 23:40:12
+*/
+#ifndef _LOGGERBATCH_PRIVATE_H_
+#define _LOGGERBATCH_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "clogger_api.h"
+
+/* bytes of entries kept by one thread (at least one entry of maxmsgsize) */
+#define LOGGERBATCH_SIZE    65536
+
+
+typedef void (*logger_batch_flush_cb) (void *owner);
+
+
+/**
+ * logger_batch_begin
+ *   start (or nest) batch of owner for calling thread. buffer is made to
+ *   hold entrysize bytes at least. flush_cb is called with owner when
+ *   thread exits before batch is left, then buffer is freed.
+ * returns:
+ *   depth of batch. -1 if thread is in batch of other owner.
+ */
+extern int logger_batch_begin (void *owner, size_t entrysize, logger_batch_flush_cb flush_cb);
+
+
+/**
+ * logger_batch_leave
+ *   returns depth left. owner is unset at 0 while entries are kept for
+ *   logger_batch_entries().
+ */
+extern int logger_batch_leave (void);
+
+
+/* owner of batch of calling thread or NULL */
+extern void * logger_batch_owner (void);
+
+
+/**
+ * logger_batch_reserve
+ *   chunk of chunksize bytes for next entry, which is kept only after
+ *   logger_batch_commit(). NULL if no room left.
+ */
+extern char * logger_batch_reserve (size_t chunksize);
+
+
+/* keep entry made in reserved chunk. waitus (-1 infinite) is max of batch */
+extern void logger_batch_commit (size_t chunksize, int64_t waitus);
+
+
+/**
+ * logger_batch_entries
+ *   entries kept not given yet, their bytes and max waitus of them.
+ */
+extern const char * logger_batch_entries (size_t *entriessz, int64_t *waitus);
+
+
+/* forget bytes of entries given from the first one */
+extern void logger_batch_consume (size_t bytes);
+
+
+/* forget all entries kept. returns number of them */
+extern int logger_batch_discard (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERBATCH_PRIVATE_H_ */
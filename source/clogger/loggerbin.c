@@ -0,0 +1,568 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbin.c
+**  binary log file format: block writer and decoder.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 11:20:05
+** @date      2026-10-18 11:20:05
+*/
+#include <common/memapi.h>
+#include <common/varint.h>
+#include <common/crc32c.h>
+#include <common/uthash_incl.h>
+
+#include "loggerbin.h"
+
+/* clear interned call sites if too many (dynamic format strings) */
+#define LOGGER_BIN_SITES_MAX       65536
+
+/* sanity limit of payload for decoder */
+#define LOGGER_BIN_PAYLOAD_MAX     (LOGGER_BIN_BLOCKSIZE_MAX * 3)
+
+
+typedef struct _logger_bin_site_t
+{
+    /* makes this structure hashable */
+    UT_hash_handle hh;
+
+    /* block in which dict entry was written last time */
+    ub8 blockseq;
+    ub4 dictidx;
+
+    /* lineno(4) | filelen(2) | funclen(2) | file | func | fmt */
+    int keylen;
+    char key[0];
+} logger_bin_site_t;
+
+
+typedef struct _logger_bin_writer_t
+{
+    logger_dated_opts opts;
+
+    size_t blocksize;
+    size_t maxrecsize;
+
+    logger_bin_block_cb blockcb;
+    void *cbarg;
+
+    /* interned call sites */
+    logger_bin_site_t *sites;
+    ub4 numsites;
+
+    /* block in building */
+    ub8 blockseq;
+    ub4 ndict;
+    ub4 nrecs;
+    ub8 firstts;
+    ub8 prevts;
+    ub8 prevstampid;
+    ub8 prevseq;
+
+    size_t dictlen;
+    size_t dictcap;
+    ub1 *dictbuf;
+
+    size_t reclen;
+    size_t reccap;
+    ub1 *recbuf;
+
+    ub1 *keybuf;
+
+    size_t blkcap;
+    ub1 *blkbuf;
+} logger_bin_writer_t;
+
+
+static void bin_put_varint (ub1 *buf, size_t *len, ub8 u)
+{
+    *len += varint_encode64(u, buf + *len);
+}
+
+
+static void bin_put_str (ub1 *buf, size_t *len, const char *s, size_t n)
+{
+    *len += varint_encode64((ub8) n, buf + *len);
+    memcpy(buf + *len, s, n);
+    *len += n;
+}
+
+
+static void bin_put_le32 (ub1 *buf, ub4 v)
+{
+    buf[0] = (ub1) v;
+    buf[1] = (ub1) (v >> 8);
+    buf[2] = (ub1) (v >> 16);
+    buf[3] = (ub1) (v >> 24);
+}
+
+
+static ub4 bin_get_le32 (const ub1 *buf)
+{
+    return (ub4) buf[0] | ((ub4) buf[1] << 8) | ((ub4) buf[2] << 16) | ((ub4) buf[3] << 24);
+}
+
+
+static int bin_get_varint (const ub1 **p, const ub1 *end, ub8 *u)
+{
+    int n = varint_decode64(*p, (size_t)(end - *p), u);
+    *p += n;
+    return n;
+}
+
+
+static int bin_get_str (const ub1 **p, const ub1 *end, const char **s, int *n)
+{
+    ub8 u;
+    if (! bin_get_varint(p, end, &u) || u > (ub8)(end - *p)) {
+        return 0;
+    }
+    *s = (const char *) *p;
+    *n = (int) u;
+    *p += u;
+    return 1;
+}
+
+
+static void bin_sites_clear (logger_bin_writer_t *writer)
+{
+    logger_bin_site_t *site, *tmp;
+
+    HASH_ITER(hh, writer->sites, site, tmp) {
+        HASH_DEL(writer->sites, site);
+        mem_free(site);
+    }
+
+    writer->sites = NULL;
+    writer->numsites = 0;
+}
+
+
+void logger_bin_record_view (const char *recbuf, size_t reclen, logger_record *rec)
+{
+    logger_bin_record binrec;
+    const char *data = recbuf + sizeof(binrec);
+
+    memcpy(&binrec, recbuf, sizeof(binrec));
+
+    rec->timestamp = binrec.timestamp;
+    rec->stampid = binrec.stampid;
+    rec->threadid = binrec.threadid;
+    rec->lineno = binrec.lineno;
+    rec->level = (clog_level_t) binrec.level;
+    rec->flags = binrec.flags;
+
+    rec->filelen = binrec.filelen;
+    rec->file = data;
+    rec->funclen = binrec.funclen;
+    rec->func = data + binrec.filelen;
+    rec->mdclen = binrec.mdclen;
+    rec->mdc = rec->func + binrec.funclen;
+    rec->fmtlen = binrec.fmtlen;
+    rec->fmt = rec->mdc + binrec.mdclen;
+
+    rec->args = rec->fmt + binrec.fmtlen;
+    rec->argslen = reclen - (rec->args - recbuf);
+}
+
+
+logger_bin_writer logger_bin_writer_create (const logger_dated_opts *opts, size_t blocksize, size_t maxrecsize, logger_bin_block_cb blockcb, void *arg)
+{
+    logger_bin_writer_t *writer = (logger_bin_writer_t *) mem_alloc_zero(1, sizeof(*writer));
+
+    writer->opts = *opts;
+    writer->opts.tzfmt = mem_strdup_len(opts->tzfmt, opts->tzfmtlen);
+    writer->opts.ident = mem_strdup_len(opts->ident, opts->identlen);
+    writer->opts.pidcstr = mem_strdup_len(opts->pidcstr, opts->pidcstrlen);
+
+    writer->blocksize = blocksize;
+    writer->maxrecsize = maxrecsize;
+    writer->blockcb = blockcb;
+    writer->cbarg = arg;
+
+    writer->blockseq = 1;
+
+    /* a record never exceeds maxrecsize, so a block is at most one record beyond blocksize */
+    writer->dictcap = blocksize + maxrecsize + 64;
+    writer->reccap = blocksize + maxrecsize + 64;
+
+    writer->dictbuf = (ub1 *) mem_alloc_unset(writer->dictcap);
+    writer->recbuf = (ub1 *) mem_alloc_unset(writer->reccap);
+    writer->keybuf = (ub1 *) mem_alloc_unset(maxrecsize + 16);
+
+    writer->blkcap = LOGGER_BIN_BLKHDR_SIZE + 128 + opts->tzfmtlen + opts->identlen + opts->pidcstrlen + writer->dictcap + writer->reccap;
+    writer->blkbuf = (ub1 *) mem_alloc_unset(writer->blkcap);
+
+    return writer;
+}
+
+
+void logger_bin_writer_free (logger_bin_writer writer)
+{
+    if (writer) {
+        logger_bin_writer_flush(writer);
+        bin_sites_clear(writer);
+
+        mem_free((void *) writer->opts.tzfmt);
+        mem_free((void *) writer->opts.ident);
+        mem_free((void *) writer->opts.pidcstr);
+
+        mem_free(writer->dictbuf);
+        mem_free(writer->recbuf);
+        mem_free(writer->keybuf);
+        mem_free(writer->blkbuf);
+        mem_free(writer);
+    }
+}
+
+
+void logger_bin_writer_append (logger_bin_writer writer, const logger_record *rec)
+{
+    logger_bin_site_t *site = NULL;
+    int keylen;
+
+    size_t dictneed = 4 * VARINT_SIZE_MAX + rec->filelen + rec->funclen + rec->fmtlen;
+    size_t recneed = 7 * VARINT_SIZE_MAX + 2 + rec->mdclen + rec->argslen;
+
+    if (writer->dictlen + dictneed > writer->dictcap || writer->reclen + recneed > writer->reccap) {
+        logger_bin_writer_flush(writer);
+
+        if (dictneed > writer->dictcap || recneed > writer->reccap) {
+            /* never happen: record is too large */
+            return;
+        }
+    }
+
+    /* intern call site by content: format pointer may be not static */
+    memcpy(writer->keybuf, &rec->lineno, 4);
+    writer->keybuf[4] = (ub1) rec->filelen;
+    writer->keybuf[5] = (ub1) (rec->filelen >> 8);
+    writer->keybuf[6] = (ub1) rec->funclen;
+    writer->keybuf[7] = (ub1) (rec->funclen >> 8);
+    keylen = 8;
+    memcpy(writer->keybuf + keylen, rec->file, rec->filelen);
+    keylen += rec->filelen;
+    memcpy(writer->keybuf + keylen, rec->func, rec->funclen);
+    keylen += rec->funclen;
+    memcpy(writer->keybuf + keylen, rec->fmt, rec->fmtlen);
+    keylen += rec->fmtlen;
+
+    HASH_FIND(hh, writer->sites, writer->keybuf, keylen, site);
+    if (! site) {
+        if (writer->numsites >= LOGGER_BIN_SITES_MAX) {
+            /* dict entries already written in block are still valid */
+            bin_sites_clear(writer);
+        }
+
+        site = (logger_bin_site_t *) mem_alloc_zero(1, sizeof(*site) + keylen);
+        site->keylen = keylen;
+        memcpy(site->key, writer->keybuf, keylen);
+
+        HASH_ADD(hh, writer->sites, key, keylen, site);
+        writer->numsites++;
+    }
+
+    if (site->blockseq != writer->blockseq) {
+        /* first use of site in this block */
+        site->blockseq = writer->blockseq;
+        site->dictidx = writer->ndict++;
+
+        bin_put_varint(writer->dictbuf, &writer->dictlen, rec->lineno);
+        bin_put_str(writer->dictbuf, &writer->dictlen, rec->file, rec->filelen);
+        bin_put_str(writer->dictbuf, &writer->dictlen, rec->func, rec->funclen);
+        bin_put_str(writer->dictbuf, &writer->dictlen, rec->fmt, rec->fmtlen);
+    }
+
+    if (! writer->nrecs) {
+        writer->firstts = rec->timestamp;
+        writer->prevts = rec->timestamp;
+        writer->prevstampid = 0;
+        writer->prevseq = 0;
+    }
+
+    bin_put_varint(writer->recbuf, &writer->reclen, site->dictidx);
+    writer->recbuf[writer->reclen++] = (ub1) rec->level;
+    writer->recbuf[writer->reclen++] = (ub1) rec->flags;
+
+    /* records from many threads are not strictly ordered in time */
+    bin_put_varint(writer->recbuf, &writer->reclen, zigzag_encode64((sb8)(rec->timestamp - writer->prevts)));
+    writer->prevts = rec->timestamp;
+
+    bin_put_varint(writer->recbuf, &writer->reclen, rec->threadid);
+
+    if (writer->opts.flags & LOGGER_DATED_TIMESTAMPID) {
+        bin_put_varint(writer->recbuf, &writer->reclen, zigzag_encode64((sb8)(rec->stampid - writer->prevstampid)));
+        writer->prevstampid = rec->stampid;
+    }
+
+    if (writer->opts.flags & LOGGER_DATED_SEQUENCE) {
+        /* records of priority lane come ahead of bulk ones */
+        bin_put_varint(writer->recbuf, &writer->reclen, zigzag_encode64((sb8)(rec->seq - writer->prevseq)));
+        writer->prevseq = rec->seq;
+    }
+
+    if (rec->flags & LOGGER_RECORD_MDC) {
+        bin_put_str(writer->recbuf, &writer->reclen, rec->mdc, rec->mdclen);
+    }
+
+    bin_put_str(writer->recbuf, &writer->reclen, rec->args, rec->argslen);
+
+    writer->nrecs++;
+
+    if (writer->reclen >= writer->blocksize || writer->dictlen >= writer->blocksize) {
+        logger_bin_writer_flush(writer);
+    }
+}
+
+
+void logger_bin_writer_flush (logger_bin_writer writer)
+{
+    ub1 *payload = writer->blkbuf + LOGGER_BIN_BLKHDR_SIZE;
+    size_t len = 0;
+
+    if (! writer->nrecs) {
+        return;
+    }
+
+    payload[len++] = LOGGER_BIN_VERSION;
+
+    bin_put_varint(payload, &len, writer->opts.flags);
+    payload[len++] = (ub1) writer->opts.dateformat;
+    payload[len++] = (ub1) writer->opts.kvformat;
+    bin_put_varint(payload, &len, zigzag_encode64(writer->opts.timezone));
+    payload[len++] = (ub1) writer->opts.daylight;
+    bin_put_str(payload, &len, writer->opts.tzfmt, writer->opts.tzfmtlen);
+    bin_put_str(payload, &len, writer->opts.ident, writer->opts.identlen);
+    bin_put_str(payload, &len, writer->opts.pidcstr, writer->opts.pidcstrlen);
+    bin_put_varint(payload, &len, writer->firstts);
+
+    bin_put_varint(payload, &len, writer->ndict);
+    memcpy(payload + len, writer->dictbuf, writer->dictlen);
+    len += writer->dictlen;
+
+    bin_put_varint(payload, &len, writer->nrecs);
+    memcpy(payload + len, writer->recbuf, writer->reclen);
+    len += writer->reclen;
+
+    memcpy(writer->blkbuf, LOGGER_BIN_MAGIC, 4);
+    bin_put_le32(writer->blkbuf + 4, (ub4) len);
+    bin_put_le32(writer->blkbuf + 8, crc32c(0, payload, len));
+
+    writer->blockcb(writer->cbarg, writer->firstts, (const char *) writer->blkbuf, LOGGER_BIN_BLKHDR_SIZE + len);
+
+    writer->ndict = 0;
+    writer->nrecs = 0;
+    writer->dictlen = 0;
+    writer->reclen = 0;
+    writer->blockseq++;
+}
+
+
+int logger_bin_block_check (const char *buf, size_t len, size_t *blocklen)
+{
+    const ub1 *hdr = (const ub1 *) buf;
+    ub4 payloadlen;
+
+    *blocklen = 0;
+
+    if (len < LOGGER_BIN_BLKHDR_SIZE) {
+        return 0;
+    }
+
+    if (memcmp(hdr, LOGGER_BIN_MAGIC, 4)) {
+        return (-1);
+    }
+
+    payloadlen = bin_get_le32(hdr + 4);
+    if (payloadlen > LOGGER_BIN_PAYLOAD_MAX) {
+        return (-1);
+    }
+
+    *blocklen = LOGGER_BIN_BLKHDR_SIZE + payloadlen;
+    if (len < *blocklen) {
+        return 0;
+    }
+
+    if (crc32c(0, hdr + LOGGER_BIN_BLKHDR_SIZE, payloadlen) != bin_get_le32(hdr + 8)) {
+        return (-1);
+    }
+
+    return 1;
+}
+
+
+typedef struct
+{
+    ub4 lineno;
+    int filelen;
+    const char *file;
+    int funclen;
+    const char *func;
+    int fmtlen;
+    const char *fmt;
+} logger_bin_dictent;
+
+
+int logger_bin_block_decode (const char *block, size_t blocklen, logger_bin_record_cb recordcb, void *arg)
+{
+    const ub1 *p = (const ub1 *) block + LOGGER_BIN_BLKHDR_SIZE;
+    const ub1 *end = (const ub1 *) block + blocklen;
+
+    logger_dated_opts opts;
+    logger_record rec;
+    logger_bin_dictent *dict = NULL;
+
+    ub8 u, ndict, nrecs, i;
+    ub8 prevts, prevstampid = 0, prevseq = 0;
+
+    int numrecs = -1;
+
+    memset(&opts, 0, sizeof(opts));
+
+    /* blocks of version 1 have no record with context */
+    if (p + 4 > end || ! *p || *p > LOGGER_BIN_VERSION) {
+        return (-1);
+    }
+    p++;
+
+    if (! bin_get_varint(&p, end, &u)) {
+        return (-1);
+    }
+    opts.flags = (ub4) u;
+
+    if (end - p < 2) {
+        return (-1);
+    }
+    opts.dateformat = (clog_dateformat_t) *p++;
+    opts.kvformat = (clog_kvformat_t) *p++;
+
+    if (! bin_get_varint(&p, end, &u) || p == end) {
+        return (-1);
+    }
+    opts.timezone = (int) zigzag_decode64(u);
+    opts.daylight = *p++;
+
+    if (! bin_get_str(&p, end, &opts.tzfmt, &opts.tzfmtlen) ||
+        ! bin_get_str(&p, end, &opts.ident, &opts.identlen) ||
+        ! bin_get_str(&p, end, &opts.pidcstr, &opts.pidcstrlen) ||
+        ! bin_get_varint(&p, end, &prevts) ||
+        ! bin_get_varint(&p, end, &ndict)) {
+        return (-1);
+    }
+
+    /* each dict entry has at least 4 bytes */
+    if (ndict > (ub8)(end - p) / 4) {
+        return (-1);
+    }
+
+    if (ndict) {
+        dict = (logger_bin_dictent *) mem_alloc_zero((size_t) ndict, sizeof(*dict));
+    }
+
+    for (i = 0; i < ndict; i++) {
+        if (! bin_get_varint(&p, end, &u) ||
+            ! bin_get_str(&p, end, &dict[i].file, &dict[i].filelen) ||
+            ! bin_get_str(&p, end, &dict[i].func, &dict[i].funclen) ||
+            ! bin_get_str(&p, end, &dict[i].fmt, &dict[i].fmtlen)) {
+            goto bad_block;
+        }
+        dict[i].lineno = (ub4) u;
+    }
+
+    if (! bin_get_varint(&p, end, &nrecs)) {
+        goto bad_block;
+    }
+
+    for (i = 0; i < nrecs; i++) {
+        ub8 idx;
+        int argslen;
+
+        memset(&rec, 0, sizeof(rec));
+
+        if (! bin_get_varint(&p, end, &idx) || idx >= ndict || end - p < 2) {
+            goto bad_block;
+        }
+        rec.level = (clog_level_t) *p++;
+        rec.flags = *p++;
+
+        if (! bin_get_varint(&p, end, &u)) {
+            goto bad_block;
+        }
+        prevts += (ub8) zigzag_decode64(u);
+        rec.timestamp = prevts;
+
+        if (! bin_get_varint(&p, end, &u)) {
+            goto bad_block;
+        }
+        rec.threadid = (ub4) u;
+
+        if (opts.flags & LOGGER_DATED_TIMESTAMPID) {
+            if (! bin_get_varint(&p, end, &u)) {
+                goto bad_block;
+            }
+            prevstampid += (ub8) zigzag_decode64(u);
+            rec.stampid = prevstampid;
+        }
+
+        if (opts.flags & LOGGER_DATED_SEQUENCE) {
+            if (! bin_get_varint(&p, end, &u)) {
+                goto bad_block;
+            }
+            prevseq += (ub8) zigzag_decode64(u);
+            rec.seq = prevseq;
+        }
+
+        if ((rec.flags & LOGGER_RECORD_MDC) && ! bin_get_str(&p, end, &rec.mdc, &rec.mdclen)) {
+            goto bad_block;
+        }
+
+        if (! bin_get_str(&p, end, &rec.args, &argslen)) {
+            goto bad_block;
+        }
+        rec.argslen = (size_t) argslen;
+
+        rec.lineno = dict[idx].lineno;
+        rec.file = dict[idx].file;
+        rec.filelen = dict[idx].filelen;
+        rec.func = dict[idx].func;
+        rec.funclen = dict[idx].funclen;
+        rec.fmt = dict[idx].fmt;
+        rec.fmtlen = dict[idx].fmtlen;
+
+        if (! recordcb(arg, &opts, &rec)) {
+            /* stopped by caller */
+            i++;
+            break;
+        }
+    }
+
+    numrecs = (int) i;
+
+bad_block:
+    mem_free(dict);
+    return numrecs;
+}
@@ -0,0 +1,147 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbin.h
+**  private api for binary log file format.
+**
+**  A binary log file is a sequence of self-describing blocks:
+**
+**    block   := magic("CLGB") | payloadlen(4) | crc32c(4) | payload
+**    payload := version(1) | options | ndict | dict... | nrecs | record...
+**
+**    options := flags | dateformat(1) | kvformat(1) | timezone | daylight(1)
+**               | tzfmt | ident | pid | basets
+**    dict    := lineno | file | func | format
+**    record  := dictidx | level(1) | flags(1) | tsdelta | threadid
+**               [ | stampiddelta ] [ | seqdelta ] [ | mdclen | mdc ]
+**               | argslen | args
+**
+**  integers are varint (LE base-128) and signed ones zigzag encoded,
+**  strings are varint length followed by bytes, payloadlen and crc32c are
+**  4 bytes little-endian. Every block carries the dict entries for the call
+**  sites its records refer to, so any block can be decoded alone and a
+**  corrupted block is skipped without losing the following ones.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 11:20:05
+** @date      2026-10-18 11:20:05
+*/
+#ifndef _LOGGERBIN_PRIVATE_H_
+#define _LOGGERBIN_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "loggerfmt.h"
+
+
+#define LOGGER_BIN_MAGIC             "CLGB"
+/* version 2: record has context fields if flags has LOGGER_RECORD_MDC
+ * version 3: record has sequence if options has LOGGER_DATED_SEQUENCE
+ */
+#define LOGGER_BIN_VERSION           3
+
+/* magic | payloadlen | crc32c */
+#define LOGGER_BIN_BLKHDR_SIZE       12
+
+#define LOGGER_BIN_BLOCKSIZE_MIN     4096
+#define LOGGER_BIN_BLOCKSIZE_DEFAULT 65536
+#define LOGGER_BIN_BLOCKSIZE_MAX     4194304
+
+
+/**
+ * record passed from producer to logthread in ringbuffer
+ */
+typedef struct
+{
+    ub8 timestamp;
+    ub8 stampid;
+    ub4 threadid;
+    ub4 lineno;
+    ub1 level;
+    ub1 flags;
+    ub2 filelen;
+    ub2 funclen;
+    ub2 mdclen;
+    ub2 fmtlen;
+
+    /* file | func | mdc | fmt | args */
+    char data[0];
+} logger_bin_record;
+
+
+/**
+ * logger_bin_record_view
+ *   get record fields from recbuf of reclen bytes. recbuf need not be aligned.
+ */
+extern void logger_bin_record_view (const char *recbuf, size_t reclen, logger_record *rec);
+
+
+typedef struct _logger_bin_writer_t * logger_bin_writer;
+
+/* called with a complete block. firstts is timestamp of the first record */
+typedef int (*logger_bin_block_cb) (void *arg, ub8 firstts, const char *block, size_t blocklen);
+
+extern logger_bin_writer logger_bin_writer_create (const logger_dated_opts *opts, size_t blocksize, size_t maxrecsize, logger_bin_block_cb blockcb, void *arg);
+
+extern void logger_bin_writer_free (logger_bin_writer writer);
+
+/* add record into block, a full block is flushed by itself */
+extern void logger_bin_writer_append (logger_bin_writer writer, const logger_record *rec);
+
+/* write out records appended so far as a block */
+extern void logger_bin_writer_flush (logger_bin_writer writer);
+
+
+/**
+ * logger_bin_block_check
+ *   check block at buf of len bytes.
+ * returns:
+ *   1 - block ok, *blocklen is size of block
+ *   0 - need more bytes, *blocklen is size of block (if header read)
+ *  -1 - bad magic or crc
+ */
+extern int logger_bin_block_check (const char *buf, size_t len, size_t *blocklen);
+
+
+/* called for each record in block */
+typedef int (*logger_bin_record_cb) (void *arg, const logger_dated_opts *opts, const logger_record *rec);
+
+/**
+ * logger_bin_block_decode
+ *   decode records of a checked block.
+ * returns:
+ *   records decoded or -1 if block is malformed.
+ */
+extern int logger_bin_block_decode (const char *block, size_t blocklen, logger_bin_record_cb recordcb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERBIN_PRIVATE_H_ */
@@ -0,0 +1,152 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbt.c
+**  backtrace of records not logged.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 20:12:36
+** @date      2026-10-18 20:12:36
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+
+#include <pthread.h>
+
+#include "loggerbt.h"
+
+
+typedef struct
+{
+    /* 0 if slot is empty */
+    ub4 reclen;
+    ub4 owner;
+    ub8 timestamp;
+    char record[LOGGERBT_RECSIZE];
+} logger_bt_slot;
+
+
+typedef struct
+{
+    /* slot of next record (the oldest one) */
+    int next;
+
+    logger_bt_slot slots[LOGGERBT_SLOTS];
+} logger_bt_ring;
+
+
+/* allocated when thread captures the first record */
+static THREAD_LOCAL logger_bt_ring *threadbtring = NULL;
+
+static pthread_once_t btonce = PTHREAD_ONCE_INIT;
+static pthread_key_t btkey;
+
+
+/* thread exits: its records can never be drained by its ERROR */
+static void logger_bt_free_ring (void *arg)
+{
+    threadbtring = NULL;
+    mem_free(arg);
+}
+
+
+static void logger_bt_init_once (void)
+{
+    pthread_key_create(&btkey, logger_bt_free_ring);
+}
+
+
+char * logger_bt_reserve (void)
+{
+    logger_bt_ring *ring = threadbtring;
+
+    if (! ring) {
+        ring = (logger_bt_ring *) mem_alloc_zero(1, sizeof(logger_bt_ring));
+
+        pthread_once(&btonce, logger_bt_init_once);
+        pthread_setspecific(btkey, ring);
+
+        threadbtring = ring;
+    }
+
+    return ring->slots[ring->next].record;
+}
+
+
+void logger_bt_commit (ub4 owner, ub8 timestamp, size_t reclen)
+{
+    logger_bt_ring *ring = threadbtring;
+
+    if (ring && reclen && reclen <= LOGGERBT_RECSIZE) {
+        logger_bt_slot *slot = &ring->slots[ring->next];
+
+        slot->reclen = (ub4) reclen;
+        slot->owner = owner;
+        slot->timestamp = timestamp;
+
+        ring->next = (ring->next + 1) % LOGGERBT_SLOTS;
+    }
+}
+
+
+int logger_bt_drain (ub4 owner, int maxrecs, ub8 since, logger_bt_drain_cb cb, void *arg)
+{
+    logger_bt_ring *ring = threadbtring;
+
+    int i, skip = 0, passed = 0;
+
+    if (! ring) {
+        return 0;
+    }
+
+    for (i = 0; i < LOGGERBT_SLOTS; i++) {
+        const logger_bt_slot *slot = &ring->slots[i];
+
+        if (slot->reclen && slot->owner == owner && slot->timestamp >= since) {
+            skip++;
+        }
+    }
+
+    skip = (skip > maxrecs? skip - maxrecs : 0);
+
+    for (i = 0; i < LOGGERBT_SLOTS; i++) {
+        logger_bt_slot *slot = &ring->slots[(ring->next + i) % LOGGERBT_SLOTS];
+
+        if (slot->reclen && slot->owner == owner) {
+            if (slot->timestamp >= since) {
+                if (skip) {
+                    skip--;
+                } else {
+                    cb(slot->record, slot->reclen, arg);
+                    passed++;
+                }
+            }
+            slot->reclen = 0;
+        }
+    }
+
+    return passed;
+}
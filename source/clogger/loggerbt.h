@@ -0,0 +1,88 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerbt.h
+**  private api for backtrace of records not logged.
+**
+**  Records of levels below loglevel (up to backtracelevel) are captured by
+**  caller into a ring of calling thread in binary form. When ERROR or FATAL
+**  is logged later by the thread, the last records of same logger are
+**  drained to logthread ahead of it and marked as backtrace.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 20:12:36
+** @date      2026-10-18 20:12:36
+*/
+#ifndef _LOGGERBT_PRIVATE_H_
+#define _LOGGERBT_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "clogger_api.h"
+
+
+/* records kept by one thread for all loggers */
+#define LOGGERBT_SLOTS      64
+
+/* max bytes of one record (args truncated if longer) */
+#define LOGGERBT_RECSIZE    1000
+
+
+typedef void (*logger_bt_drain_cb) (char *record, size_t reclen, void *arg);
+
+
+/**
+ * logger_bt_reserve
+ *   buffer of LOGGERBT_RECSIZE bytes for next record of calling thread,
+ *   which is kept only after logger_bt_commit().
+ */
+extern char * logger_bt_reserve (void);
+
+
+/**
+ * logger_bt_commit
+ *   keep record made in reserved buffer, overwriting the oldest one.
+ */
+extern void logger_bt_commit (ub4 owner, ub8 timestamp, size_t reclen);
+
+
+/**
+ * logger_bt_drain
+ *   pass the last maxrecs records of owner (not older than since) to cb
+ *   from oldest one, which may change them, and forget all records of owner.
+ * returns:
+ *   number of records passed to cb.
+ */
+extern int logger_bt_drain (ub4 owner, int maxrecs, ub8 since, logger_bt_drain_cb cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERBT_PRIVATE_H_ */
@@ -33,6 +33,8 @@
 */
 #include "loggerconf.h"
 
+#include <common/ringbufst.h>
+
 static const char THIS_FILE[] = "loggerconf.c";
 
 #define CLOGGER_SECTION_IDENTS_MAX    512
@@ -95,6 +97,48 @@ static int split_string_chkd (const char * str, int len, char delim, char **outs
 }
 
 
+/* routes = ERROR,FATAL:<IDENT>.error.log; WARN:<IDENT>.warn.log */
+static void logger_conf_parse_routes (const char *value, int len, clogger_conf conf)
+{
+    char *entries[LOGGER_CONF_ROUTES_MAX] = {0};
+    int entrieslen[LOGGER_CONF_ROUTES_MAX] = {0};
+
+    int i, numentries = split_string_chkd(value, len, ';', entries, entrieslen, LOGGER_CONF_ROUTES_MAX);
+
+    for (i = 0; i < numentries && conf->numroutes < LOGGER_CONF_ROUTES_MAX; i++) {
+        char *levelnames[12] = {0};
+        int levelslen[12] = {0};
+
+        char *name;
+        int k, numlevels, namelen = 0;
+        ub4 levels = 0;
+
+        char *colon = strchr(entries[i], ':');
+        if (! colon) {
+            continue;
+        }
+
+        numlevels = split_string_chkd(entries[i], (int)(colon - entries[i]), ',', levelnames, levelslen, 12);
+        for (k = 0; k < numlevels; k++) {
+            clog_level_t level;
+            if (clog_level_from_string(levelnames[k], levelslen[k], &level) && level >= CLOG_LEVEL_FATAL && level <= CLOG_LEVEL_TRACE) {
+                levels |= (1U << level);
+            }
+        }
+        cstr_varray_free(levelnames, numlevels);
+
+        name = cstr_LRtrim_chr(colon + 1, 32, &namelen);
+        if (levels && namelen > 0) {
+            conf->routes[conf->numroutes].levels = levels;
+            conf->routes[conf->numroutes].nameprefix = cstrbufNew(0, name, (namelen > 127 ? 127 : namelen));
+            conf->numroutes++;
+        }
+    }
+
+    cstr_varray_free(entries, numentries);
+}
+
+
 void logger_conf_init_default (clogger_conf conf, const char *ident, const char *pathprefix, const char *winsyslogconf)
 {
     bzero(conf, sizeof(*conf));
@@ -126,8 +170,16 @@ void logger_conf_init_default (clogger_conf conf, const char *ident, const char
     conf->maxfilecount = 10;
 
     conf->loglevel = CLOG_LEVEL_DEBUG;
+    conf->stdoutlevel = CLOG_LEVEL_ALL;
+    conf->sysloglevel = CLOG_LEVEL_ALL;
+    conf->rofilelevel = CLOG_LEVEL_ALL;
+    conf->shmloglevel = CLOG_LEVEL_ALL;
+    conf->backtracelevel = CLOG_LEVEL_TRACE;
+    conf->priorityweight = 8;
     conf->layout = CLOG_LAYOUT_DATED;
     conf->dateformat = CLOG_DATEFMT_RFC_3339;
+    conf->kvformat = CLOG_KVFORMAT_LOGFMT;
+    conf->clocksource = CLOG_CLOCKSOURCE_REALTIME;
 
     conf->timeunit = CLOG_TIMEUNIT_SEC;
     conf->loctime = 0;
@@ -144,6 +196,12 @@ void logger_conf_final_release (clogger_conf conf)
     cstrbufFree(&conf->nameprefix);
     cstrbufFree(&conf->shmlogfile);
     cstrbufFree(&conf->winsyslogconf);
+    cstrbufFree(&conf->flightrecorder);
+
+    while (conf->numroutes-- > 0) {
+        cstrbufFree(&conf->routes[conf->numroutes].nameprefix);
+    }
+    conf->numroutes = 0;
 }
 
 
@@ -160,6 +218,23 @@ int logger_conf_get_creatflags (const clogger_conf conf)
 
 
 int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_conf conf)
+{
+    int ret;
+
+    CONF_index cfgindex = ConfIndexLoad(cfgfile);
+    if (! cfgindex) {
+        snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "config file not found <%s>", cfgfile);
+        return (-1);
+    }
+
+    ret = logger_conf_load_index(cfgindex, ident, conf);
+
+    ConfIndexFree(cfgindex);
+    return ret;
+}
+
+
+int logger_conf_load_index (CONF_index cfgindex, const char *ident, clogger_conf conf)
 {
     int i, j, ncb, secs;
     void *seclist;
@@ -172,13 +247,13 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
 
     int identlen = cstr_length(ident, ROF_NAMEPATTERN_LEN_MAX);
 
-    secs = ConfGetSectionList(cfgfile, &seclist);
+    secs = ConfIndexGetSectionList(cfgindex, &seclist);
     if (secs == -1) {
-        snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "config file not found <%s>", cfgfile);
+        snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "config file not loaded");
         return loaderror;
     }
     if (secs == 0) {
-        snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "no section in config file <%s>", cfgfile);
+        snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "no section in config file");
         return loaderror;
     }
 
@@ -199,64 +274,211 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                     if (!cstr_compare_len(ident, identlen, idents[j], identslen[j], 0)) {
                         loaderror = 1;
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "magickey", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "magickey", readbuf, sizeof(readbuf));
                         if ( ncb > 1 ) {
                             conf->magickey = (ub4) strtol(readbuf, 0, 10);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "maxmsgsize", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "maxmsgsize", readbuf, sizeof(readbuf));
                         if ( ncb > 1 ) {
                             conf->maxmsgsize = (int) strtol(readbuf, 0, 10);
                             conf->maxmsgsize = memapi_align_psize(conf->maxmsgsize);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "queuelength", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "maxspillsize", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            double spillsize = ConfParseSizeBytesValue(readbuf, 0, 0, 0);
+                            if (spillsize < 0) {
+                                spillsize = 0;
+                            } else if (spillsize > CLOG_SPILL_SIZE_MAX) {
+                                spillsize = CLOG_SPILL_SIZE_MAX;
+                            }
+                            conf->maxspillsize = (int) spillsize;
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "queuelength", readbuf, sizeof(readbuf));
                         if ( ncb > 1 ) {
                             conf->queuelength = (int) strtol(readbuf, 0, 10);
                             conf->maxconcurrents = memapi_align_psize(conf->queuelength / 4);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "appender", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "ringmemory", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            /* lazy (default), prefault, hugepage or both */
+                            conf->ringmemory = 0;
+                            if (cstr_containwith(readbuf, ncb, "prefault", 8) != -1) {
+                                conf->ringmemory |= RINGBUFST_MAP_PREFAULT;
+                            }
+                            if (cstr_containwith(readbuf, ncb, "hugepage", 8) != -1) {
+                                conf->ringmemory |= RINGBUFST_MAP_HUGEPAGE;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "ringreclaim", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->ringreclaim = (int) strtol(readbuf, 0, 10);
+                            if (conf->ringreclaim < 0) {
+                                conf->ringreclaim = 0;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "appenderqueue", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->appenderqueue = (int) strtol(readbuf, 0, 10);
+                            if (conf->appenderqueue < 0) {
+                                conf->appenderqueue = 0;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "prioritylane", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->prioritylane = (int) strtol(readbuf, 0, 10);
+                            if (conf->prioritylane < 0) {
+                                conf->prioritylane = 0;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "priorityweight", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->priorityweight = (int) strtol(readbuf, 0, 10);
+                            if (conf->priorityweight < 1) {
+                                conf->priorityweight = 1;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "appender", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             clog_appender_from_string(readbuf, ncb, &conf->appender);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "pathprefix", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "binblocksize", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->binblocksize = (int) strtol(readbuf, 0, 10);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "ratelimit", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->ratepolicy.ratelimit = (int) strtol(readbuf, 0, 10);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rateburst", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->ratepolicy.rateburst = (int) strtol(readbuf, 0, 10);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "sampling", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            logger_rate_parse_sampling(readbuf, &conf->ratepolicy);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "coalesce", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->coalesce = (int) strtol(readbuf, 0, 10);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "backtrace", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->backtrace = (int) strtol(readbuf, 0, 10);
+                            if (conf->backtrace < 0) {
+                                conf->backtrace = 0;
+                            } else if (conf->backtrace > LOGGERBT_SLOTS) {
+                                conf->backtrace = LOGGERBT_SLOTS;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "backtracems", readbuf, sizeof(readbuf));
+                        if ( ncb > 1 ) {
+                            conf->backtracems = (int) strtol(readbuf, 0, 10);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "backtracelevel", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_level_from_string(readbuf, ncb, &conf->backtracelevel);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "pathprefix", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             conf->pathprefix = cstrbufDup(conf->pathprefix, readbuf, (ncb > 255 ? 255 : ncb));
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "nameprefix", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "nameprefix", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             conf->nameprefix = cstrbufDup(conf->nameprefix, readbuf, (ncb > 127 ? 127 : ncb));
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "shmlogfile", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "shmlogfile", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             conf->shmlogfile = cstrbufDup(conf->shmlogfile, readbuf, (ncb > 127 ? 127 : ncb));
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "rollingpolicy", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "flightrecorder", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            conf->flightrecorder = cstrbufDup(conf->flightrecorder, readbuf, (ncb > 255 ? 255 : ncb));
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rollingpolicy", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             rollingpolicy = cstrbufDup(rollingpolicy, readbuf, (ncb > 127 ? 127 : ncb));
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "loglevel", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "loglevel", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             clog_level_from_string(readbuf, ncb, &conf->loglevel);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "layout", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "stdoutlevel", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_level_from_string(readbuf, ncb, &conf->stdoutlevel);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "sysloglevel", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_level_from_string(readbuf, ncb, &conf->sysloglevel);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rofilelevel", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_level_from_string(readbuf, ncb, &conf->rofilelevel);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "shmloglevel", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_level_from_string(readbuf, ncb, &conf->shmloglevel);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "routes", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            logger_conf_parse_routes(readbuf, ncb, conf);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "routeonly", readbuf, sizeof(readbuf));
+                        if ( ncb ) {
+                            if (ConfParseBoolValue(readbuf, 1)) {
+                                conf->routeonly = 1;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "layout", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             clog_layout_from_string(readbuf, ncb, &conf->layout);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "dateformat", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "dateformat", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             clog_dateformat_from_string(readbuf, ncb, &conf->dateformat);
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "timeunit", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "kvformat", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_kvformat_from_string(readbuf, ncb, &conf->kvformat);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "clocksource", readbuf, sizeof(readbuf));
+                        if ( ncb-- > 1 ) {
+                            clog_clocksource_from_string(readbuf, ncb, &conf->clocksource);
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "timeunit", readbuf, sizeof(readbuf));
                         if ( ncb-- > 1 ) {
                             if (!cstr_compare_len(readbuf, ncb, "s", 1, 1)) {
                                 conf->timeunit = CLOG_TIMEUNIT_SEC;
@@ -267,7 +489,7 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "autowrapline", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "autowrapline", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->autowrapline = 1;
@@ -275,14 +497,14 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                         }
 
 #ifndef CLOGGER_NO_THREADNO
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "processid", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "processid", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->processid = 1;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "threadno", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "threadno", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->threadno = 1;
@@ -294,42 +516,49 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                         }
 #endif
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "hideident", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "hideident", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->hideident = 1;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "timestampid", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "timestampid", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->timestampid = CLOG_TIMESTAMP_ID;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "localtime", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rawtimestamp", readbuf, sizeof(readbuf));
+                        if ( ncb ) {
+                            if (ConfParseBoolValue(readbuf, 1)) {
+                                conf->rawtimestamp = 1;
+                            }
+                        }
+
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "localtime", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->loctime = CLOG_TIMEZONE_LOC;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "colorstyle", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "colorstyle", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->colorstyle = CLOG_LEVEL_COLORS | CLOG_LEVEL_STYLES;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "filelineno", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "filelineno", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->filelineno = CLOG_FILE_LINENO;
                             }
                         }
 
-                        ncb = ConfReadValueParsed(cfgfile, family, qualifier, "function", readbuf, sizeof(readbuf));
+                        ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "function", readbuf, sizeof(readbuf));
                         if ( ncb ) {
                             if (ConfParseBoolValue(readbuf, 1)) {
                                 conf->function = CLOG_FUNCTION_NAME;
@@ -339,10 +568,10 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                         do {
                             char *valuebuf = 0;
 
-                            if ( ConfReadValueParsedAlloc(cfgfile, family, qualifier, "enableflags", &valuebuf) ) {
-                                // autowrapline, timestampid, localtime, colorstyle, filelineno, function, hideident
-                                char *keynames[10] = {0};
-                                int keyslen[10] = {0};
+                            if ( ConfIndexReadValueParsedAlloc(cfgindex, family, qualifier, "enableflags", &valuebuf) ) {
+                                // autowrapline, timestampid, rawtimestamp, localtime, colorstyle, filelineno, function, hideident
+                                char *keynames[16] = {0};
+                                int keyslen[16] = {0};
 
                                 int numkeys = split_string_chkd(valuebuf, cstr_length(valuebuf, 255), ',', keynames, keyslen, sizeof(keyslen)/sizeof(keyslen[0]));
 
@@ -356,6 +585,9 @@ int logger_conf_load_config (const char *cfgfile, const char *ident, clogger_con
                                     if (cstr_findstr_in("timestampid", cstr_length("timestampid", 20), (const char **)keynames, numkeys, 1) != -1) {
                                         conf->timestampid = CLOG_TIMESTAMP_ID;
                                     }
+                                    if (cstr_findstr_in("rawtimestamp", cstr_length("rawtimestamp", 20), (const char **)keynames, numkeys, 1) != -1) {
+                                        conf->rawtimestamp = 1;
+                                    }
                                     if (cstr_findstr_in("localtime", cstr_length("localtime", 20), (const char **)keynames, numkeys, 1) != -1) {
                                         conf->loctime = CLOG_TIMEZONE_LOC;
                                     }
@@ -411,7 +643,7 @@ found_ident:
         loaderror = 1;
         snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "not found rollingpolicy: [rollingpolicy:%.*s]", (int)rollingpolicy->len, rollingpolicy->str);
 
-        secs = ConfGetSectionList(cfgfile, &seclist);
+        secs = ConfIndexGetSectionList(cfgindex, &seclist);
 
         for (i = 0; i < secs; ++i) {
             char * sec;
@@ -427,23 +659,23 @@ found_ident:
                     loaderror = 0;
                     snprintf(conf->errmsg, CLOG_ERRMSG_LEN_MAX, "success");
 
-                    ncb = ConfReadValueParsed(cfgfile, family, qualifier, "rollingtime", readbuf, sizeof(readbuf));
+                    ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rollingtime", readbuf, sizeof(readbuf));
                     if ( ncb-- > 1 ) {
                         char *rotstr = cstr_trim_whitespace(readbuf);
                         rollingtime_from_string(rotstr, cstr_length(rotstr, ncb), &conf->rollingtime);
                     }
 
-                    ncb = ConfReadValueParsed(cfgfile, family, qualifier, "maxfilesize", readbuf, sizeof(readbuf));
+                    ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "maxfilesize", readbuf, sizeof(readbuf));
                     if ( ncb ) {
                         conf->maxfilesize = (ub8) ConfParseSizeBytesValue(readbuf, (double) conf->maxfilesize, 0, 0);
                     }
 
-                    ncb = ConfReadValueParsed(cfgfile, family, qualifier, "maxfilecount", readbuf, sizeof(readbuf));
+                    ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "maxfilecount", readbuf, sizeof(readbuf));
                     if ( ncb ) {
                         conf->maxfilecount = (ub4) strtoul(readbuf, 0, 10);
                     }
 
-                    ncb = ConfReadValueParsed(cfgfile, family, qualifier, "rollingappend", readbuf, sizeof(readbuf));
+                    ncb = ConfIndexReadValueParsed(cfgindex, family, qualifier, "rollingappend", readbuf, sizeof(readbuf));
                     if ( ncb ) {
                         if (ConfParseBoolValue(readbuf, 1)) {
                             conf->rollingappend = 1;
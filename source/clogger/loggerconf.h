@@ -45,6 +45,11 @@ extern "C"
 #include "rollingfile.h"
 
 #include "shmmaplog.h"
+#include "loggerrate.h"
+#include "loggerbt.h"
+
+/* rolling files which levels can be routed to */
+#define LOGGER_CONF_ROUTES_MAX  4
 
 
 typedef struct _logger_conf_t
@@ -56,8 +61,23 @@ typedef struct _logger_conf_t
     int           maxconcurrents;
     int           maxmsgsize;
     int           queuelength;
+
+    /* longer message than maxmsgsize is kept on heap up to size (0 for none) */
+    int           maxspillsize;
+
+    /* length of ring for WARN and above (0 for none) and its reads per bulk read */
+    int           prioritylane;
+    int           priorityweight;
+
+    /* RINGBUFST_MAP_* for memory of rings and idle seconds to reclaim it */
+    int           ringmemory;
+    int           ringreclaim;
     int           appender;
 
+    /* length of own queue of STDOUT and SYSLOG (0 for none) */
+    int           appenderqueue;
+    int           binblocksize;
+
     ub8           maxfilesize;
     ub4           maxfilecount;
     int           rollingappend;
@@ -71,6 +91,7 @@ typedef struct _logger_conf_t
     int           function;
     int           autowrapline;
     int           hideident;
+    int           rawtimestamp;
 
 #ifndef CLOGGER_NO_THREADNO
     int           processid;
@@ -83,16 +104,47 @@ typedef struct _logger_conf_t
     cstrbuf       shmlogfile;
     cstrbuf       winsyslogconf;
 
+    /* file of flight recorder for ringbuffer, NULL for heap memory */
+    cstrbuf       flightrecorder;
+
     clog_level_t       loglevel;
     clog_layout_t      layout;
     clog_dateformat_t  dateformat;
+    clog_kvformat_t    kvformat;
+    clog_clocksource_t clocksource;
 
     rollingtime_t      rollingtime;
 
+    logger_rate_policy ratepolicy;
+    int                coalesce;
+
+    /* highest level written by every appender (loglevel for callers) */
+    clog_level_t       stdoutlevel;
+    clog_level_t       sysloglevel;
+    clog_level_t       rofilelevel;
+    clog_level_t       shmloglevel;
+
+    /* levels routed to own rolling files by: "ERROR,FATAL:<IDENT>.error.log;..." */
+    int                numroutes;
+    struct {
+        ub4            levels;
+        cstrbuf        nameprefix;
+    } routes[LOGGER_CONF_ROUTES_MAX];
+    int                routeonly;
+
+    /* records up to backtracelevel not logged are kept for next ERROR */
+    int                backtrace;
+    int                backtracems;
+    clog_level_t       backtracelevel;
+
     char errmsg[CLOG_ERRMSG_LEN_MAX + 1];
 } logger_conf_t;
 
 
+/* load conf of ident from config file parsed once */
+extern int logger_conf_load_index (CONF_index cfgindex, const char *ident, clogger_conf conf);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,421 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerctl.c
+**  control page of process shared with cloggerctl.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 13:40:22
+** @date      2026-10-18 13:40:22
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/cstrbuf.h>
+#include <common/fileut.h>
+
+#if defined(__WINDOWS__)
+  # include <windows.h>
+#else
+  # include <sys/types.h>
+  # include <sys/stat.h>
+  # include <sys/mman.h>
+  # include <fcntl.h>
+  # include <unistd.h>
+  # include <errno.h>
+#endif
+
+#include "loggerctl.h"
+
+
+typedef struct _loggerctl_t
+{
+    loggerctl_page *page;
+
+    /* 1 if created by this process */
+    int owner;
+
+#if defined(__WINDOWS__)
+    HANDLE hmap;
+#endif
+
+    char shmname[64];
+} loggerctl_t;
+
+
+/* FNV-1a of basename and line */
+static ub4 loggerctl_site_hash (const char *file, int filelen, int lineno)
+{
+    ub4 hash = 2166136261U;
+    int i;
+
+    for (i = 0; i < filelen; i++) {
+        hash = (hash ^ (ub1) file[i]) * 16777619U;
+    }
+
+    return (hash ^ (ub4) lineno) * 16777619U;
+}
+
+
+static const char * loggerctl_basename (const char *filename, int *filelen)
+{
+    const char *base;
+
+    *filelen = cstr_length(filename, 256);
+    base = clog_logger_file_basename(filename, filelen);
+
+    if (*filelen > LOGGERCTL_FILE_MAX) {
+        *filelen = LOGGERCTL_FILE_MAX;
+    }
+    return base;
+}
+
+
+static int loggerctl_shmname (int pid, char *buf, size_t bufsize)
+{
+#if defined(__WINDOWS__)
+    return snprintf(buf, bufsize, "Local\\" LOGGERCTL_NAME_PREFIX "%d", pid);
+#else
+    return snprintf(buf, bufsize, "/" LOGGERCTL_NAME_PREFIX "%d", pid);
+#endif
+}
+
+
+int loggerctl_pathname (int pid, char *buf, size_t bufsize)
+{
+#if defined(__WINDOWS__)
+    return loggerctl_shmname(pid, buf, bufsize);
+#else
+    return snprintf(buf, bufsize, "/dev/shm/" LOGGERCTL_NAME_PREFIX "%d", pid);
+#endif
+}
+
+
+#if ! defined(__WINDOWS__)
+/**
+ * page must be owned by us or by user of target process (when we are root).
+ *  other users could switch levels or truncate page under mapping.
+ */
+static int loggerctl_uid_trusted (int pid, uid_t uid)
+{
+    char procpath[32];
+    struct stat sb;
+
+    if (uid == geteuid()) {
+        return 1;
+    }
+
+    snprintf(procpath, sizeof(procpath), "/proc/%d", pid);
+    if (stat(procpath, &sb) == 0 && sb.st_uid == uid) {
+        return 1;
+    }
+
+    return 0;
+}
+#endif
+
+
+static loggerctl_hdl loggerctl_map (int pid, int create)
+{
+    loggerctl_t *ctl = (loggerctl_t *) mem_alloc_zero(1, sizeof(*ctl));
+    size_t pagesize = sizeof(loggerctl_page);
+
+    loggerctl_shmname(pid, ctl->shmname, sizeof(ctl->shmname));
+
+#if defined(__WINDOWS__)
+    if (create) {
+        ctl->hmap = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD) pagesize, ctl->shmname);
+        if (ctl->hmap && GetLastError() == ERROR_ALREADY_EXISTS) {
+            /* made by other one before us */
+            CloseHandle(ctl->hmap);
+            ctl->hmap = NULL;
+        }
+    } else {
+        ctl->hmap = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ctl->shmname);
+    }
+    if (! ctl->hmap) {
+        mem_free(ctl);
+        return NULL;
+    }
+
+    ctl->page = (loggerctl_page *) MapViewOfFile(ctl->hmap, FILE_MAP_ALL_ACCESS, 0, 0, pagesize);
+    if (! ctl->page) {
+        CloseHandle(ctl->hmap);
+        mem_free(ctl);
+        return NULL;
+    }
+#else
+    do {
+        void *addr;
+        struct stat sb;
+        int fd;
+
+        if (create) {
+            /* never map page left by other user: pid may be reused */
+            fd = shm_open(ctl->shmname, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd == -1 && errno == EEXIST && shm_unlink(ctl->shmname) == 0) {
+                /* stale page of ours (/dev/shm is sticky) */
+                fd = shm_open(ctl->shmname, O_RDWR | O_CREAT | O_EXCL, 0600);
+            }
+        } else {
+            fd = shm_open(ctl->shmname, O_RDWR, 0);
+        }
+        if (fd == -1) {
+            mem_free(ctl);
+            return NULL;
+        }
+
+        if (create && ftruncate(fd, (off_t) pagesize) == -1) {
+            close(fd);
+            shm_unlink(ctl->shmname);
+            mem_free(ctl);
+            return NULL;
+        }
+
+        if (fstat(fd, &sb) == -1 || sb.st_size != (off_t) pagesize || ! loggerctl_uid_trusted(pid, sb.st_uid)) {
+            close(fd);
+            if (create) {
+                shm_unlink(ctl->shmname);
+            }
+            mem_free(ctl);
+            return NULL;
+        }
+
+        addr = mmap(NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (addr == MAP_FAILED) {
+            if (create) {
+                shm_unlink(ctl->shmname);
+            }
+            mem_free(ctl);
+            return NULL;
+        }
+
+        ctl->page = (loggerctl_page *) addr;
+    } while(0);
+#endif
+
+    ctl->owner = create;
+
+    if (create) {
+        bzero(ctl->page, pagesize);
+
+        ctl->page->version = LOGGERCTL_VERSION;
+        ctl->page->pagesize = (ub4) pagesize;
+        ctl->page->pid = pid;
+
+        uatomic_fence_rel();
+        ctl->page->magic = LOGGERCTL_MAGIC;
+    } else if (ctl->page->magic != LOGGERCTL_MAGIC || ctl->page->version != LOGGERCTL_VERSION || ctl->page->pagesize != (ub4) pagesize) {
+        /* not ready or built by other version */
+        loggerctl_close(ctl);
+        return NULL;
+    }
+
+    return ctl;
+}
+
+
+loggerctl_hdl loggerctl_create (void)
+{
+    return loggerctl_map(getprocessid(), 1);
+}
+
+
+loggerctl_hdl loggerctl_open (int pid)
+{
+    return loggerctl_map(pid, 0);
+}
+
+
+void loggerctl_close (loggerctl_hdl ctl)
+{
+    if (ctl) {
+#if defined(__WINDOWS__)
+        UnmapViewOfFile(ctl->page);
+        CloseHandle(ctl->hmap);
+#else
+        munmap(ctl->page, sizeof(loggerctl_page));
+        if (ctl->owner) {
+            shm_unlink(ctl->shmname);
+        }
+#endif
+        mem_free(ctl);
+    }
+}
+
+
+loggerctl_page * loggerctl_get_page (loggerctl_hdl ctl)
+{
+    return ctl->page;
+}
+
+
+loggerctl_logger * loggerctl_attach (loggerctl_hdl ctl, int loggerid, const char *ident)
+{
+    loggerctl_logger *lgctl;
+
+    if (! ctl || loggerid < 0 || loggerid >= LOGGERCTL_LOGGERS) {
+        return NULL;
+    }
+
+    lgctl = &ctl->page->loggers[loggerid];
+
+    snprintf(lgctl->ident, sizeof(lgctl->ident), "%s", ident);
+    lgctl->loggerid = loggerid;
+
+    /* loggers are listed up to numloggers */
+    uatomic_fence_rel();
+    while (ctl->page->numloggers <= loggerid) {
+        int num = ctl->page->numloggers;
+        uatomic_int_comp_exch(&ctl->page->numloggers, num, loggerid + 1);
+    }
+
+    return lgctl;
+}
+
+
+int loggerctl_site_flags (const loggerctl_page *page, const char *filename, int lineno)
+{
+    int filelen, probes;
+    const char *file = loggerctl_basename(filename, &filelen);
+    ub4 i = loggerctl_site_hash(file, filelen, lineno) & (LOGGERCTL_SITES - 1);
+
+    for (probes = 0; probes < LOGGERCTL_SITES; probes++) {
+        const loggerctl_site *site = &page->sites[i];
+        int flags = uatomic_int_load_acq(&site->flags);
+
+        if (! flags) {
+            /* never used slot ends probing */
+            break;
+        }
+
+        if (! (flags & LOGGERCTL_SITE_BUSY) && site->lineno == lineno &&
+            ! strncmp(site->file, file, filelen) && site->file[filelen] == '\0') {
+            return flags;
+        }
+
+        i = (i + 1) & (LOGGERCTL_SITES - 1);
+    }
+
+    return 0;
+}
+
+
+int loggerctl_set_site (loggerctl_page *page, const char *filename, int lineno, int onoff, int64_t expiry)
+{
+    int filelen, probes;
+    const char *file = loggerctl_basename(filename, &filelen);
+    ub4 i = loggerctl_site_hash(file, filelen, lineno) & (LOGGERCTL_SITES - 1);
+
+    onoff &= (LOGGERCTL_SITE_ON | LOGGERCTL_SITE_OFF);
+
+    for (probes = 0; probes < LOGGERCTL_SITES; probes++) {
+        loggerctl_site *site = &page->sites[i];
+        int flags = uatomic_int_load_acq(&site->flags);
+
+        if (! flags) {
+            if (! onoff) {
+                /* nothing to clear */
+                return 0;
+            }
+
+            /* claim slot and fill it before it can be matched */
+            if (uatomic_int_comp_exch(&site->flags, 0, LOGGERCTL_SITE_BUSY) != 0) {
+                continue;
+            }
+
+            memcpy(site->file, file, filelen);
+            site->file[filelen] = '\0';
+            site->lineno = lineno;
+            flags = LOGGERCTL_SITE_USED;
+            uatomic_int_store_rel(&site->flags, flags);
+        }
+
+        if (flags & LOGGERCTL_SITE_BUSY) {
+            /* wait for other writer to fill slot */
+            continue;
+        }
+
+        if (site->lineno == lineno && ! strncmp(site->file, file, filelen) && site->file[filelen] == '\0') {
+            int newflags = LOGGERCTL_SITE_USED | onoff;
+
+            uatomic_int64_set(&site->expiry, (onoff? expiry : 0));
+
+            flags = uatomic_int_set(&site->flags, newflags);
+            if ((flags & ~LOGGERCTL_SITE_USED) && ! onoff) {
+                uatomic_int_sub(&page->activesites);
+            } else if (! (flags & ~LOGGERCTL_SITE_USED) && onoff) {
+                uatomic_int_add(&page->activesites);
+            }
+            uatomic_int_add(&page->sitesgen);
+            return 1;
+        }
+
+        i = (i + 1) & (LOGGERCTL_SITES - 1);
+    }
+
+    /* table is full */
+    return -1;
+}
+
+
+void loggerctl_sweep (loggerctl_page *page, loggerctl_logger *lgctl, int64_t now)
+{
+    if (lgctl && lgctl->level) {
+        int64_t expiry = lgctl->expiry;
+
+        if (expiry && expiry <= now) {
+            int level = lgctl->level;
+
+            /* level may be set again just now */
+            if (lgctl->expiry == expiry) {
+                uatomic_int_comp_exch(&lgctl->level, level, 0);
+            }
+        }
+    }
+
+    if (page->activesites) {
+        int i;
+
+        for (i = 0; i < LOGGERCTL_SITES; i++) {
+            loggerctl_site *site = &page->sites[i];
+            int flags = site->flags;
+
+            if ((flags & (LOGGERCTL_SITE_ON | LOGGERCTL_SITE_OFF)) && ! (flags & LOGGERCTL_SITE_BUSY)) {
+                int64_t expiry = site->expiry;
+
+                if (expiry && expiry <= now) {
+                    /* only one of logthreads clears it */
+                    if (uatomic_int_comp_exch(&site->flags, flags, LOGGERCTL_SITE_USED) == flags) {
+                        uatomic_int_sub(&page->activesites);
+                        uatomic_int_add(&page->sitesgen);
+                    }
+                }
+            }
+        }
+    }
+}
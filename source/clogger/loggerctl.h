@@ -0,0 +1,165 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerctl.h
+**  private api for control page of process shared with cloggerctl.
+**
+**  Every process maps a control page (Linux: /dev/shm/clogger-ctl.$pid)
+**  holding a level word and stats per logger and a table of call sites
+**  (file:line) switched on or off. Callers read the words only: nothing is
+**  locked and nothing is checked more when no control is set. Overrides
+**  expire at given time and are cleared by logthreads.
+**
+**  The page is created anew by the process (mode 0600) and is opened only
+**  when it is owned by the caller or by the user of the process, so that
+**  cloggerctl must run as the same user or as root.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 13:40:22
+** @date      2026-10-18 13:40:22
+*/
+#ifndef _LOGGERCTL_PRIVATE_H_
+#define _LOGGERCTL_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/uatomic.h>
+
+#include "clogger_api.h"
+
+
+#define LOGGERCTL_MAGIC              0x4c54434c   /* "LCTL" */
+/* version 2: ringresident of logger. version 3: sitesgen */
+#define LOGGERCTL_VERSION            3
+
+#define LOGGERCTL_NAME_PREFIX        "clogger-ctl."
+
+#define LOGGERCTL_LOGGERS            256
+#define LOGGERCTL_SITES              1024
+#define LOGGERCTL_IDENT_MAX          63
+#define LOGGERCTL_FILE_MAX           55
+
+/* level word: no override if 0 */
+#define LOGGERCTL_LEVEL_SET          0x100
+
+/* flags of site: slot is used (claimed) once and never freed */
+#define LOGGERCTL_SITE_USED          0x01
+#define LOGGERCTL_SITE_ON            0x02
+#define LOGGERCTL_SITE_OFF           0x04
+#define LOGGERCTL_SITE_BUSY          0x80
+
+
+typedef struct
+{
+    char ident[LOGGERCTL_IDENT_MAX + 1];
+
+    /* LOGGERCTL_LEVEL_SET | clog_level_t */
+    uatomic_int level;
+    int loggerid;
+
+    /* epoch seconds when level is cleared, 0 for never */
+    uatomic_int64 expiry;
+
+    /* stats updated by logthread */
+    uatomic_int64 messages;
+    uatomic_int64 dropped;
+    uatomic_int64 updated;
+
+    /* bytes of rings resident in memory */
+    uatomic_int64 ringresident;
+} loggerctl_logger;
+
+
+typedef struct
+{
+    uatomic_int flags;
+    int lineno;
+
+    uatomic_int64 expiry;
+
+    /* basename of source file */
+    char file[LOGGERCTL_FILE_MAX + 1];
+} loggerctl_site;
+
+
+typedef struct
+{
+    ub4 magic;
+    ub4 version;
+    ub4 pagesize;
+    int pid;
+
+    uatomic_int numloggers;
+
+    /* sites switched on or off now */
+    uatomic_int activesites;
+
+    /* moved after flags of any site changed */
+    uatomic_int sitesgen;
+
+    loggerctl_logger loggers[LOGGERCTL_LOGGERS];
+    loggerctl_site sites[LOGGERCTL_SITES];
+} loggerctl_page;
+
+
+typedef struct _loggerctl_t * loggerctl_hdl;
+
+
+/* create page of current process. returns NULL if not available */
+extern loggerctl_hdl loggerctl_create (void);
+
+/* open page of process pid for cloggerctl */
+extern loggerctl_hdl loggerctl_open (int pid);
+
+/* close page. creator removes it */
+extern void loggerctl_close (loggerctl_hdl ctl);
+
+extern loggerctl_page * loggerctl_get_page (loggerctl_hdl ctl);
+
+/* register logger by creator */
+extern loggerctl_logger * loggerctl_attach (loggerctl_hdl ctl, int loggerid, const char *ident);
+
+/* flags of site switched for source file (path or basename) and line */
+extern int loggerctl_site_flags (const loggerctl_page *page, const char *filename, int lineno);
+
+/* switch site on or off (0 to clear) until expiry */
+extern int loggerctl_set_site (loggerctl_page *page, const char *filename, int lineno, int onoff, int64_t expiry);
+
+/* clear expired level of logger and expired sites */
+extern void loggerctl_sweep (loggerctl_page *page, loggerctl_logger *lgctl, int64_t now);
+
+/* pathname of page for pid */
+extern int loggerctl_pathname (int pid, char *buf, size_t bufsize);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERCTL_PRIVATE_H_ */
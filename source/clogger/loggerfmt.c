@@ -0,0 +1,705 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerfmt.c
+**  message formatting shared by logthread and decoders.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 11:20:05
+** @date      2026-10-18 11:20:05
+*/
+#include <common/basetype.h>
+#include <common/varint.h>
+#include <common/timeut.h>
+
+#include "loggerfmt.h"
+#include "loggerkv.h"
+
+static const char *clog_week_strs[]  = { 0, "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+static const char *clog_month_strs[]  = { 0, "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+
+/* max length of one conversion spec like: "%-+#012.8lld" */
+#define FMTSPEC_LEN_MAX   48
+
+typedef enum {
+    FMTARG_NONE   = 0,      /* %% */
+    FMTARG_INT    = 1,
+    FMTARG_DOUBLE = 2,
+    FMTARG_STRING = 3,
+    FMTARG_POINTER = 4,
+    FMTARG_BAD    = -1
+} fmtarg_type;
+
+typedef enum {
+    FMTLEN_NONE = 0,
+    FMTLEN_HH,
+    FMTLEN_H,
+    FMTLEN_L,
+    FMTLEN_LL,
+    FMTLEN_J,
+    FMTLEN_Z,
+    FMTLEN_T,
+    FMTLEN_BIGL
+} fmtarg_length;
+
+typedef struct
+{
+    /* '%' and next char after conversion */
+    const char *start;
+    const char *end;
+
+    int starwidth;
+    int starprec;
+
+    /* precision in digits, -1 if not given */
+    int precision;
+
+    fmtarg_length length;
+    fmtarg_type type;
+} fmtarg_spec;
+
+
+/**
+ * find next conversion spec in [p, end).
+ * returns:
+ *   1 - spec found
+ *   0 - no more spec
+ */
+static int fmt_next_spec (const char *p, const char *end, fmtarg_spec *spec)
+{
+    while (p < end && *p != '%') {
+        p++;
+    }
+    if (p == end) {
+        return 0;
+    }
+
+    memset(spec, 0, sizeof(*spec));
+    spec->start = p++;
+    spec->precision = -1;
+    spec->type = FMTARG_BAD;
+
+    /* flags */
+    while (p < end && strchr("-+ #0'I", *p)) {
+        p++;
+    }
+
+    /* width */
+    if (p < end && *p == '*') {
+        spec->starwidth = 1;
+        p++;
+    } else {
+        while (p < end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    /* precision */
+    if (p < end && *p == '.') {
+        p++;
+        if (p < end && *p == '*') {
+            spec->starprec = 1;
+            p++;
+        } else {
+            spec->precision = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                spec->precision = spec->precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+
+    /* length modifier */
+    if (p < end) {
+        switch (*p) {
+        case 'h':
+            p++;
+            spec->length = FMTLEN_H;
+            if (p < end && *p == 'h') {
+                p++;
+                spec->length = FMTLEN_HH;
+            }
+            break;
+        case 'l':
+            p++;
+            spec->length = FMTLEN_L;
+            if (p < end && *p == 'l') {
+                p++;
+                spec->length = FMTLEN_LL;
+            }
+            break;
+        case 'q':
+            p++;
+            spec->length = FMTLEN_LL;
+            break;
+        case 'j':
+            p++;
+            spec->length = FMTLEN_J;
+            break;
+        case 'z':
+            p++;
+            spec->length = FMTLEN_Z;
+            break;
+        case 't':
+            p++;
+            spec->length = FMTLEN_T;
+            break;
+        case 'L':
+            p++;
+            spec->length = FMTLEN_BIGL;
+            break;
+        }
+    }
+
+    if (p == end) {
+        spec->end = end;
+        return 1;
+    }
+
+    switch (*p++) {
+    case '%':
+        spec->type = FMTARG_NONE;
+        break;
+
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        spec->type = FMTARG_INT;
+        break;
+
+    case 'c':
+        /* %lc is wide char */
+        if (spec->length == FMTLEN_NONE) {
+            spec->type = FMTARG_INT;
+        }
+        break;
+
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        /* long double is not supported */
+        if (spec->length != FMTLEN_BIGL) {
+            spec->type = FMTARG_DOUBLE;
+        }
+        break;
+
+    case 's':
+        /* %ls is wide string */
+        if (spec->length == FMTLEN_NONE) {
+            spec->type = FMTARG_STRING;
+        }
+        break;
+
+    case 'p':
+        spec->type = FMTARG_POINTER;
+        break;
+
+    default:
+        /* %n, %m, %C, %S, %1$d, ... */
+        break;
+    }
+
+    spec->end = p;
+    return 1;
+}
+
+
+static int fmt_put_varint (sb8 v, ub1 *buf, size_t bufsz, size_t *len)
+{
+    if (*len + VARINT_SIZE_MAX > bufsz) {
+        return 0;
+    }
+    *len += varint_encode64(zigzag_encode64(v), buf + *len);
+    return 1;
+}
+
+
+static int fmt_get_varint (const ub1 *args, size_t argslen, size_t *offset, sb8 *v)
+{
+    ub8 u;
+    int n = varint_decode64(args + *offset, argslen - *offset, &u);
+    if (! n) {
+        return 0;
+    }
+    *offset += n;
+    *v = zigzag_decode64(u);
+    return 1;
+}
+
+
+int logger_fmt_capture (const char *format, va_list args, char *buf, size_t bufsz)
+{
+    fmtarg_spec spec;
+
+    ub1 *outbuf = (ub1 *) buf;
+    size_t len = 0;
+
+    const char *p = format;
+    const char *end = format + strlen(format);
+
+    while (fmt_next_spec(p, end, &spec)) {
+        sb8 v;
+        double dbl;
+
+        p = spec.end;
+
+        if (spec.type == FMTARG_BAD || spec.end - spec.start > FMTSPEC_LEN_MAX) {
+            return (-1);
+        }
+
+        if (spec.starwidth) {
+            if (! fmt_put_varint(va_arg(args, int), outbuf, bufsz, &len)) {
+                return (-1);
+            }
+        }
+
+        if (spec.starprec) {
+            spec.precision = va_arg(args, int);
+            if (! fmt_put_varint(spec.precision, outbuf, bufsz, &len)) {
+                return (-1);
+            }
+        }
+
+        switch (spec.type) {
+        case FMTARG_INT:
+            switch (spec.length) {
+            case FMTLEN_L:
+                v = (sb8) va_arg(args, long);
+                break;
+            case FMTLEN_LL:
+                v = (sb8) va_arg(args, long long);
+                break;
+            case FMTLEN_J:
+                v = (sb8) va_arg(args, intmax_t);
+                break;
+            case FMTLEN_Z:
+                v = (sb8) va_arg(args, size_t);
+                break;
+            case FMTLEN_T:
+                v = (sb8) va_arg(args, ptrdiff_t);
+                break;
+            default:
+                v = (sb8) va_arg(args, int);
+                break;
+            }
+            if (! fmt_put_varint(v, outbuf, bufsz, &len)) {
+                return (-1);
+            }
+            break;
+
+        case FMTARG_POINTER:
+            v = (sb8) (uintptr_t) va_arg(args, void *);
+            if (! fmt_put_varint(v, outbuf, bufsz, &len)) {
+                return (-1);
+            }
+            break;
+
+        case FMTARG_DOUBLE:
+            dbl = va_arg(args, double);
+            if (len + sizeof(double) > bufsz) {
+                return (-1);
+            }
+            memcpy(outbuf + len, &dbl, sizeof(double));
+            len += sizeof(double);
+            break;
+
+        case FMTARG_STRING:
+            do {
+                size_t slen;
+                const char *str = va_arg(args, const char *);
+
+                if (! str) {
+                    /* same as glibc */
+                    str = "(null)";
+                }
+
+                if (spec.precision >= 0) {
+                    slen = strnlen(str, (size_t) spec.precision);
+                } else {
+                    slen = strlen(str);
+                }
+
+                if (len + VARINT_SIZE_MAX + slen > bufsz) {
+                    return (-1);
+                }
+
+                len += varint_encode64((ub8) slen, outbuf + len);
+                memcpy(outbuf + len, str, slen);
+                len += slen;
+            } while(0);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return (int) len;
+}
+
+
+size_t logger_fmt_replay (const char *format, size_t fmtlen, const char *args, size_t argslen, char *outbuf, size_t outsz)
+{
+    fmtarg_spec spec;
+
+    const ub1 *argbuf = (const ub1 *) args;
+    size_t offset = 0;
+    size_t len = 0;
+
+    const char *p = format;
+    const char *end = format + fmtlen;
+
+    while (len < outsz) {
+        /* spec text with '*' replaced by numbers */
+        char specbuf[FMTSPEC_LEN_MAX + 48];
+        int speclen = 0;
+        int rc = 0;
+
+        const char *s;
+
+        sb8 v, width = 0, prec = 0;
+        double dbl;
+
+        const char *lit = p;
+        int found = fmt_next_spec(p, end, &spec);
+        size_t litlen = (found? (size_t)(spec.start - lit) : (size_t)(end - lit));
+
+        if (litlen > outsz - len) {
+            litlen = outsz - len;
+        }
+        memcpy(outbuf + len, lit, litlen);
+        len += litlen;
+
+        if (! found || len == outsz) {
+            break;
+        }
+        p = spec.end;
+
+        if (spec.type == FMTARG_NONE) {
+            outbuf[len++] = '%';
+            continue;
+        }
+        if (spec.type == FMTARG_BAD) {
+            /* never happen for captured args */
+            break;
+        }
+
+        if (spec.starwidth && ! fmt_get_varint(argbuf, argslen, &offset, &width)) {
+            break;
+        }
+        if (spec.starprec && ! fmt_get_varint(argbuf, argslen, &offset, &prec)) {
+            break;
+        }
+
+        for (s = spec.start; s < spec.end; s++) {
+            if (*s != '*') {
+                specbuf[speclen++] = *s;
+            } else if (s > spec.start && s[-1] == '.') {
+                if (prec >= 0) {
+                    speclen += snprintf(specbuf + speclen, 16, "%d", (int) prec);
+                } else {
+                    /* negative precision is taken as if omitted */
+                    speclen--;
+                }
+            } else {
+                speclen += snprintf(specbuf + speclen, 16, "%d", (int) width);
+            }
+        }
+        specbuf[speclen] = 0;
+
+        switch (spec.type) {
+        case FMTARG_INT:
+            if (! fmt_get_varint(argbuf, argslen, &offset, &v)) {
+                goto end_replay;
+            }
+            switch (spec.length) {
+            case FMTLEN_L:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (long) v);
+                break;
+            case FMTLEN_LL:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (long long) v);
+                break;
+            case FMTLEN_J:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (intmax_t) v);
+                break;
+            case FMTLEN_Z:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (size_t) v);
+                break;
+            case FMTLEN_T:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (ptrdiff_t) v);
+                break;
+            default:
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (int) v);
+                break;
+            }
+            break;
+
+        case FMTARG_POINTER:
+            if (! fmt_get_varint(argbuf, argslen, &offset, &v)) {
+                goto end_replay;
+            }
+            rc = snprintf(outbuf + len, outsz - len, specbuf, (void *) (uintptr_t) v);
+            break;
+
+        case FMTARG_DOUBLE:
+            if (offset + sizeof(double) > argslen) {
+                goto end_replay;
+            }
+            memcpy(&dbl, argbuf + offset, sizeof(double));
+            offset += sizeof(double);
+            rc = snprintf(outbuf + len, outsz - len, specbuf, dbl);
+            break;
+
+        case FMTARG_STRING:
+            do {
+                ub8 slen;
+                int n = varint_decode64(argbuf + offset, argslen - offset, &slen);
+                if (! n || slen > argslen - offset - n) {
+                    goto end_replay;
+                }
+                offset += n;
+
+                /* string in args is not null-terminated: "%-20.5s" => "%-20.*s" */
+                do {
+                    char *dot = strchr(specbuf, '.');
+                    speclen = (dot? (int)(dot - specbuf) : speclen - 1);
+                    memcpy(specbuf + speclen, ".*s", 4);
+                } while(0);
+
+                rc = snprintf(outbuf + len, outsz - len, specbuf, (int) slen, (const char *) argbuf + offset);
+                offset += (size_t) slen;
+            } while(0);
+            break;
+
+        default:
+            break;
+        }
+
+        if (rc < 0) {
+            break;
+        }
+        if ((size_t) rc >= outsz - len) {
+            /* truncated: snprintf keeps last byte for '\0' */
+            len = outsz - 1;
+            break;
+        }
+        len += (size_t) rc;
+    }
+
+end_replay:
+    return len;
+}
+
+
+size_t logger_format_datetime (clog_dateformat_t dateformat, int timeunit, int loctime, const char *timezonefmt, const struct tm *loc, long nsec, char *buf, size_t bufsz)
+{
+    int fmtlen;
+
+    if (dateformat == CLOG_DATEFMT_RFC_3339 || dateformat == CLOG_DATEFMT_ISO_8601) {
+        /* "2019-12-26 10:13:41+08:00", "2019-12-26T10:14:32+08:00" */
+        char T = (dateformat == CLOG_DATEFMT_ISO_8601?  'T' : 32);
+
+        if (timeunit == CLOG_TIMEUNIT_MSEC) {
+            fmtlen = snprintf(buf, bufsz,
+                    "%04d-%02d-%02d%c%02d:%02d:%02d.%03d%.*s:%.*s", loc->tm_year, loc->tm_mon, loc->tm_mday, T, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000000), 3, timezonefmt, 2, timezonefmt + 3);
+        } else if (timeunit == CLOG_TIMEUNIT_USEC) {
+            fmtlen = snprintf(buf, bufsz,
+                    "%04d-%02d-%02d%c%02d:%02d:%02d.%06d%.*s:%.*s", loc->tm_year, loc->tm_mon, loc->tm_mday, T, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000), 3, timezonefmt, 2, timezonefmt + 3);
+        } else {
+            fmtlen = snprintf(buf, bufsz,
+                    "%04d-%02d-%02d%c%02d:%02d:%02d%.*s:%.*s",      loc->tm_year, loc->tm_mon, loc->tm_mday, T, loc->tm_hour, loc->tm_min, loc->tm_sec, 3, timezonefmt, 2, timezonefmt + 3);
+        }
+    } else if (dateformat == CLOG_DATEFMT_UNIVERSAL) {
+        /* "Thu Dec 26 02:16:02 UTC 2019" */
+        if (timeunit == CLOG_TIMEUNIT_MSEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s %.3s %02d %02d:%02d:%02d.%03d UTC%.*s %04d", clog_week_strs[loc->tm_wday], clog_month_strs[loc->tm_mon], loc->tm_mday, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000000), 5*loctime, timezonefmt, loc->tm_year);
+        } else if (timeunit == CLOG_TIMEUNIT_USEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s %.3s %02d %02d:%02d:%02d.%06d UTC%.*s %04d", clog_week_strs[loc->tm_wday], clog_month_strs[loc->tm_mon], loc->tm_mday, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000), 5*loctime, timezonefmt, loc->tm_year);
+        } else {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s %.3s %02d %02d:%02d:%02d UTC%.*s %04d", clog_week_strs[loc->tm_wday], clog_month_strs[loc->tm_mon], loc->tm_mday, loc->tm_hour, loc->tm_min, loc->tm_sec, 5*loctime, timezonefmt, loc->tm_year);
+        }
+    } else if (dateformat == CLOG_DATEFMT_RFC_2822) {
+        /* "Thu, 26 Dec 2019 10:12:45 +0800" */
+        if (timeunit == CLOG_TIMEUNIT_MSEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s, %02d %.3s %04d %02d:%02d:%02d.%03d %.*s", clog_week_strs[loc->tm_wday], loc->tm_mday, clog_month_strs[loc->tm_mon], loc->tm_year, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000000), 5, timezonefmt);
+        } else if (timeunit == CLOG_TIMEUNIT_USEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s, %02d %.3s %04d %02d:%02d:%02d.%06d %.*s", clog_week_strs[loc->tm_wday], loc->tm_mday, clog_month_strs[loc->tm_mon], loc->tm_year, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000), 5, timezonefmt);
+        } else {
+            fmtlen = snprintf(buf, bufsz,
+                "%.3s, %02d %.3s %04d %02d:%02d:%02d %.*s", clog_week_strs[loc->tm_wday], loc->tm_mday, clog_month_strs[loc->tm_mon], loc->tm_year, loc->tm_hour, loc->tm_min, loc->tm_sec, 5, timezonefmt);
+        }
+    } else {
+        /* CLOG_DATEFMT_NUMERIC_1 = "20191226101245+0800", CLOG_DATEFMT_NUMERIC_2 = "20191226-101245+0800" */
+        char minuschr[2] = {'-', '\0'};
+
+        if (dateformat == CLOG_DATEFMT_NUMERIC_1) {
+            minuschr[0] = '\0';
+        }
+
+        if (timeunit == CLOG_TIMEUNIT_MSEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%04d%02d%02d%s%02d%02d%02d.%03d%.*s", loc->tm_year, loc->tm_mon, loc->tm_mday, minuschr, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000000), 5, timezonefmt);
+        } else if (timeunit == CLOG_TIMEUNIT_USEC) {
+            fmtlen = snprintf(buf, bufsz,
+                "%04d%02d%02d%s%02d%02d%02d.%06d%.*s", loc->tm_year, loc->tm_mon, loc->tm_mday, minuschr, loc->tm_hour, loc->tm_min, loc->tm_sec, (int)(nsec / 1000), 5, timezonefmt);
+        } else {
+            fmtlen = snprintf(buf, bufsz,
+                "%04d%02d%02d%s%02d%02d%02d%.*s", loc->tm_year, loc->tm_mon, loc->tm_mday, minuschr, loc->tm_hour, loc->tm_min, loc->tm_sec, 5, timezonefmt);
+        }
+    }
+
+    if (fmtlen < 0) {
+        fmtlen = 0;
+    } else if ((size_t) fmtlen >= bufsz) {
+        fmtlen = (int) bufsz - 1;
+    }
+    return (size_t) fmtlen;
+}
+
+
+#define DATED_PUTC(c)  do { \
+        if (len < outsz) { \
+            outbuf[len++] = (c); \
+        } \
+    } while(0)
+
+#define DATED_PUTN(s, n)  do { \
+        size_t __n = (size_t)(n); \
+        if (__n > outsz - len) { \
+            __n = outsz - len; \
+        } \
+        memcpy(outbuf + len, (s), __n); \
+        len += __n; \
+    } while(0)
+
+
+size_t logger_format_dated (const logger_dated_opts *opts, const logger_record *rec, char *outbuf, size_t outsz)
+{
+    size_t len = 0;
+    int levellen = 0;
+    const char *levelstr;
+
+    char fmtbuf[CLOG_DATEFMT_SIZE_MAX];
+    size_t fmtlen;
+
+    struct tm loc = {0};
+    long nsec = (long) (rec->timestamp % 1000000000ULL);
+    int timeunit = ((opts->flags & LOGGER_DATED_TIMEUNITMS)? CLOG_TIMEUNIT_MSEC :
+                        ((opts->flags & LOGGER_DATED_TIMEUNITUS)? CLOG_TIMEUNIT_USEC : CLOG_TIMEUNIT_SEC));
+
+    if (opts->flags & LOGGER_DATED_TIMESTAMPID) {
+        fmtlen = snprintf(fmtbuf, sizeof(fmtbuf), "{%"PRId64".%09d}", (int64_t)(rec->stampid / 1000000000ULL), (int)(rec->stampid % 1000000000ULL));
+        DATED_PUTN(fmtbuf, fmtlen);
+        DATED_PUTC(32);
+    }
+
+    if (opts->flags & LOGGER_DATED_SEQUENCE) {
+        fmtlen = snprintf(fmtbuf, sizeof(fmtbuf), "#%"PRIu64, (uint64_t) rec->seq);
+        DATED_PUTN(fmtbuf, fmtlen);
+        DATED_PUTC(32);
+    }
+
+    getlocaltime_safe(&loc, (int64_t)(rec->timestamp / 1000000000ULL), opts->timezone, opts->daylight);
+    loc.tm_year += 1900;
+    loc.tm_mon += 1;
+
+    fmtlen = logger_format_datetime(opts->dateformat, timeunit, (opts->flags & LOGGER_DATED_LOCTIME)? 1 : 0, opts->tzfmt, &loc, nsec, fmtbuf, sizeof(fmtbuf));
+    DATED_PUTN(fmtbuf, fmtlen);
+    DATED_PUTC(32);
+
+    levelstr = clog_level_to_string(rec->level, &levellen);
+    DATED_PUTN(levelstr, levellen);
+    DATED_PUTC(32);
+
+    if (! (opts->flags & LOGGER_DATED_HIDEIDENT)) {
+        DATED_PUTC('<');
+        DATED_PUTN(opts->ident, opts->identlen);
+        DATED_PUTC('>');
+        DATED_PUTC(32);
+    }
+
+    if ((opts->flags & LOGGER_DATED_FILELINENO) && rec->filelen) {
+        fmtlen = snprintf(fmtbuf, sizeof(fmtbuf), ":%u", (unsigned) rec->lineno);
+
+        DATED_PUTC('(');
+        DATED_PUTN(rec->file, rec->filelen);
+        DATED_PUTN(fmtbuf, fmtlen);
+        if (opts->flags & LOGGER_DATED_FUNCTION) {
+            DATED_PUTN("::", 2);
+            DATED_PUTN(rec->func, rec->funclen);
+        }
+        DATED_PUTC(')');
+        DATED_PUTC(32);
+    }
+
+    if ((opts->flags & LOGGER_DATED_PROCESSID) && ! (rec->flags & LOGGER_RECORD_NOTHREAD)) {
+        DATED_PUTC('[');
+        DATED_PUTN(opts->pidcstr, opts->pidcstrlen);
+        if (opts->flags & LOGGER_DATED_THREADNO) {
+            fmtlen = snprintf(fmtbuf, sizeof(fmtbuf), "/%d", (int) rec->threadid);
+            DATED_PUTN(fmtbuf, fmtlen);
+        }
+        DATED_PUTC(']');
+        DATED_PUTC(32);
+    }
+
+    if (rec->flags & LOGGER_RECORD_BACKTRACE) {
+        DATED_PUTN("[backtrace] ", 12);
+    }
+
+    if ((rec->flags & LOGGER_RECORD_MDC) && len < outsz) {
+        /* [k1=v1 k2=v2] or {"k1":"v1","k2":"v2"} */
+        if (opts->kvformat == CLOG_KVFORMAT_JSON) {
+            len += logger_kv_render(CLOG_KVFORMAT_JSON, rec->mdc, rec->mdclen, outbuf + len, outsz - len);
+        } else {
+            DATED_PUTC('[');
+            len += logger_kv_render(CLOG_KVFORMAT_LOGFMT, rec->mdc, rec->mdclen, outbuf + len, outsz - len);
+            DATED_PUTC(']');
+        }
+        DATED_PUTC(32);
+    }
+
+    if (len < outsz) {
+        if (rec->flags & LOGGER_RECORD_KV) {
+            len += logger_kv_render(opts->kvformat, rec->args, rec->argslen, outbuf + len, outsz - len);
+        } else {
+            len += logger_fmt_replay(rec->fmt, rec->fmtlen, rec->args, rec->argslen, outbuf + len, outsz - len);
+        }
+    }
+
+    if (opts->flags & LOGGER_DATED_AUTOWRAPLINE) {
+        if (len == outsz) {
+            len--;
+        }
+        if (! len || outbuf[len - 1] != '\n') {
+            outbuf[len++] = '\n';
+        }
+    }
+
+    return len;
+}
@@ -0,0 +1,180 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerfmt.h
+**  message formatting shared by logthread and decoders.
+**
+**  - deferred capture of printf arguments into compact bytes and replay
+**     of them into text later (by logthread or clogcat).
+**  - datetime and DATED line rendering from raw timestamp.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 11:20:05
+** @date      2026-10-18 11:20:05
+*/
+#ifndef _LOGGERFMT_PRIVATE_H_
+#define _LOGGERFMT_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/basetype.h>
+
+#include "clogger_api.h"
+
+
+/**
+ * options for rendering DATED line
+ */
+#define LOGGER_DATED_TIMEUNITMS     0x0001
+#define LOGGER_DATED_TIMEUNITUS     0x0002
+#define LOGGER_DATED_LOCTIME        0x0004
+#define LOGGER_DATED_TIMESTAMPID    0x0008
+#define LOGGER_DATED_FILELINENO     0x0010
+#define LOGGER_DATED_FUNCTION       0x0020
+#define LOGGER_DATED_PROCESSID      0x0040
+#define LOGGER_DATED_THREADNO       0x0080
+#define LOGGER_DATED_AUTOWRAPLINE   0x0100
+#define LOGGER_DATED_HIDEIDENT      0x0200
+#define LOGGER_DATED_SEQUENCE       0x0400
+
+typedef struct
+{
+    ub4 flags;
+
+    clog_dateformat_t dateformat;
+    clog_kvformat_t kvformat;
+
+    /* timezone in seconds and daylight in effect */
+    int timezone;
+    int daylight;
+
+    /* "+0800" */
+    int tzfmtlen;
+    const char *tzfmt;
+
+    int identlen;
+    const char *ident;
+
+    int pidcstrlen;
+    const char *pidcstr;
+} logger_dated_opts;
+
+
+/* payload of record is encoded key-value fields rather than printf args */
+#define LOGGER_RECORD_KV         0x01
+
+/* no [pid/tid] in line as clog_logger_log_message() */
+#define LOGGER_RECORD_NOTHREAD   0x02
+
+/* record carries diagnostic context of thread as encoded fields */
+#define LOGGER_RECORD_MDC        0x04
+
+/* record not logged at its time, kept for ERROR logged later (loggerbt.h) */
+#define LOGGER_RECORD_BACKTRACE  0x08
+
+/**
+ * one message with deferred arguments
+ */
+typedef struct
+{
+    /* nanoseconds since epoch */
+    ub8 timestamp;
+
+    /* nanoseconds of rtclock for stamp id (0 if not used) */
+    ub8 stampid;
+
+    /* order of message put by callers (LOGGER_DATED_SEQUENCE) */
+    ub8 seq;
+
+    ub4 threadid;
+    ub4 lineno;
+
+    clog_level_t level;
+    int flags;
+
+    int filelen;
+    const char *file;
+
+    int funclen;
+    const char *func;
+
+    /* encoded fields of context if LOGGER_RECORD_MDC */
+    int mdclen;
+    const char *mdc;
+
+    int fmtlen;
+    const char *fmt;
+
+    size_t argslen;
+    const char *args;
+} logger_record;
+
+
+/**
+ * logger_fmt_capture
+ *   encode arguments consumed by format into buf without formatting them.
+ * returns:
+ *   bytes encoded on success.
+ *   -1 if format has unsupported conversion (%n, %m, %ls, %Lf, %1$d, ...)
+ *    or buf is too small. caller should fallback to vsnprintf.
+ */
+extern int logger_fmt_capture (const char *format, va_list args, char *buf, size_t bufsz);
+
+
+/**
+ * logger_fmt_replay
+ *   render format with arguments encoded by logger_fmt_capture. output is the
+ *   same as vsnprintf but not null-terminated and truncated at outsz.
+ * returns:
+ *   bytes rendered.
+ */
+extern size_t logger_fmt_replay (const char *format, size_t fmtlen, const char *args, size_t argslen, char *outbuf, size_t outsz);
+
+
+/**
+ * logger_format_datetime
+ *   datetime string for DATED layout. loc must be adjusted already
+ *   (tm_year += 1900, tm_mon += 1).
+ */
+extern size_t logger_format_datetime (clog_dateformat_t dateformat, int timeunit, int loctime, const char *timezonefmt, const struct tm *loc, long nsec, char *buf, size_t bufsz);
+
+
+/**
+ * logger_format_dated
+ *   render record as DATED line (without colors).
+ * returns:
+ *   bytes rendered (not null-terminated).
+ */
+extern size_t logger_format_dated (const logger_dated_opts *opts, const logger_record *rec, char *outbuf, size_t outsz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERFMT_PRIVATE_H_ */
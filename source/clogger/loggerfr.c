@@ -0,0 +1,241 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerfr.c
+**  flight recorder: ringbuffer of logger in mmaped file.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 21:05:47
+** @date      2026-10-18 21:05:47
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+
+#include "loggerfr.h"
+
+#include <signal.h>
+#include <errno.h>
+
+#if ! defined(__WINDOWS__)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/file.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+#endif
+
+
+#define LOGGERFR_MAGIC      "CLOGFR\0\2"
+
+/* ringbuffer starts at offset of file aligned by UATOMIC_CACHELINE_SIZE */
+#define LOGGERFR_HDRSIZE    UATOMIC_CACHELINE_SIZE
+
+
+typedef struct
+{
+    char magic[8];
+    ub4 magickey;
+    ub4 eltsizemax;
+
+    /* bytes of ringbuffer after header */
+    ub8 memsize;
+} logger_fr_hdr;
+
+
+/* ringbuffer in file mapped at addr. header of other logger or layout is reset */
+static ring_buffer_st * logger_fr_attach (void *addr, size_t memsize, int eltsizemax, ub4 magickey, int *recovered)
+{
+    logger_fr_hdr *hdr = (logger_fr_hdr *) addr;
+    ring_buffer_st *rbst = (ring_buffer_st *) ((char *) addr + LOGGERFR_HDRSIZE);
+
+    if (memcmp(hdr->magic, LOGGERFR_MAGIC, sizeof(hdr->magic)) || hdr->magickey != magickey ||
+        hdr->eltsizemax != (ub4) eltsizemax || hdr->memsize != (ub8) memsize) {
+        /* messages of other logger or layout are not taken */
+        bzero(rbst, sizeof(*rbst));
+
+        memcpy(hdr->magic, LOGGERFR_MAGIC, sizeof(hdr->magic));
+        hdr->magickey = magickey;
+        hdr->eltsizemax = (ub4) eltsizemax;
+        hdr->memsize = (ub8) memsize;
+    }
+
+    rbst = ringbufst_init_mem(rbst, memsize);
+
+    *recovered = (rbst->ROffset != rbst->WOffset)? 1 : 0;
+    return rbst;
+}
+
+
+#if ! defined(__WINDOWS__)
+
+ring_buffer_st * logger_fr_open (const char *pathfile, int length, int eltsizemax, ub4 magickey, int *recovered, int *lockfd)
+{
+    struct stat sb;
+    void *addr;
+    int err;
+
+    size_t memsize = ringbufst_memsize(length, eltsizemax);
+    size_t filesize = LOGGERFR_HDRSIZE + memsize;
+
+    int fd = open(pathfile, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    /* file in use by other logger or process must not be reset under it */
+    if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+        err = errno;
+        close(fd);
+        errno = err;
+        return NULL;
+    }
+
+    if (fstat(fd, &sb) == -1 || ((size_t) sb.st_size != filesize && ftruncate(fd, (off_t) filesize) == -1)) {
+        err = errno;
+        close(fd);
+        errno = err;
+        return NULL;
+    }
+
+    addr = mmap(NULL, filesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        err = errno;
+        close(fd);
+        errno = err;
+        return NULL;
+    }
+
+    /* lock is held by fd until logger_fr_close */
+    *lockfd = fd;
+
+    return logger_fr_attach(addr, memsize, eltsizemax, magickey, recovered);
+}
+
+
+void logger_fr_close (ring_buffer_st *rbst, int lockfd)
+{
+    if (rbst) {
+        char *addr = (char *) rbst - LOGGERFR_HDRSIZE;
+        const logger_fr_hdr *hdr = (const logger_fr_hdr *) addr;
+
+        munmap(addr, LOGGERFR_HDRSIZE + (size_t) hdr->memsize);
+        close(lockfd);
+    }
+}
+
+
+static const int logger_fr_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+#define LOGGERFR_NUMSIGNALS  ((int)(sizeof(logger_fr_signals)/sizeof(logger_fr_signals[0])))
+
+static struct sigaction logger_fr_oldactions[LOGGERFR_NUMSIGNALS];
+
+static void (* volatile logger_fr_flush_cb)(void) = NULL;
+
+
+static void logger_fr_signal_handler (int signo)
+{
+    void (*flush_cb)(void) = logger_fr_flush_cb;
+    int i;
+
+    /* flush once even if it faults again */
+    logger_fr_flush_cb = NULL;
+
+    if (flush_cb) {
+        flush_cb();
+    }
+
+    for (i = 0; i < LOGGERFR_NUMSIGNALS; i++) {
+        if (logger_fr_signals[i] == signo) {
+            sigaction(signo, &logger_fr_oldactions[i], NULL);
+            break;
+        }
+    }
+
+    raise(signo);
+}
+
+
+void logger_fr_catch_signals (void (*flush_cb)(void))
+{
+    int i;
+    struct sigaction sa;
+
+    if (logger_fr_flush_cb) {
+        /* already caught */
+        return;
+    }
+    logger_fr_flush_cb = flush_cb;
+
+    bzero(&sa, sizeof(sa));
+    sa.sa_handler = logger_fr_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_NODEFER;
+
+    for (i = 0; i < LOGGERFR_NUMSIGNALS; i++) {
+        sigaction(logger_fr_signals[i], &sa, &logger_fr_oldactions[i]);
+    }
+}
+
+
+void logger_fr_release_signals (void)
+{
+    int i;
+
+    if (logger_fr_flush_cb) {
+        logger_fr_flush_cb = NULL;
+
+        for (i = 0; i < LOGGERFR_NUMSIGNALS; i++) {
+            sigaction(logger_fr_signals[i], &logger_fr_oldactions[i], NULL);
+        }
+    }
+}
+
+#else
+
+/* not supported on Windows: heap ringbuffer is used */
+ring_buffer_st * logger_fr_open (const char *pathfile, int length, int eltsizemax, ub4 magickey, int *recovered, int *lockfd)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+
+void logger_fr_close (ring_buffer_st *rbst, int lockfd)
+{
+}
+
+
+void logger_fr_catch_signals (void (*flush_cb)(void))
+{
+}
+
+
+void logger_fr_release_signals (void)
+{
+}
+
+#endif
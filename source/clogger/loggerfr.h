@@ -0,0 +1,82 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerfr.h
+**  private api for flight recorder: ringbuffer of logger in mmaped file.
+**
+**  Messages not yet taken by logthread are kept by the file if process
+**  crashes, and are logged by logthread when the file is opened by next
+**  process. Fatal signals are caught to write out what can be written
+**  without locks before process is terminated.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 21:05:47
+** @date      2026-10-18 21:05:47
+*/
+#ifndef _LOGGERFR_PRIVATE_H_
+#define _LOGGERFR_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/ringbufst.h>
+
+#include "clogger_api.h"
+
+
+/**
+ * logger_fr_open
+ *   map ringbuffer for length messages of eltsizemax bytes onto pathfile.
+ *   recovered is set to 1 if messages left by last process are kept.
+ *   pathfile is locked (flock) by lockfd until logger_fr_close.
+ * returns:
+ *   NULL if file cannot be mapped, or errno is EWOULDBLOCK if it is locked
+ *   by other logger or process. always NULL on Windows (ENOSYS).
+ */
+extern ring_buffer_st * logger_fr_open (const char *pathfile, int length, int eltsizemax, ub4 magickey, int *recovered, int *lockfd);
+
+
+extern void logger_fr_close (ring_buffer_st *rbst, int lockfd);
+
+
+/**
+ * logger_fr_catch_signals
+ *   call flush_cb once in handler of SIGSEGV, SIGBUS, SIGFPE, SIGILL and
+ *   SIGABRT, then signal is raised again with handler of application.
+ */
+extern void logger_fr_catch_signals (void (*flush_cb)(void));
+
+
+/* restore handlers of application */
+extern void logger_fr_release_signals (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERFR_PRIVATE_H_ */
@@ -0,0 +1,327 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerkv.c
+**  structured key-value fields encoding and rendering.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 09:20:31
+** @date      2026-10-18 09:20:31
+*/
+#include <common/basetype.h>
+#include <common/varint.h>
+#include <common/jsonesc.h>
+
+#include <math.h>
+
+#include "loggerkv.h"
+
+static const char THIS_FILE[] = "loggerkv.c";
+
+
+typedef struct
+{
+    char *buf;
+    size_t size;
+    size_t len;
+} kvout_buf;
+
+
+static void kvout_putc (kvout_buf *out, char c)
+{
+    if (out->len < out->size) {
+        out->buf[out->len++] = c;
+    }
+}
+
+
+static void kvout_putn (kvout_buf *out, const char *s, size_t n)
+{
+    if (n > out->size - out->len) {
+        n = out->size - out->len;
+    }
+    memcpy(out->buf + out->len, s, n);
+    out->len += n;
+}
+
+
+/* json string body without quotes */
+static void kvout_json_escape (kvout_buf *out, const char *s, size_t n)
+{
+    size_t i;
+
+    while ((i = json_escape_scan(s, n)) < n) {
+        char escbuf[8];
+
+        kvout_putn(out, s, i);
+        kvout_putn(out, escbuf, json_escape_copy(escbuf, s + i, 1));
+
+        s += i + 1;
+        n -= i + 1;
+    }
+
+    kvout_putn(out, s, n);
+}
+
+
+/* logfmt value: quoted only if needed */
+static void kvout_logfmt_value (kvout_buf *out, const char *s, size_t n)
+{
+    size_t i;
+    int quote = (n == 0);
+
+    for (i = 0; i < n && !quote; i++) {
+        ub1 c = (ub1) s[i];
+        if (c <= 0x20 || c == '=' || c == '"' || c == '\\') {
+            quote = 1;
+        }
+    }
+
+    if (! quote) {
+        kvout_putn(out, s, n);
+        return;
+    }
+
+    kvout_putc(out, '"');
+    kvout_json_escape(out, s, n);
+    kvout_putc(out, '"');
+}
+
+
+/* logfmt key: chars not allowed in key are replaced by '_' */
+static void kvout_logfmt_key (kvout_buf *out, const char *s, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        ub1 c = (ub1) s[i];
+        if (c <= 0x20 || c == '=' || c == '"') {
+            c = '_';
+        }
+        kvout_putc(out, (char) c);
+    }
+}
+
+
+size_t logger_kv_encode (const clog_kvfield_t *field, char *buf, size_t bufsz)
+{
+    ub1 *p = (ub1 *) buf;
+    size_t keylen, len = 0, slen = 0;
+    ub8 u = 0;
+
+    if (! field->key) {
+        return 0;
+    }
+
+    keylen = strnlen(field->key, CLOG_KV_KEYLEN_MAX);
+
+    /* room for type, keylen and key */
+    if (bufsz < 1 + 1 + keylen) {
+        return 0;
+    }
+    bufsz -= 1 + 1 + keylen;
+
+    /* room for value of real size */
+    switch (field->type) {
+    case CLOG_KV_INT64:
+        u = zigzag_encode64(field->value.i64);
+        if (bufsz < (size_t) varint_size64(u)) {
+            return 0;
+        }
+        break;
+
+    case CLOG_KV_DOUBLE:
+        if (bufsz < sizeof(double)) {
+            return 0;
+        }
+        break;
+
+    case CLOG_KV_BOOL:
+    case CLOG_KV_STRING:
+        if (bufsz < 1) {
+            return 0;
+        }
+        break;
+
+    default:
+        /* unknown type */
+        return 0;
+    }
+
+    p[len++] = (ub1) field->type;
+    p[len++] = (ub1) keylen;
+    memcpy(p + len, field->key, keylen);
+    len += keylen;
+
+    switch (field->type) {
+    case CLOG_KV_INT64:
+        len += varint_encode64(u, p + len);
+        break;
+
+    case CLOG_KV_DOUBLE:
+        memcpy(p + len, &field->value.dbl, sizeof(double));
+        len += sizeof(double);
+        break;
+
+    case CLOG_KV_BOOL:
+        p[len++] = (ub1) (field->value.i64 ? 1 : 0);
+        break;
+
+    case CLOG_KV_STRING:
+        if (field->value.str) {
+            slen = (field->length < 0? strlen(field->value.str) : (size_t) field->length);
+        }
+
+        /* truncate string to fit in */
+        if (slen + varint_size64((ub8) slen) > bufsz) {
+            slen = bufsz - varint_size64((ub8) bufsz);
+        }
+
+        len += varint_encode64((ub8) slen, p + len);
+        memcpy(p + len, field->value.str, slen);
+        len += slen;
+        break;
+    }
+
+    return len;
+}
+
+
+size_t logger_kv_render (clog_kvformat_t kvformat, const char *tlv, size_t tlvlen, char *outbuf, size_t outsz)
+{
+    const ub1 *p = (const ub1 *) tlv;
+    const ub1 *end = p + tlvlen;
+
+    int nfields = 0;
+    char numbuf[32];
+
+    kvout_buf out = {outbuf, outsz, 0};
+
+    if (kvformat == CLOG_KVFORMAT_JSON) {
+        kvout_putc(&out, '{');
+    }
+
+    while (end - p >= 2) {
+        int numlen;
+        ub8 u;
+        double dbl;
+
+        clog_kvtype_t type = (clog_kvtype_t) p[0];
+        size_t keylen = p[1];
+        const char *key = (const char *) p + 2;
+
+        p += 2 + keylen;
+        if (p > end) {
+            break;
+        }
+
+        if (nfields++) {
+            kvout_putc(&out, (kvformat == CLOG_KVFORMAT_JSON? ',' : 32));
+        }
+
+        if (kvformat == CLOG_KVFORMAT_JSON) {
+            kvout_putc(&out, '"');
+            kvout_json_escape(&out, key, keylen);
+            kvout_putn(&out, "\":", 2);
+        } else {
+            kvout_logfmt_key(&out, key, keylen);
+            kvout_putc(&out, '=');
+        }
+
+        switch (type) {
+        case CLOG_KV_INT64:
+            numlen = varint_decode64(p, end - p, &u);
+            if (! numlen) {
+                goto bad_tlv;
+            }
+            p += numlen;
+            numlen = snprintf(numbuf, sizeof(numbuf), "%"PRId64, (int64_t) zigzag_decode64(u));
+            kvout_putn(&out, numbuf, numlen);
+            break;
+
+        case CLOG_KV_DOUBLE:
+            if (end - p < (ptrdiff_t) sizeof(double)) {
+                goto bad_tlv;
+            }
+            memcpy(&dbl, p, sizeof(double));
+            p += sizeof(double);
+
+            if (kvformat == CLOG_KVFORMAT_JSON && !isfinite(dbl)) {
+                /* json has no NaN and Infinity */
+                kvout_putn(&out, "null", 4);
+            } else {
+                numlen = snprintf(numbuf, sizeof(numbuf), "%.15g", dbl);
+                kvout_putn(&out, numbuf, numlen);
+            }
+            break;
+
+        case CLOG_KV_BOOL:
+            if (p == end) {
+                goto bad_tlv;
+            }
+            if (*p++) {
+                kvout_putn(&out, "true", 4);
+            } else {
+                kvout_putn(&out, "false", 5);
+            }
+            break;
+
+        case CLOG_KV_STRING:
+            numlen = varint_decode64(p, end - p, &u);
+            if (! numlen || u > (ub8) (end - p - numlen)) {
+                goto bad_tlv;
+            }
+            p += numlen;
+
+            if (kvformat == CLOG_KVFORMAT_JSON) {
+                kvout_putc(&out, '"');
+                kvout_json_escape(&out, (const char *) p, (size_t) u);
+                kvout_putc(&out, '"');
+            } else {
+                kvout_logfmt_value(&out, (const char *) p, (size_t) u);
+            }
+            p += u;
+            break;
+
+        default:
+            goto bad_tlv;
+        }
+    }
+
+    if (kvformat == CLOG_KVFORMAT_JSON) {
+        kvout_putc(&out, '}');
+    }
+    return out.len;
+
+bad_tlv:
+    /* should never happen unless memory corrupted */
+    if (kvformat == CLOG_KVFORMAT_JSON) {
+        kvout_putn(&out, "null}", 5);
+    } else {
+        kvout_putn(&out, "(bad kv)", 8);
+    }
+    return out.len;
+}
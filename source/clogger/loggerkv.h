@@ -0,0 +1,85 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerkv.h
+**  private api for structured key-value fields.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 09:20:31
+** @date      2026-10-18 09:20:31
+*/
+#ifndef _LOGGERKV_PRIVATE_H_
+#define _LOGGERKV_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "clogger_api.h"
+
+/**
+ * key-value fields are encoded by producer as TLV and rendered by the
+ *  logger thread. encoding of one field:
+ *
+ *    type(1) | keylen(1) | key(keylen) | value
+ *
+ *  value by type:
+ *    CLOG_KV_INT64  - zigzag varint (1..10 bytes)
+ *    CLOG_KV_DOUBLE - 8 bytes IEEE-754 in host order
+ *    CLOG_KV_BOOL   - 1 byte (0 or 1)
+ *    CLOG_KV_STRING - varint length | bytes
+ */
+#define CLOG_KV_KEYLEN_MAX     255
+
+
+/**
+ * logger_kv_encode
+ *   encode one field into buf. key is truncated to CLOG_KV_KEYLEN_MAX and
+ *   string value is truncated to fit in bufsz.
+ * returns:
+ *   bytes written, 0 if no room left for key and value of field (or at
+ *   least its length for string).
+ */
+extern size_t logger_kv_encode (const clog_kvfield_t *field, char *buf, size_t bufsz);
+
+
+/**
+ * logger_kv_render
+ *   render encoded fields as logfmt or json text into outbuf (not null-terminated).
+ *   output is truncated at outsz bytes.
+ * returns:
+ *   bytes rendered.
+ */
+extern size_t logger_kv_render (clog_kvformat_t kvformat, const char *tlv, size_t tlvlen, char *outbuf, size_t outsz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERKV_PRIVATE_H_ */
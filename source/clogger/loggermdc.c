@@ -0,0 +1,273 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggermdc.c
+**  thread-local diagnostic context (MDC).
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 18:40:12
+** @date      2026-10-18 18:40:12
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+
+#include "loggermdc.h"
+#include "loggerkv.h"
+
+
+typedef struct
+{
+    /* key (null-terminated) and value in strbuf */
+    ub2 keyoff;
+    ub2 keylen;
+    ub2 valoff;
+    ub2 vallen;
+} logger_mdc_field;
+
+
+typedef struct
+{
+    int numfields;
+    int numscopes;
+    int strused;
+
+    logger_mdc_field fields[LOGGERMDC_FIELDS_MAX];
+
+    /* fields and bytes of strbuf owned by outer scopes */
+    struct {
+        int numfields;
+        int strused;
+    } scopes[LOGGERMDC_SCOPES_MAX];
+
+    char strbuf[LOGGERMDC_STRBUF_SIZE];
+
+    /* 0 if fields changed since rendered */
+    int rendered;
+
+    int tlvlen;
+    int textlen;
+    int jsonlen;
+    char tlv[LOGGERMDC_STRBUF_SIZE + LOGGERMDC_FIELDS_MAX * 8];
+    char text[LOGGERMDC_TEXT_SIZE];
+    char json[LOGGERMDC_TEXT_SIZE];
+} logger_mdc_t;
+
+
+static THREAD_LOCAL logger_mdc_t threadmdc;
+
+
+/* remove field at index and its bytes in strbuf */
+static void logger_mdc_remove (logger_mdc_t *mdc, int index)
+{
+    logger_mdc_field *field = &mdc->fields[index];
+
+    int off = field->keyoff;
+    int cb = field->keylen + 1 + field->vallen;
+    int i;
+
+    memmove(mdc->strbuf + off, mdc->strbuf + off + cb, mdc->strused - off - cb);
+    mdc->strused -= cb;
+
+    for (i = index + 1; i < mdc->numfields; i++) {
+        mdc->fields[i].keyoff -= (ub2) cb;
+        mdc->fields[i].valoff -= (ub2) cb;
+        mdc->fields[i - 1] = mdc->fields[i];
+    }
+
+    mdc->numfields--;
+}
+
+
+static void logger_mdc_render (logger_mdc_t *mdc)
+{
+    int i, k;
+    size_t tlvlen = 0, len;
+
+    for (i = 0; i < mdc->numfields; i++) {
+        const logger_mdc_field *field = &mdc->fields[i];
+        clog_kvfield_t kv;
+
+        /* shadowed by same key of inner scope */
+        for (k = i + 1; k < mdc->numfields; k++) {
+            if (mdc->fields[k].keylen == field->keylen && ! memcmp(mdc->strbuf + mdc->fields[k].keyoff, mdc->strbuf + field->keyoff, field->keylen)) {
+                break;
+            }
+        }
+        if (k < mdc->numfields) {
+            continue;
+        }
+
+        kv.key = mdc->strbuf + field->keyoff;
+        kv.type = CLOG_KV_STRING;
+        kv.length = field->vallen;
+        kv.value.str = mdc->strbuf + field->valoff;
+
+        tlvlen += logger_kv_encode(&kv, mdc->tlv + tlvlen, sizeof(mdc->tlv) - tlvlen);
+    }
+
+    mdc->tlvlen = (int) tlvlen;
+
+    mdc->text[0] = '[';
+    len = logger_kv_render(CLOG_KVFORMAT_LOGFMT, mdc->tlv, tlvlen, mdc->text + 1, sizeof(mdc->text) - 2);
+    mdc->text[len + 1] = ']';
+    mdc->textlen = (int) len + 2;
+
+    mdc->jsonlen = (int) logger_kv_render(CLOG_KVFORMAT_JSON, mdc->tlv, tlvlen, mdc->json, sizeof(mdc->json));
+
+    mdc->rendered = 1;
+}
+
+
+const char * logger_mdc_fields (int *len)
+{
+    logger_mdc_t *mdc = &threadmdc;
+
+    if (! mdc->numfields) {
+        return NULL;
+    }
+
+    if (! mdc->rendered) {
+        logger_mdc_render(mdc);
+    }
+
+    *len = mdc->tlvlen;
+    return mdc->tlv;
+}
+
+
+const char * logger_mdc_text (clog_kvformat_t kvformat, int *len)
+{
+    logger_mdc_t *mdc = &threadmdc;
+
+    if (! mdc->numfields) {
+        return NULL;
+    }
+
+    if (! mdc->rendered) {
+        logger_mdc_render(mdc);
+    }
+
+    if (kvformat == CLOG_KVFORMAT_JSON) {
+        *len = mdc->jsonlen;
+        return mdc->json;
+    }
+
+    *len = mdc->textlen;
+    return mdc->text;
+}
+
+
+/**
+ * public api
+ */
+int clog_mdc_put (const char *key, const char *value)
+{
+    logger_mdc_t *mdc = &threadmdc;
+    logger_mdc_field *field;
+
+    int base = (mdc->numscopes? mdc->scopes[mdc->numscopes - 1].numfields : 0);
+    int keylen = (key? (int) strnlen(key, CLOG_KV_KEYLEN_MAX) : 0);
+    int vallen, i;
+
+    if (! keylen) {
+        return 0;
+    }
+
+    /* same key in current scope is replaced */
+    for (i = base; i < mdc->numfields; i++) {
+        if (mdc->fields[i].keylen == keylen && ! memcmp(mdc->strbuf + mdc->fields[i].keyoff, key, keylen)) {
+            logger_mdc_remove(mdc, i);
+            mdc->rendered = 0;
+            break;
+        }
+    }
+
+    if (! value) {
+        return 1;
+    }
+
+    vallen = (int) strnlen(value, LOGGERMDC_STRBUF_SIZE);
+    if (mdc->numfields == LOGGERMDC_FIELDS_MAX || mdc->strused + keylen + 1 + vallen > LOGGERMDC_STRBUF_SIZE) {
+        /* no room */
+        return 0;
+    }
+
+    field = &mdc->fields[mdc->numfields++];
+
+    field->keyoff = (ub2) mdc->strused;
+    field->keylen = (ub2) keylen;
+    memcpy(mdc->strbuf + mdc->strused, key, keylen);
+    mdc->strused += keylen;
+    mdc->strbuf[mdc->strused++] = 0;
+
+    field->valoff = (ub2) mdc->strused;
+    field->vallen = (ub2) vallen;
+    memcpy(mdc->strbuf + mdc->strused, value, vallen);
+    mdc->strused += vallen;
+
+    mdc->rendered = 0;
+    return 1;
+}
+
+
+void clog_mdc_clear (void)
+{
+    logger_mdc_t *mdc = &threadmdc;
+
+    mdc->numfields = 0;
+    mdc->numscopes = 0;
+    mdc->strused = 0;
+    mdc->rendered = 0;
+}
+
+
+int clog_mdc_push (void)
+{
+    logger_mdc_t *mdc = &threadmdc;
+
+    if (mdc->numscopes == LOGGERMDC_SCOPES_MAX) {
+        return (-1);
+    }
+
+    mdc->scopes[mdc->numscopes].numfields = mdc->numfields;
+    mdc->scopes[mdc->numscopes].strused = mdc->strused;
+
+    return ++mdc->numscopes;
+}
+
+
+void clog_mdc_pop (void)
+{
+    logger_mdc_t *mdc = &threadmdc;
+
+    if (mdc->numscopes) {
+        mdc->numscopes--;
+
+        mdc->numfields = mdc->scopes[mdc->numscopes].numfields;
+        mdc->strused = mdc->scopes[mdc->numscopes].strused;
+        mdc->rendered = 0;
+    }
+}
@@ -0,0 +1,82 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggermdc.h
+**  private api for thread-local diagnostic context (MDC).
+**
+**  Fields put by a thread are kept in thread-local storage and rendered once
+**  after they are changed. Producers copy the rendered bytes into every
+**  message like [pid/tid]. Scopes pushed for nested requests are stacked:
+**  fields of inner scope shadow same keys of outer ones until popped.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 18:40:12
+** @date      2026-10-18 18:40:12
+*/
+#ifndef _LOGGERMDC_PRIVATE_H_
+#define _LOGGERMDC_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "clogger_api.h"
+
+
+#define LOGGERMDC_FIELDS_MAX     16
+#define LOGGERMDC_SCOPES_MAX     16
+
+/* bytes of keys and values of one thread */
+#define LOGGERMDC_STRBUF_SIZE    512
+
+/* bytes of rendered text (truncated if longer) */
+#define LOGGERMDC_TEXT_SIZE      1024
+
+
+/**
+ * logger_mdc_fields
+ *   context of calling thread as encoded fields (see loggerkv.h).
+ * returns:
+ *   NULL if context is empty.
+ */
+extern const char * logger_mdc_fields (int *len);
+
+
+/**
+ * logger_mdc_text
+ *   context of calling thread rendered as "[k1=v1 k2=v2]" (logfmt) or
+ *   {"k1":"v1","k2":"v2"} (json).
+ * returns:
+ *   NULL if context is empty.
+ */
+extern const char * logger_mdc_text (clog_kvformat_t kvformat, int *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERMDC_PRIVATE_H_ */
@@ -33,6 +33,13 @@
 */
 #include "loggermgr_i.h"
 
+#include <signal.h>
+
+#if defined(__linux__)
+# include <sys/inotify.h>
+# include <poll.h>
+#endif
+
 static pthread_once_t once_initialized = PTHREAD_ONCE_INIT;
 
 #ifdef CLOGGER_SHMGR_HANDLE
@@ -141,6 +148,110 @@ static logger_manager get_logger_manager_shared()
 }
 
 
+/* bumped by every logger_manager_init to invalidate cache of threads */
+static int clogger_epoch = 0;
+
+/* per-thread cache of resolved loggers by address of ident */
+#define CLOGGER_IDENT_CACHE  8
+
+typedef struct
+{
+    int epoch;
+    const char *ident;
+    const struct clogger_slot_t *slot;
+} clogger_ident_cache_t;
+
+static THREAD_LOCAL clogger_ident_cache_t clogger_ident_cache[CLOGGER_IDENT_CACHE];
+
+
+/* FNV-1a */
+static ub4 clogger_ident_hash (const char *ident, int *idlen)
+{
+    ub4 hash = 2166136261U;
+    const char *p = ident;
+
+    while (*p) {
+        hash = (hash ^ (ub1) *p++) * 16777619U;
+    }
+
+    *idlen = (int)(p - ident);
+    return hash;
+}
+
+
+static const struct clogger_slot_t * snapshot_find (const struct clogger_snapshot_t *snap, const char *ident)
+{
+    int idlen;
+    ub4 hash = clogger_ident_hash(ident, &idlen);
+    ub4 i = hash & snap->slotmask;
+
+    for (;;) {
+        const struct clogger_slot_t *slot = &snap->slots[i];
+        if (! slot->logger) {
+            return NULL;
+        }
+        if (slot->hash == hash && slot->idlen == idlen && ! memcmp(slot->ident, ident, idlen)) {
+            return slot;
+        }
+        i = (i + 1) & snap->slotmask;
+    }
+}
+
+
+/* write-locked: publish a new snapshot with all loggers in uthash */
+static void snapshot_publish (logger_manager mgr, int maxloggerid)
+{
+    struct clogger_ident_t *curr, *tmp;
+    struct clogger_snapshot_t *snap;
+
+    struct clogger_snapshot_t *old = (struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
+
+    ub4 numslots = 16;
+    while (numslots < (ub4) HASH_COUNT(mgr->loggers) * 2) {
+        numslots <<= 1;
+    }
+
+    snap = (struct clogger_snapshot_t *) mem_alloc_zero(1, sizeof(*snap) + sizeof(struct clogger_slot_t) * numslots);
+
+    snap->retired = old;
+    snap->maxloggerid = maxloggerid;
+    snap->slotmask = numslots - 1;
+
+    HASH_ITER(hh, mgr->loggers, curr, tmp) {
+        int idlen;
+        ub4 hash = clogger_ident_hash(curr->ident, &idlen);
+        ub4 i = hash & snap->slotmask;
+
+        while (snap->slots[i].logger) {
+            i = (i + 1) & snap->slotmask;
+        }
+
+        snap->slots[i].hash = hash;
+        snap->slots[i].idlen = idlen;
+        snap->slots[i].ident = curr->ident;
+        snap->slots[i].logger = curr->logger;
+
+        snap->idloggers[clog_logger_get_loggerid(curr->logger)] = curr->logger;
+    }
+
+    uatomic_ptr_store_rel(&mgr->snapshot, snap);
+}
+
+
+static void snapshot_free_all (logger_manager mgr)
+{
+    struct clogger_snapshot_t *snap = (struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
+
+    uatomic_ptr_store_rel(&mgr->snapshot, NULL);
+
+    while (snap) {
+        struct clogger_snapshot_t *retired = snap->retired;
+        mem_free(snap);
+        snap = retired;
+    }
+}
+
+
 static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *ident)
 {
     if (! ident) {
@@ -151,52 +262,45 @@ static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *
 
         clog_logger logger = NULL;
 
-    #ifdef DISABLE_THREAD_RWLOCK
-        if (pthread_mutex_lock(&mgr->thrlock) != 0) {
-            emerglog_exit("libclogger", "pthread_mutex_lock error(%d)", errno);
-        }
+        const struct clogger_snapshot_t *snap;
+        const struct clogger_slot_t *slot;
 
-        if (! mgr->cfgfile) {
-            pthread_mutex_unlock(&mgr->thrlock);
-            printf("(%s:%d %s) ERROR: config file not found.\n", __FILE__, __LINE__, __FUNCTION__);
-            return NULL;
-        }
-    #else
-        if (RWLockAcquire(&mgr->rwlock, RWLOCK_STATE_READ, 0) != 0) {
-            emerglog_exit("libclogger", "RWLockAcquire error");
-        }
+        clogger_ident_cache_t *cache = &clogger_ident_cache[((uintptr_t) ident >> 3) & (CLOGGER_IDENT_CACHE - 1)];
 
         if (! mgr->cfgfile) {
-            RWLockRelease(&mgr->rwlock, RWLOCK_STATE_READ);
             printf("(%s:%d %s) ERROR: config file not found.\n", __FILE__, __LINE__, __FUNCTION__);
             return NULL;
         }
-    #endif
 
-        /* uthash is not threads-safety! */
-        HASH_FIND_STR(mgr->loggers, ident, elt);
+        /* ident may be in a buffer reused by caller */
+        if (cache->ident == ident && cache->epoch == clogger_epoch && ! strcmp(cache->slot->ident, ident)) {
+            return cache->slot->logger;
+        }
 
-        if (elt) {
-            logger = elt->logger;
+        snap = (const struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
+        if (snap) {
+            slot = snapshot_find(snap, ident);
 
-        #ifdef DISABLE_THREAD_RWLOCK
-            pthread_mutex_unlock(&mgr->thrlock);
-        #else
-            RWLockRelease(&mgr->rwlock, RWLOCK_STATE_READ);
-        #endif
+            if (slot) {
+                cache->epoch = clogger_epoch;
+                cache->ident = ident;
+                cache->slot = slot;
 
-            /* success get an existed logger */
-            return logger;
+                /* success get an existed logger */
+                return slot->logger;
+            }
         }
 
         /* not found, reload config file to find logger */
-    #ifndef DISABLE_THREAD_RWLOCK
-        RWLockRelease(&mgr->rwlock, RWLOCK_STATE_READ);
-
-        /* re-lock for write */
+    #ifdef DISABLE_THREAD_RWLOCK
+        if (pthread_mutex_lock(&mgr->thrlock) != 0) {
+            emerglog_exit("libclogger", "pthread_mutex_lock error(%d)", errno);
+        }
+    #else
         if (RWLockAcquire(&mgr->rwlock, RWLOCK_STATE_WRITE, 0) != 0) {
             emerglog_exit("libclogger", "RWLockAcquire failed");
         }
+    #endif
 
         /* refind logger again */
         HASH_FIND_STR(mgr->loggers, ident, elt);
@@ -204,15 +308,19 @@ static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *
         if (elt) {
             logger = elt->logger;
 
+        #ifdef DISABLE_THREAD_RWLOCK
+            pthread_mutex_unlock(&mgr->thrlock);
+        #else
             RWLockRelease(&mgr->rwlock, RWLOCK_STATE_WRITE);
+        #endif
 
             /* success get an existed logger */
             return logger;
         }
-    #endif
 
         /* logger not found and we got write lock here */
-        maxloggerid = ptr_cast_to_int(mgr->idloggers[0]);
+        snap = (const struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
+        maxloggerid = (snap? snap->maxloggerid : 0);
 
         if (maxloggerid < CLOG_LOGGERID_MAX) {
             logger_conf_t conf = {0};
@@ -224,7 +332,7 @@ static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *
             elt->idlen = conf.ident->len;
             memcpy(elt->ident, conf.ident->str, elt->idlen);
 
-            if (logger_conf_load_config(mgr->cfgfile->str, elt->ident, &conf) != 0) {
+            if (logger_conf_load_index(mgr->cfgindex, elt->ident, &conf) != 0) {
                 logger_conf_final_release(&conf);
 
                 mem_free(elt);
@@ -245,10 +353,9 @@ static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *
                 elt->logger = logger;
                 maxloggerid = clog_logger_get_loggerid(elt->logger);
 
-                mgr->idloggers[maxloggerid] = elt->logger;
-                mgr->idloggers[0] = (clog_logger) int_cast_to_ptr(maxloggerid);
-
                 HASH_ADD_STR_LEN(mgr->loggers, ident, elt->idlen, elt);
+
+                snapshot_publish(mgr, maxloggerid);
             }
         }
 
@@ -265,42 +372,28 @@ static clog_logger  logger_manager_load_shared (logger_manager mgr, const char *
 
 static clog_logger logger_manager_get_shared (logger_manager mgr, int loggerid)
 {
-    clog_logger logger = NULL;
+    const struct clogger_snapshot_t *snap = (const struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
 
-#ifdef DISABLE_THREAD_RWLOCK
-    if (pthread_mutex_lock(&mgr->thrlock) == 0)
-#else
-    if (RWLockAcquire(&mgr->rwlock, RWLOCK_STATE_READ, 0) == 0)
-#endif
-    {
-        if (loggerid == 0) {
-            // get the first logger
-            logger = mgr->idloggers[1];
-            goto return_logger;
-        }
+    if (! snap) {
+        return NULL;
+    }
 
-        if (loggerid == -1) {
-            // get the last logger
-            int lastid = ptr_cast_to_int(mgr->idloggers[0]);
-            logger = mgr->idloggers[lastid];
-            goto return_logger;
-        }
+    if (loggerid == 0) {
+        // get the first logger
+        return snap->idloggers[1];
+    }
 
-        if (loggerid > 0 && loggerid <= CLOG_LOGGERID_MAX) {
-            // get logger by id
-            logger = mgr->idloggers[loggerid];
-            goto return_logger;
-        }
+    if (loggerid == -1) {
+        // get the last logger
+        return snap->idloggers[snap->maxloggerid];
+    }
 
-return_logger:
-    #ifdef DISABLE_THREAD_RWLOCK
-        pthread_mutex_unlock(&mgr->thrlock);
-    #else
-        RWLockRelease(&mgr->rwlock, RWLOCK_STATE_READ);
-    #endif
+    if (loggerid > 0 && loggerid <= CLOG_LOGGERID_MAX) {
+        // get logger by id
+        return snap->idloggers[loggerid];
     }
 
-    return logger;
+    return NULL;
 }
 
 
@@ -309,7 +402,7 @@ return_logger:
  */
 logger_manager get_logger_manager()
 {
-    logger_manager mgr = (logger_manager) uatomic_ptr_get(&clogger_singleton.pvmgr);
+    logger_manager mgr = (logger_manager) uatomic_ptr_load_acq(&clogger_singleton.pvmgr);
     if (! mgr) {
         mgr = get_logger_manager_shared();
         if (uatomic_ptr_set(&clogger_singleton.pvmgr, mgr)) {
@@ -356,6 +449,136 @@ static void loggerCheckErrorExit_1(clog_logger logger, const char* reportdir, co
 }
 
 
+
+/* set by handler of SIGHUP, cleared by reloadthread */
+static volatile sig_atomic_t clogger_sighup = 0;
+
+#ifdef SIGHUP
+static struct sigaction clogger_oldsighup;
+
+static void clogger_sighup_handler (int signo)
+{
+    clogger_sighup = 1;
+}
+#endif
+
+
+#if ! defined(__linux__)
+/* modified time and size of config file polled once a second */
+static int64_t cfgfile_stamp (const char *cfgfile)
+{
+    struct stat sb;
+    if (stat(cfgfile, &sb) != 0) {
+        return 0;
+    }
+    return (int64_t) sb.st_mtime * 1000003 + (int64_t) sb.st_size;
+}
+#endif
+
+
+static void * reload_threadfunc (void *arg)
+{
+    logger_manager mgr = (logger_manager) arg;
+
+    int flags;
+
+    const char *cfgfile = cstrbufGetStr(mgr->cfgfile);
+    int namelen = cstrbufGetLen(mgr->cfgfile);
+    const char *basename = clog_logger_file_basename(cfgfile, &namelen);
+
+#if defined(__linux__)
+    struct pollfd pfd;
+
+    pfd.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if (pfd.fd != -1) {
+        /* editors may replace the file by rename, so watch its directory */
+        char dirbuf[ROF_PATHPREFIX_LEN_MAX + 1];
+        int dirlen = (int)(basename - cfgfile);
+
+        if (dirlen == 0) {
+            snprintf(dirbuf, sizeof(dirbuf), ".");
+        } else {
+            snprintf(dirbuf, sizeof(dirbuf), "%.*s", dirlen, cfgfile);
+        }
+
+        if (inotify_add_watch(pfd.fd, dirbuf, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+            close(pfd.fd);
+            pfd.fd = -1;
+        }
+    }
+#else
+    int64_t stamp = cfgfile_stamp(cfgfile);
+#endif
+
+    while ((flags = uatomic_int_get(&mgr->reloadflags)) != 0) {
+        int reload = 0;
+
+#if defined(__linux__)
+        if (pfd.fd != -1 && poll(&pfd, 1, 1000) > 0) {
+            char evbuf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t len = read(pfd.fd, evbuf, sizeof(evbuf));
+            ssize_t off = 0;
+
+            while (off + (ssize_t) sizeof(struct inotify_event) <= len) {
+                const struct inotify_event *ev = (const struct inotify_event *) (evbuf + off);
+                if (ev->len && ! strcmp(ev->name, basename)) {
+                    reload = (flags & CLOG_RELOAD_CFGFILE);
+                }
+                off += sizeof(struct inotify_event) + ev->len;
+            }
+        } else if (pfd.fd == -1) {
+            sleep_msec(1000);
+        }
+#else
+        sleep_msec(1000);
+
+        if (flags & CLOG_RELOAD_CFGFILE) {
+            int64_t newstamp = cfgfile_stamp(cfgfile);
+            if (newstamp != stamp) {
+                stamp = newstamp;
+                reload = 1;
+            }
+        }
+#endif
+
+        if ((flags & CLOG_RELOAD_SIGHUP) && clogger_sighup) {
+            clogger_sighup = 0;
+            reload = 1;
+        }
+
+        if (reload) {
+            logger_manager_reload();
+        }
+    }
+
+#if defined(__linux__)
+    if (pfd.fd != -1) {
+        close(pfd.fd);
+    }
+#endif
+    return (void*) 0;
+}
+
+
+static void reload_thread_stop (logger_manager mgr)
+{
+    int flags = uatomic_int_set(&mgr->reloadflags, 0);
+
+    if (flags) {
+        pthread_join(mgr->reloadthread, NULL);
+
+    #ifdef SIGHUP
+        if (flags & CLOG_RELOAD_SIGHUP) {
+            sigaction(SIGHUP, &clogger_oldsighup, NULL);
+        }
+    #endif
+    }
+}
+
+
 /**
  * clogger public api
  */
@@ -379,6 +602,15 @@ const char * logger_manager_init(const char *logger_cfg, ...)
 
         mgr->rtclock = rtclock_init(RTCLOCK_FREQ_SEC);
 
+    #ifndef CLOGGER_NO_CTLPAGE
+        mgr->ctl = loggerctl_create();
+        if (! mgr->ctl) {
+            printf("[%s:%d %s] control page not created\n", __FILE__, __LINE__, __FUNCTION__);
+        }
+    #endif
+
+        clogger_epoch++;
+
         do {
             const char *argp;
             va_list aplist;
@@ -421,6 +653,11 @@ const char * logger_manager_init(const char *logger_cfg, ...)
             emerglog_exit("libclogger", "config file not found: {%.*s}", cstrbufGetLen(mgr->cfgfile), cstrbufGetStr(mgr->cfgfile));
         }
 
+        mgr->cfgindex = ConfIndexLoad(cstrbufGetStr(mgr->cfgfile));
+        if (! mgr->cfgindex) {
+            emerglog_exit("libclogger", "config file not loaded: {%.*s}", cstrbufGetLen(mgr->cfgfile), cstrbufGetStr(mgr->cfgfile));
+        }
+
     #ifdef DISABLE_THREAD_RWLOCK
         pthread_mutex_unlock(&mgr->thrlock);
     #else
@@ -459,6 +696,9 @@ void logger_manager_uninit(void)
     if (uatomic_int_comp_exch(&mgr->initialized, 1, 0)) {
         struct clogger_ident_t *curr, *tmp;
 
+        /* reloadthread takes lock */
+        reload_thread_stop(mgr);
+
     #ifdef DISABLE_THREAD_RWLOCK
         pthread_mutex_lock(&mgr->thrlock);
     #else
@@ -473,10 +713,16 @@ void logger_manager_uninit(void)
             mem_free(curr);
         }
 
+        snapshot_free_all(mgr);
+
+        loggerctl_close(mgr->ctl);
+        mgr->ctl = NULL;
+
         rtclock_uninit(mgr->rtclock);
 
         cstrbufFree(&mgr->workdir);
         cstrbufFree(&mgr->cfgfile);
+        ConfIndexFree(mgr->cfgindex);
 
     #ifdef DISABLE_THREAD_RWLOCK
         pthread_mutex_destroy(&mgr->thrlock);
@@ -516,3 +762,152 @@ int logger_manager_get_stampid (char *stampidfmt, int fmtsize)
     rtclock_ticktime(mgr->rtclock, &ts);
     return snprintf(stampidfmt, fmtsize, "{%"PRId64".%09d}", (int64_t)ts.tv_sec, (int)ts.tv_nsec);
 }
+
+
+int logger_manager_reload (void)
+{
+    int restarts = 0;
+
+    CONF_index cfgindex, oldindex;
+    struct clogger_ident_t *curr, *tmp;
+
+    logger_manager mgr = get_logger_manager();
+    if (! mgr || ! uatomic_int_get(&mgr->initialized)) {
+        return (-1);
+    }
+
+    /* keep on current settings if config file is broken */
+    cfgindex = ConfIndexLoad(cstrbufGetStr(mgr->cfgfile));
+    if (! cfgindex) {
+        printf("[%s:%d %s] config file not reloaded: {%.*s}\n", __FILE__, __LINE__, __FUNCTION__, cstrbufGetLen(mgr->cfgfile), cstrbufGetStr(mgr->cfgfile));
+        return (-1);
+    }
+
+#ifdef DISABLE_THREAD_RWLOCK
+    if (pthread_mutex_lock(&mgr->thrlock) != 0) {
+        emerglog_exit("libclogger", "pthread_mutex_lock error(%d)", errno);
+    }
+#else
+    if (RWLockAcquire(&mgr->rwlock, RWLOCK_STATE_WRITE, 0) != 0) {
+        emerglog_exit("libclogger", "RWLockAcquire failed");
+    }
+#endif
+
+    oldindex = mgr->cfgindex;
+    mgr->cfgindex = cfgindex;
+
+    HASH_ITER(hh, mgr->loggers, curr, tmp) {
+        logger_conf_t conf = {0};
+
+        logger_conf_init_default(&conf, curr->ident, CLOG_PATHPREFIX_DEFAULT, 0);
+
+        if (logger_conf_load_index(cfgindex, curr->ident, &conf) == 0) {
+            if (clog_logger_reload(curr->logger, &conf) != 0) {
+                printf("[%s:%d %s] logger {%s} keeps keys changed until restart\n", __FILE__, __LINE__, __FUNCTION__, curr->ident);
+                restarts++;
+            }
+        }
+
+        logger_conf_final_release(&conf);
+    }
+
+#ifdef DISABLE_THREAD_RWLOCK
+    pthread_mutex_unlock(&mgr->thrlock);
+#else
+    RWLockRelease(&mgr->rwlock, RWLOCK_STATE_WRITE);
+#endif
+
+    ConfIndexFree(oldindex);
+
+    printf("[%s:%d %s] reload config file: {%.*s}\n", __FILE__, __LINE__, __FUNCTION__, cstrbufGetLen(mgr->cfgfile), cstrbufGetStr(mgr->cfgfile));
+    return restarts;
+}
+
+
+int logger_manager_autoreload (int flags)
+{
+    logger_manager mgr = get_logger_manager();
+    if (! mgr || ! uatomic_int_get(&mgr->initialized)) {
+        return (-1);
+    }
+
+    flags &= (CLOG_RELOAD_CFGFILE | CLOG_RELOAD_SIGHUP);
+
+    if (! flags) {
+        reload_thread_stop(mgr);
+        return 0;
+    }
+
+    if (uatomic_int_comp_exch(&mgr->reloadflags, 0, flags) != 0) {
+        /* already started */
+        return (-1);
+    }
+
+#ifdef SIGHUP
+    if (flags & CLOG_RELOAD_SIGHUP) {
+        struct sigaction sa;
+
+        bzero(&sa, sizeof(sa));
+        sa.sa_handler = clogger_sighup_handler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+
+        clogger_sighup = 0;
+        sigaction(SIGHUP, &sa, &clogger_oldsighup);
+    }
+#endif
+
+    if (pthread_create(&mgr->reloadthread, NULL, reload_threadfunc, (void*) mgr) != 0) {
+        uatomic_int_zero(&mgr->reloadflags);
+
+    #ifdef SIGHUP
+        if (flags & CLOG_RELOAD_SIGHUP) {
+            sigaction(SIGHUP, &clogger_oldsighup, NULL);
+        }
+    #endif
+        return (-1);
+    }
+
+    return 0;
+}
+
+
+int logger_manager_flush_all (int timeout_ms)
+{
+    int i, ret = 0;
+    struct timespec start, now;
+    const struct clogger_snapshot_t *snap;
+
+    logger_manager mgr = get_logger_manager();
+    if (! mgr || ! uatomic_int_get(&mgr->initialized)) {
+        return (-1);
+    }
+
+    snap = (const struct clogger_snapshot_t *) uatomic_ptr_load_acq(&mgr->snapshot);
+    if (! snap) {
+        return 0;
+    }
+
+    getnowtimeofday(&start);
+
+    for (i = 0; i <= snap->maxloggerid && i <= CLOG_LOGGERID_MAX; i++) {
+        if (snap->idloggers[i]) {
+            int waitms = timeout_ms;
+
+            if (timeout_ms > 0) {
+                /* time left of timeout_ms */
+                getnowtimeofday(&now);
+                waitms = timeout_ms - (int)((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000);
+                if (waitms < 0) {
+                    waitms = 0;
+                }
+            }
+
+            if (clog_logger_flush(snap->idloggers[i], waitms) != 0) {
+                ret = (-1);
+            }
+        }
+    }
+
+    return ret;
+}
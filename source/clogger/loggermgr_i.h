@@ -74,6 +74,7 @@ extern "C" {
 #endif
 
 #include "loggerconf.h"
+#include "loggerctl.h"
 
 
 /**
@@ -124,16 +125,55 @@ struct logger_manager_t
 
     rtclock_handle rtclock;
 
-    /* logger by id */
-    clog_logger idloggers[CLOG_LOGGERID_MAX + 1];
+    /* struct clogger_snapshot_t: read without lock */
+    uatomic_ptr snapshot;
 
     cstrbuf workdir;
 
     cstrbuf cfgfile;
+
+    /* cfgfile parsed once by init */
+    CONF_index cfgindex;
+
+    /* control page shared with cloggerctl, NULL if not available */
+    loggerctl_hdl ctl;
+
+    /* CLOG_RELOAD_* flags of running reloadthread, 0 if not started */
+    uatomic_int reloadflags;
+    pthread_t reloadthread;
+
     struct clogger_ident_t *loggers;
 };
 
 
+/* slot of open-addressed ident table */
+struct clogger_slot_t
+{
+    ub4 hash;
+    int idlen;
+    const char *ident;
+    clog_logger logger;
+};
+
+
+/**
+ * immutable tables of loggers published when a logger is added. retired
+ *  snapshots are kept until uninit since loggers are never removed.
+ */
+struct clogger_snapshot_t
+{
+    struct clogger_snapshot_t *retired;
+
+    int maxloggerid;
+    ub4 slotmask;
+
+    /* logger by id */
+    clog_logger idloggers[CLOG_LOGGERID_MAX + 1];
+
+    struct clogger_slot_t slots[0];
+};
+
+
 struct clogger_ident_t
 {
     clog_logger logger;
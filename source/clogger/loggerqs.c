@@ -0,0 +1,173 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerqs.c
+**  quiescent state of threads reading shared blocks.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 20:12:36
+** @date      2026-10-18 20:12:36
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/uatomic.h>
+
+#include <pthread.h>
+
+#include "loggerqs.h"
+
+
+typedef struct _logger_qs_rec_t
+{
+    /* epoch seen by outermost enter, 0 when out */
+    uatomic_int64 epoch;
+
+    /* nested enters by owner thread */
+    int depth;
+
+    /* 1 while owned by a live thread */
+    uatomic_int owned;
+
+    /* records are never freed: reused by new threads */
+    struct _logger_qs_rec_t *next;
+
+    char Pad[UATOMIC_CACHELINE_SIZE - sizeof(uatomic_int64) - sizeof(int) - sizeof(uatomic_int) - sizeof(void *)];
+} logger_qs_rec;
+
+
+/* starts at 1 since 0 means out */
+static uatomic_int64 qsepoch = 1;
+
+static uatomic_ptr qsrecords = NULL;
+
+static pthread_once_t qsonce = PTHREAD_ONCE_INIT;
+static pthread_key_t qskey;
+
+/* record of calling thread, set when it enters the first time */
+static THREAD_LOCAL logger_qs_rec *threadqsrec = NULL;
+
+
+/* thread exits: record is given back for next new thread */
+static void logger_qs_release (void *arg)
+{
+    logger_qs_rec *rec = (logger_qs_rec *) arg;
+
+    threadqsrec = NULL;
+
+    rec->depth = 0;
+    uatomic_int64_store_rel(&rec->epoch, 0);
+    uatomic_int_store_rel(&rec->owned, 0);
+}
+
+
+static void logger_qs_init_once (void)
+{
+    pthread_key_create(&qskey, logger_qs_release);
+}
+
+
+static logger_qs_rec * logger_qs_acquire (void)
+{
+    logger_qs_rec *rec;
+
+    pthread_once(&qsonce, logger_qs_init_once);
+
+    for (rec = (logger_qs_rec *) uatomic_ptr_load_acq(&qsrecords); rec; rec = rec->next) {
+        if (! uatomic_int_load_acq(&rec->owned) && uatomic_int_comp_exch(&rec->owned, 0, 1) == 0) {
+            break;
+        }
+    }
+
+    if (! rec) {
+        void *head;
+
+        rec = (logger_qs_rec *) mem_alloc_align_zero(sizeof(*rec), UATOMIC_CACHELINE_SIZE);
+        rec->owned = 1;
+
+        do {
+            head = (void *) uatomic_ptr_load_acq(&qsrecords);
+            rec->next = (logger_qs_rec *) head;
+        } while (uatomic_ptr_comp_exch(&qsrecords, head, rec) != head);
+    }
+
+    pthread_setspecific(qskey, rec);
+    threadqsrec = rec;
+    return rec;
+}
+
+
+void logger_qs_enter (void)
+{
+    logger_qs_rec *rec = threadqsrec;
+
+    if (! rec) {
+        rec = logger_qs_acquire();
+    }
+
+    if (rec->depth++ == 0) {
+        uatomic_int64_store_rel(&rec->epoch, uatomic_int64_load_acq(&qsepoch));
+
+        /* epoch must be seen by logger_qs_passed before blocks are read */
+        uatomic_fence_full();
+    }
+}
+
+
+void logger_qs_leave (void)
+{
+    logger_qs_rec *rec = threadqsrec;
+
+    if (--rec->depth == 0) {
+        uatomic_int64_store_rel(&rec->epoch, 0);
+    }
+}
+
+
+int64_t logger_qs_advance (void)
+{
+    int64_t epoch = uatomic_int64_add(&qsepoch);
+
+    uatomic_fence_full();
+    return epoch;
+}
+
+
+int logger_qs_passed (int64_t epoch)
+{
+    logger_qs_rec *rec;
+
+    uatomic_fence_full();
+
+    for (rec = (logger_qs_rec *) uatomic_ptr_load_acq(&qsrecords); rec; rec = rec->next) {
+        int64_t seen = uatomic_int64_load_acq(&rec->epoch);
+
+        if (seen && seen < epoch) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,87 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerqs.h
+**  private api for quiescent state of threads reading shared blocks.
+**
+**  Each thread reading blocks which may be replaced (settings of loggers)
+**  owns one record on a cacheline of its own, where it stores the epoch it
+**  entered by. Replacer moves the global epoch and frees old blocks when
+**  no record holds an epoch older than that. Readers write nothing shared.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 20:12:36
+** @date      2026-10-18 20:12:36
+*/
+#ifndef _LOGGERQS_PRIVATE_H_
+#define _LOGGERQS_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/basetype.h>
+
+
+/**
+ * logger_qs_enter
+ *   calling thread begins reading blocks got after this call. may be
+ *   nested, only the outermost one counts.
+ */
+extern void logger_qs_enter (void);
+
+
+/**
+ * logger_qs_leave
+ *   calling thread holds no more blocks got since matching enter.
+ */
+extern void logger_qs_leave (void);
+
+
+/**
+ * logger_qs_advance
+ *   called after a block was unlinked from readers.
+ * returns:
+ *   epoch to be passed to logger_qs_passed() for that block.
+ */
+extern int64_t logger_qs_advance (void);
+
+
+/**
+ * logger_qs_passed
+ *   check whether every thread entered before epoch has left. never blocks.
+ * returns:
+ *   1 if blocks unlinked before logger_qs_advance() returned epoch may be
+ *   freed; 0 if not yet.
+ */
+extern int logger_qs_passed (int64_t epoch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERQS_PRIVATE_H_ */
@@ -0,0 +1,408 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerrate.c
+**  rate limiting and sampling of call sites.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 15:02:36
+** @date      2026-10-18 15:02:36
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/cstrbuf.h>
+#include <common/randctx.h>
+
+#include <pthread.h>
+
+#include "loggerrate.h"
+
+
+typedef struct
+{
+    char file[LOGGERRATE_FILE_MAX + 1];
+    int lineno;
+
+    /* 0 if policy was removed */
+    int active;
+
+    logger_rate_policy policy;
+} logger_rate_sitepolicy;
+
+
+typedef struct
+{
+    /* 0: unused, 1: being claimed, 2: used */
+    uatomic_int state;
+
+    /* key: __FILE__ of caller and line */
+    const char *filename;
+    int lineno;
+
+    /* own policy of site resolved at policygen of rates, in one word as
+     *  (gen + 1) << 32 | (index in policies + 1). 0 if not resolved */
+    uatomic_int64 policyref;
+
+    uatomic_int64 hits;
+
+    /* theoretical arrival time (ns) of next line in token bucket */
+    uatomic_int64 tat;
+
+    uatomic_int64 suppressed;
+} logger_rate_site;
+
+
+typedef struct _logger_rate_t
+{
+    /* serializes writers of policies */
+    pthread_mutex_t lock;
+
+    /* changed when any policy of site is set */
+    uatomic_int policygen;
+
+    uatomic_int numpolicies;
+    uatomic_int activepolicies;
+
+    logger_rate_sitepolicy policies[LOGGERRATE_POLICIES];
+
+    logger_rate_site sites[LOGGERRATE_SITES];
+} logger_rate_t;
+
+
+/* random context of thread for sampling by probability */
+static THREAD_LOCAL randctx *threadrandctx = NULL;
+
+static pthread_once_t randonce = PTHREAD_ONCE_INIT;
+static pthread_key_t randkey;
+
+
+/* seeded per thread: not handed on to next thread */
+static void logger_rate_free_randctx (void *arg)
+{
+    threadrandctx = NULL;
+    mem_free(arg);
+}
+
+
+static void logger_rate_init_once (void)
+{
+    pthread_key_create(&randkey, logger_rate_free_randctx);
+}
+
+
+static ub4 logger_rate_random (void)
+{
+    randctx *rctx = threadrandctx;
+
+    if (! rctx) {
+        struct timespec now;
+        getnowtimeofday(&now);
+
+        rctx = (randctx *) mem_alloc_unset(sizeof(randctx));
+        randctx_init(rctx, (ub4) now.tv_nsec ^ (ub4) (uintptr_t) &now);
+
+        pthread_once(&randonce, logger_rate_init_once);
+        pthread_setspecific(randkey, rctx);
+
+        threadrandctx = rctx;
+    }
+
+    return rand_gen(rctx);
+}
+
+
+static const char * logger_rate_basename (const char *filename, int *filelen)
+{
+    const char *base;
+
+    *filelen = cstr_length(filename, 256);
+    base = clog_logger_file_basename(filename, filelen);
+
+    if (*filelen > LOGGERRATE_FILE_MAX) {
+        *filelen = LOGGERRATE_FILE_MAX;
+    }
+    return base;
+}
+
+
+/* find or claim slot of site. NULL if table is full */
+static logger_rate_site * logger_rate_site_get (logger_rate_t *rates, const char *filename, int lineno)
+{
+    int probes;
+    ub4 i = (ub4) ((((uintptr_t) filename) >> 3) * 2654435761U) ^ ((ub4) lineno * 16777619U);
+
+    for (probes = 0; probes < 8; probes++) {
+        logger_rate_site *site;
+
+        i &= (LOGGERRATE_SITES - 1);
+        site = &rates->sites[i];
+
+        switch (uatomic_int_load_acq(&site->state)) {
+        case 2:
+            if (site->filename == filename && site->lineno == lineno) {
+                return site;
+            }
+            i++;
+            break;
+
+        case 0:
+            if (uatomic_int_comp_exch(&site->state, 0, 1) == 0) {
+                site->filename = filename;
+                site->lineno = lineno;
+                site->policyref = 0;
+                uatomic_int_store_rel(&site->state, 2);
+                return site;
+            }
+            /* claimed by other: look again */
+            break;
+
+        default:
+            /* being claimed: look again */
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+
+static const logger_rate_policy * logger_rate_site_policy (logger_rate_t *rates, logger_rate_site *site, const logger_rate_policy *global)
+{
+    ub8 genkey = (ub8) ((ub4) uatomic_int_load_acq(&rates->policygen) + 1) << 32;
+    ub8 ref = (ub8) uatomic_int64_load_acq(&site->policyref);
+    int index;
+
+    if ((ref & 0xffffffff00000000ULL) != genkey) {
+        int i, filelen, numpolicies = uatomic_int_load_acq(&rates->numpolicies);
+        const char *file = logger_rate_basename(site->filename, &filelen);
+
+        ref = genkey;
+
+        for (i = 0; i < numpolicies; i++) {
+            const logger_rate_sitepolicy *sp = &rates->policies[i];
+
+            if (sp->lineno == site->lineno && ! strncmp(sp->file, file, filelen) && sp->file[filelen] == '\0') {
+                ref |= (ub4) (i + 1);
+                break;
+            }
+        }
+
+        /* racing callers resolve same index for same gen */
+        uatomic_int64_store_rel(&site->policyref, (int64_t) ref);
+    }
+
+    index = (int) (ref & 0xffffffff) - 1;
+
+    if (index != -1 && rates->policies[index].active) {
+        return &rates->policies[index].policy;
+    }
+
+    return global;
+}
+
+
+int logger_rate_parse_sampling (const char *str, logger_rate_policy *policy)
+{
+    char *endp = NULL;
+    double prob;
+
+    policy->sampleevery = 0;
+    policy->samplethreshold = 0;
+
+    while (*str == ' ' || *str == '\t') {
+        str++;
+    }
+
+    if (! strncmp(str, "1/", 2)) {
+        long every = strtol(str + 2, &endp, 10);
+        if (endp == str + 2 || every < 1) {
+            return 0;
+        }
+
+        policy->sampleevery = (ub4) every;
+        return 1;
+    }
+
+    prob = strtod(str, &endp);
+    if (endp == str || prob < 0) {
+        return 0;
+    }
+
+    if (*endp == '%') {
+        prob /= 100;
+    }
+
+    if (prob > 0 && prob < 1) {
+        policy->samplethreshold = (ub4) (prob * 4294967296.0);
+        if (! policy->samplethreshold) {
+            policy->samplethreshold = 1;
+        }
+    }
+    return 1;
+}
+
+
+logger_rate_hdl logger_rate_create (void)
+{
+    logger_rate_t *rates = (logger_rate_t *) mem_alloc_zero(1, sizeof(*rates));
+
+    if (pthread_mutex_init(&rates->lock, NULL) != 0) {
+        mem_free(rates);
+        return NULL;
+    }
+
+    return rates;
+}
+
+
+void logger_rate_free (logger_rate_hdl rates)
+{
+    if (rates) {
+        pthread_mutex_destroy(&rates->lock);
+        mem_free(rates);
+    }
+}
+
+
+int logger_rate_set_site (logger_rate_hdl rates, const char *filename, int lineno, const logger_rate_policy *policy)
+{
+    int i, filelen, ret = 1;
+    const char *file = logger_rate_basename(filename, &filelen);
+
+    pthread_mutex_lock(&rates->lock);
+
+    for (i = 0; i < rates->numpolicies; i++) {
+        if (rates->policies[i].lineno == lineno && ! strncmp(rates->policies[i].file, file, filelen) && rates->policies[i].file[filelen] == '\0') {
+            break;
+        }
+    }
+
+    if (i == rates->numpolicies) {
+        if (! policy) {
+            /* nothing to remove */
+            ret = 0;
+        } else if (i == LOGGERRATE_POLICIES) {
+            /* table is full */
+            ret = -1;
+        } else {
+            logger_rate_sitepolicy *sp = &rates->policies[i];
+
+            memcpy(sp->file, file, filelen);
+            sp->file[filelen] = '\0';
+            sp->lineno = lineno;
+
+            /* entry is listed after it is filled */
+            uatomic_int_store_rel(&rates->numpolicies, i + 1);
+        }
+    }
+
+    if (ret == 1) {
+        logger_rate_sitepolicy *sp = &rates->policies[i];
+
+        if (policy) {
+            sp->policy = *policy;
+            if (! sp->active) {
+                sp->active = 1;
+                uatomic_int_add(&rates->activepolicies);
+            }
+        } else if (sp->active) {
+            sp->active = 0;
+            uatomic_int_sub(&rates->activepolicies);
+        }
+
+        /* sites resolve their policies again */
+        uatomic_int_add(&rates->policygen);
+    }
+
+    pthread_mutex_unlock(&rates->lock);
+    return ret;
+}
+
+
+int logger_rate_site_policies (logger_rate_hdl rates)
+{
+    return (rates? rates->activepolicies : 0);
+}
+
+
+int logger_rate_pass (logger_rate_hdl rates, const logger_rate_policy *policy, const char *filename, int lineno, const struct timespec *now, int64_t *suppressed)
+{
+    logger_rate_site *site = logger_rate_site_get(rates, filename, lineno);
+
+    *suppressed = 0;
+
+    if (! site) {
+        /* no room to track site: never limited */
+        return 1;
+    }
+
+    policy = logger_rate_site_policy(rates, site, policy);
+
+    if (policy->sampleevery > 1) {
+        if ((uatomic_int64_add(&site->hits) - 1) % policy->sampleevery) {
+            goto suppress_line;
+        }
+    }
+
+    if (policy->samplethreshold) {
+        if (logger_rate_random() >= policy->samplethreshold) {
+            goto suppress_line;
+        }
+    }
+
+    if (policy->ratelimit > 0) {
+        int64_t nowns = (int64_t) now->tv_sec * 1000000000 + now->tv_nsec;
+        int64_t interval = 1000000000 / policy->ratelimit;
+        int64_t burst = (int64_t) (policy->rateburst > 0? policy->rateburst : policy->ratelimit) * interval;
+
+        int64_t tat = uatomic_int64_load_acq(&site->tat);
+
+        for (;;) {
+            int64_t newtat = (tat > nowns? tat : nowns) + interval;
+            int64_t oldtat;
+
+            if (newtat - nowns > burst) {
+                goto suppress_line;
+            }
+
+            /* tat taken by other caller: check again from it */
+            oldtat = uatomic_int64_comp_exch(&site->tat, tat, newtat);
+            if (oldtat == tat) {
+                break;
+            }
+            tat = oldtat;
+        }
+    }
+
+    if (site->suppressed) {
+        *suppressed = uatomic_int64_set(&site->suppressed, 0);
+    }
+    return 1;
+
+suppress_line:
+    uatomic_int64_add(&site->suppressed);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggerrate.h
+**  private api for rate limiting and sampling of call sites.
+**
+**  Callers decide before message is formatted with state of call site read
+**  and updated by relaxed atomics and a random context of thread. A site
+**  passes if it is sampled (1 of N, or with probability) and a token is left
+**  in its bucket. Lines suppressed are counted and reported by next line
+**  logged from same site.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 15:02:36
+** @date      2026-10-18 15:02:36
+*/
+#ifndef _LOGGERRATE_PRIVATE_H_
+#define _LOGGERRATE_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/uatomic.h>
+
+#include "clogger_api.h"
+
+
+#define LOGGERRATE_SITES             1024
+#define LOGGERRATE_POLICIES          64
+#define LOGGERRATE_FILE_MAX          55
+
+
+typedef struct
+{
+    /* lines per second of a site, 0 for no limit */
+    int ratelimit;
+
+    /* lines passed at once when bucket is full (default: ratelimit) */
+    int rateburst;
+
+    /* keep 1 of every N lines, 0 for all */
+    ub4 sampleevery;
+
+    /* keep line with probability of samplethreshold / 2^32, 0 for all */
+    ub4 samplethreshold;
+} logger_rate_policy;
+
+
+typedef struct _logger_rate_t * logger_rate_hdl;
+
+
+/* is any limit set by policy */
+#define logger_rate_policy_isset(policy)  \
+    ((policy)->ratelimit || (policy)->sampleevery > 1 || (policy)->samplethreshold)
+
+
+/* parse sampling as "1/N" or probability "0.05". returns 0 if bad */
+extern int logger_rate_parse_sampling (const char *str, logger_rate_policy *policy);
+
+extern logger_rate_hdl logger_rate_create (void);
+
+extern void logger_rate_free (logger_rate_hdl rates);
+
+/* set policy of one site (source file basename and line), NULL to remove */
+extern int logger_rate_set_site (logger_rate_hdl rates, const char *filename, int lineno, const logger_rate_policy *policy);
+
+/* count of sites having own policy */
+extern int logger_rate_site_policies (logger_rate_hdl rates);
+
+/**
+ * returns 1 if line of site passes and sets suppressed to lines not logged
+ *  from site since last one. returns 0 if line is suppressed.
+ */
+extern int logger_rate_pass (logger_rate_hdl rates, const logger_rate_policy *policy, const char *filename, int lineno, const struct timespec *now, int64_t *suppressed);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERRATE_PRIVATE_H_ */
@@ -0,0 +1,242 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggersink.c
+**  queue and worker of one appender.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 23:05:47
+** @date      2026-10-18 23:05:47
+*/
+#include <common/basetype.h>
+#include <common/memapi.h>
+#include <common/ringbufst.h>
+#include <common/unsema.h>
+#include <common/uatomic.h>
+#include <common/timeut.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include "loggersink.h"
+
+
+typedef struct
+{
+    ub4 level;
+    ub4 len;
+    char line[0];
+} logger_sink_line;
+
+
+typedef struct _logger_sink_t
+{
+    ring_buffer_st *queue;
+
+    /* lines pushed by logthread and written by worker */
+    uatomic_int64 pushed;
+    int64_t written;
+
+    /* worker exits after queue is empty */
+    uatomic_int stop;
+
+    logger_sink_write_cb writecb;
+    logger_sink_idle_cb idlecb;
+    void *arg;
+
+    unsema_t sema;
+    pthread_t worker;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} logger_sink_t;
+
+
+typedef struct
+{
+    clog_level_t level;
+    size_t len;
+    const char *line;
+} logger_sink_push_arg;
+
+
+static void sink_write_line_cb (char *chunkbuf, size_t chunkbufsz, void *arg)
+{
+    const logger_sink_push_arg *src = (const logger_sink_push_arg *) arg;
+    logger_sink_line *dst = (logger_sink_line *) chunkbuf;
+
+    dst->level = (ub4) src->level;
+    dst->len = (ub4) src->len;
+    memcpy(dst->line, src->line, src->len);
+}
+
+
+static int sink_read_line_cb (const ringbuf_entry_st *entry, void *arg)
+{
+    logger_sink_t *sink = (logger_sink_t *) arg;
+    const logger_sink_line *ln = (const logger_sink_line *) entry->chunk;
+
+    sink->writecb(sink->arg, (clog_level_t) ln->level, ln->line, ln->len);
+    return 1;
+}
+
+
+static void * sink_worker_func (void *arg)
+{
+    logger_sink_t *sink = (logger_sink_t *) arg;
+
+    for (;;) {
+        int stop;
+        int64_t pushed;
+
+        unsema_timedwait(&sink->sema, 1000);
+
+        /* read after wait: post of logger_sink_free is taken by it. lines
+         *  pushed before stop are drained below */
+        stop = uatomic_int_get(&sink->stop);
+
+        /* lines counted by pushed are in queue now */
+        pushed = uatomic_int64_get(&sink->pushed);
+
+        while (ringbufst_read_next(sink->queue, sink_read_line_cb, sink) > 0);
+
+        if (sink->idlecb) {
+            sink->idlecb(sink->arg);
+        }
+
+        if (pushed != sink->written) {
+            pthread_mutex_lock(&sink->lock);
+            sink->written = pushed;
+            pthread_cond_broadcast(&sink->cond);
+            pthread_mutex_unlock(&sink->lock);
+        }
+
+        if (stop) {
+            break;
+        }
+    }
+
+    return (void*) 0;
+}
+
+
+logger_sink logger_sink_create (int length, int eltsizemax, logger_sink_write_cb writecb, logger_sink_idle_cb idlecb, void *arg)
+{
+    logger_sink_t *sink = (logger_sink_t *) mem_alloc_zero(1, sizeof(*sink));
+
+    sink->queue = ringbufst_init(length, eltsizemax);
+    sink->writecb = writecb;
+    sink->idlecb = idlecb;
+    sink->arg = arg;
+
+    if (unsema_init(&sink->sema, 0) != 0 ||
+        pthread_mutex_init(&sink->lock, NULL) != 0 ||
+        pthread_cond_init(&sink->cond, NULL) != 0) {
+        printf("(%s:%d) logger_sink_create failed\n", __FILE__, __LINE__);
+        ringbufst_uninit(sink->queue);
+        mem_free(sink);
+        return NULL;
+    }
+
+    if (pthread_create(&sink->worker, NULL, sink_worker_func, (void*) sink) != 0) {
+        printf("(%s:%d) pthread_create failed\n", __FILE__, __LINE__);
+        pthread_cond_destroy(&sink->cond);
+        pthread_mutex_destroy(&sink->lock);
+        unsema_uninit(&sink->sema);
+        ringbufst_uninit(sink->queue);
+        mem_free(sink);
+        return NULL;
+    }
+
+    return sink;
+}
+
+
+void logger_sink_free (logger_sink sink)
+{
+    uatomic_int_set(&sink->stop, 1);
+    unsema_post(&sink->sema);
+
+    pthread_join(sink->worker, NULL);
+
+    pthread_cond_destroy(&sink->cond);
+    pthread_mutex_destroy(&sink->lock);
+    unsema_uninit(&sink->sema);
+    ringbufst_uninit(sink->queue);
+    mem_free(sink);
+}
+
+
+int logger_sink_push (logger_sink sink, clog_level_t level, const char *line, size_t len)
+{
+    logger_sink_push_arg pa;
+
+    pa.level = level;
+    pa.len = len;
+    pa.line = line;
+
+    if (ringbufst_write(sink->queue, sizeof(logger_sink_line) + len, sink_write_line_cb, (void*) &pa) != 1) {
+        return 0;
+    }
+
+    uatomic_int64_add(&sink->pushed);
+    unsema_post(&sink->sema);
+    return 1;
+}
+
+
+int logger_sink_sync (logger_sink sink, int timeout_ms)
+{
+    int ret = 0;
+    struct timespec abstime;
+
+    int64_t pushed = uatomic_int64_get(&sink->pushed);
+
+    if (timeout_ms >= 0) {
+        getnowtimeofday(&abstime);
+        abstime.tv_sec += timeout_ms / 1000;
+        abstime.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (abstime.tv_nsec >= 1000000000L) {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+        }
+    }
+
+    unsema_post(&sink->sema);
+
+    pthread_mutex_lock(&sink->lock);
+    while (sink->written < pushed) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        } else if (pthread_cond_timedwait(&sink->cond, &sink->lock, &abstime) == ETIMEDOUT) {
+            ret = (sink->written < pushed)? (-1) : 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sink->lock);
+
+    return ret;
+}
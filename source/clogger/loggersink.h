@@ -0,0 +1,96 @@
+/***********************************************************************
+* Copyright (c) 2008-2080 pepstack.com, 350137278@qq.com
+*
+* ALL RIGHTS RESERVED.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+*   Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+/*
+** @file      loggersink.h
+**  private api for queue and worker of one appender.
+**
+**  Lines rendered by logthread are copied into queue of appender (STDOUT,
+**  SYSLOG) and written out by its own worker, so a sink which blocks (pipe
+**  to a slow reader, stalled syslogd) can not stall logthread and the other
+**  appenders. Lines are dropped when the queue is full.
+**
+** @author     Liang Zhang <350137278@qq.com>
+** @version 1.0.0
+** @since      2026-10-18 23:05:47
+** @date      2026-10-18 23:05:47
+*/
+#ifndef _LOGGERSINK_PRIVATE_H_
+#define _LOGGERSINK_PRIVATE_H_
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include <common/basetype.h>
+
+#include "clogger_api.h"
+
+
+typedef struct _logger_sink_t * logger_sink;
+
+
+/* called by worker for every line. idle is called when queue gets empty */
+typedef void (*logger_sink_write_cb) (void *arg, clog_level_t level, const char *line, size_t len);
+typedef void (*logger_sink_idle_cb) (void *arg);
+
+
+/**
+ * logger_sink_create
+ *   queue of length lines (eltsizemax bytes on average) and worker started.
+ */
+extern logger_sink logger_sink_create (int length, int eltsizemax, logger_sink_write_cb writecb, logger_sink_idle_cb idlecb, void *arg);
+
+
+/**
+ * logger_sink_free
+ *   lines in queue are written out before worker exits.
+ */
+extern void logger_sink_free (logger_sink sink);
+
+
+/**
+ * logger_sink_push
+ *   copy line into queue without waiting. only one thread can push.
+ * returns:
+ *   1 on success. 0 if queue is full and line is dropped.
+ */
+extern int logger_sink_push (logger_sink sink, clog_level_t level, const char *line, size_t len);
+
+
+/**
+ * logger_sink_sync
+ *   wait until lines pushed before are written out by worker, at most
+ *   timeout_ms (-1 for forever).
+ * returns:
+ *   0 on success. -1 if timeout.
+ */
+extern int logger_sink_sync (logger_sink sink, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOGGERSINK_PRIVATE_H_ */
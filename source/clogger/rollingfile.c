@@ -195,6 +195,9 @@ void rollingfile_init (rollingfile_t *rof, const char *pathprefix, const char *n
 {
     static char pathsep[] = {PATH_SEPARATOR_CHAR, '\0'};
 
+    /* opened by first write */
+    rof->fhlogging = filehandle_invalid;
+
     rof->pathprefix = cstrbufNew(ROF_PATHPREFIX_LEN_MAX, pathprefix, -1);
     rof->nameprefix = cstrbufNew(ROF_NAMEPATTERN_LEN_MAX, nameprefix, -1);
 
@@ -0,0 +1,208 @@
+/*******************************************************************************
+* Copyright © 2024-2025 Light Zhang <mapaware@hotmail.com>, MapAware, Inc.     *
+* ALL RIGHTS RESERVED.                                                         *
+*                                                                              *
+* PERMISSION IS HEREBY GRANTED, FREE OF CHARGE, TO ANY PERSON OR ORGANIZATION  *
+* OBTAINING A COPY OF THE SOFTWARE COVERED BY THIS LICENSE TO USE, REPRODUCE,  *
+* DISPLAY, DISTRIBUTE, EXECUTE, AND TRANSMIT THE SOFTWARE, AND TO PREPARE      *
+* DERIVATIVE WORKS OF THE SOFTWARE, AND TO PERMIT THIRD - PARTIES TO WHOM THE  *
+* SOFTWARE IS FURNISHED TO DO SO, ALL SUBJECT TO THE FOLLOWING :               *
+*                                                                              *
+* THE COPYRIGHT NOTICES IN THE SOFTWARE AND THIS ENTIRE STATEMENT, INCLUDING   *
+* THE ABOVE LICENSE GRANT, THIS RESTRICTION AND THE FOLLOWING DISCLAIMER, MUST *
+* BE INCLUDED IN ALL COPIES OF THE SOFTWARE, IN WHOLE OR IN PART, AND ALL      *
+* DERIVATIVE WORKS OF THE SOFTWARE, UNLESS SUCH COPIES OR DERIVATIVE WORKS ARE *
+* SOLELY IN THE FORM OF MACHINE - EXECUTABLE OBJECT CODE GENERATED BY A SOURCE *
+* LANGUAGE PROCESSOR.                                                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON - INFRINGEMENT.IN NO EVENT   *
+* SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE    *
+* FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,  *
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER  *
+* DEALINGS IN THE SOFTWARE.                                                    *
+*******************************************************************************/
+/*
+** @file      jsonesc.h
+**    vectorised json string escaping.
+**
+**  Bytes which must be escaped in json string: '"', '\' and control
+**   bytes (0x00-0x1F). Clean runs are skipped 32 (AVX2) or 16 (SSE2)
+**   bytes at a time and only escaped bytes go the scalar way.
+**
+**  AVX2 is used if compiled with -mavx2 (or /arch:AVX2), SSE2 is always
+**   available on x86_64. Other archs use the scalar fallback.
+**
+** @author mapaware@hotmail.com
+** @version 0.0.1
+** @since 2026-10-18 10:05:12
+** @date 2026-10-18 10:05:12
+*/
+#ifndef _JSONESC_H__
+#define _JSONESC_H__
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "basetype.h"
+#include "ffs32.h"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define JSONESC_USE_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define JSONESC_USE_SSE2
+#endif
+
+
+static const char jsonesc_hexdigits[] = "0123456789abcdef";
+
+/* escaped length of each byte: 1 for clean, 2 for short escape, 6 for \u00XX */
+static const ub1 jsonesc_lens[256] = {
+    6,6,6,6,6,6,6,6,2,2,2,6,2,2,6,6,  6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    1,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,2,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+};
+
+
+/**
+ * json_escape_scan
+ *   find the first byte in s[0..n) which must be escaped.
+ * returns:
+ *   offset of the byte or n if none.
+ */
+STATIC_INLINE size_t json_escape_scan (const char *s, size_t n)
+{
+    size_t i = 0;
+
+#if defined(JSONESC_USE_AVX2)
+    const __m256i quot32 = _mm256_set1_epi8('"');
+    const __m256i bksl32 = _mm256_set1_epi8('\\');
+    const __m256i ctrl32 = _mm256_set1_epi8(0x1F);
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (s + i));
+
+        /* x <= 0x1F (unsigned) iff max(x, 0x1F) == 0x1F */
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, quot32), _mm256_cmpeq_epi8(x, bksl32)),
+                _mm256_cmpeq_epi8(_mm256_max_epu8(x, ctrl32), ctrl32));
+
+        FFS32_t mask = (FFS32_t) _mm256_movemask_epi8(m);
+        if (mask) {
+            return i + FFS32_first_setbit(mask) - 1;
+        }
+    }
+#endif
+
+#if defined(JSONESC_USE_SSE2)
+    do {
+        const __m128i quot16 = _mm_set1_epi8('"');
+        const __m128i bksl16 = _mm_set1_epi8('\\');
+        const __m128i ctrl16 = _mm_set1_epi8(0x1F);
+
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *) (s + i));
+
+            __m128i m = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(x, quot16), _mm_cmpeq_epi8(x, bksl16)),
+                    _mm_cmpeq_epi8(_mm_max_epu8(x, ctrl16), ctrl16));
+
+            FFS32_t mask = (FFS32_t) _mm_movemask_epi8(m);
+            if (mask) {
+                return i + FFS32_first_setbit(mask) - 1;
+            }
+        }
+    } while(0);
+#endif
+
+    for (; i < n; i++) {
+        if (jsonesc_lens[(ub1) s[i]] != 1) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+
+/**
+ * json_escape_length
+ *   length of s[0..n) after escaped (without quotes).
+ */
+STATIC_INLINE size_t json_escape_length (const char *s, size_t n)
+{
+    size_t i, len = 0;
+
+    while ((i = json_escape_scan(s, n)) < n) {
+        len += i + jsonesc_lens[(ub1) s[i]];
+        s += i + 1;
+        n -= i + 1;
+    }
+
+    return len + n;
+}
+
+
+/**
+ * json_escape_copy
+ *   write escaped s[0..n) into dst (without quotes). dst must have at least
+ *   json_escape_length(s, n) bytes.
+ * returns:
+ *   bytes written to dst.
+ */
+STATIC_INLINE size_t json_escape_copy (char *dst, const char *s, size_t n)
+{
+    char *p = dst;
+    size_t i;
+
+    while ((i = json_escape_scan(s, n)) < n) {
+        ub1 c = (ub1) s[i];
+
+        memcpy(p, s, i);
+        p += i;
+
+        *p++ = '\\';
+        switch (c) {
+        case '"':  *p++ = '"';  break;
+        case '\\': *p++ = '\\'; break;
+        case '\n': *p++ = 'n';  break;
+        case '\r': *p++ = 'r';  break;
+        case '\t': *p++ = 't';  break;
+        case '\b': *p++ = 'b';  break;
+        case '\f': *p++ = 'f';  break;
+        default:
+            *p++ = 'u';
+            *p++ = '0';
+            *p++ = '0';
+            *p++ = jsonesc_hexdigits[c >> 4];
+            *p++ = jsonesc_hexdigits[c & 0xF];
+            break;
+        }
+
+        s += i + 1;
+        n -= i + 1;
+    }
+
+    memcpy(p, s, n);
+    p += n;
+
+    return (size_t) (p - dst);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSONESC_H__ */
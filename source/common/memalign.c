@@ -32,6 +32,7 @@ bool memalign_is_aligned(const void* pointer, size_t alignment)
 
 #if defined(__APPLE__) || defined(__linux__)
 
+#include <stdio.h>
 #include <stdlib.h>
 
 void* memalign_alloc(size_t size, size_t alignment)
@@ -162,6 +163,7 @@ size_t memalign_alignment(size_t defaultOnFail)
 #else
 
 // https://sites.google.com/site/ruslancray/lab/bookshelf/interview/ci/low-level/write-an-aligned-malloc-free-function
+#include <stdio.h>
 #include <stdlib.h>
 
 size_t memalign_alignment(size_t defaultOnFail)
@@ -95,6 +95,15 @@ extern "C"
 #endif
 
 
+#ifndef THREAD_LOCAL
+    # if defined(_MSC_VER)
+        # define THREAD_LOCAL  __declspec(thread)
+    # else
+        # define THREAD_LOCAL  __thread
+    # endif
+#endif
+
+
 #define memapi_align_bsize(bsz, alignsize)  \
         ((size_t)((((size_t)(bsz)+(alignsize)-1)/(alignsize))*(alignsize)))
 
@@ -128,6 +137,47 @@ STATIC_INLINE void * mem_alloc_zero (size_t nmemb, size_t size)
 }
 
 
+/**
+ * mem_alloc_align_zero() allocates size bytes of zero memory starting at
+ *  a multiple of alignsize (power of 2 and of sizeof(void *)).
+ * IT MUST BE FREED BY mem_free_align().
+ */
+STATIC_INLINE void * mem_alloc_align_zero (size_t size, size_t alignsize)
+{
+    void * p = 0;
+
+#if defined(_WIN32)
+    p = _aligned_malloc(size, alignsize);
+#elif defined(MEMAPI_USE_LIBJEMALLOC)
+    if (je_posix_memalign(&p, alignsize, size)) {
+        p = 0;
+    }
+#else
+    if (posix_memalign(&p, alignsize, size)) {
+        p = 0;
+    }
+#endif
+
+    memapi_oom_check(p);
+    memset(p, 0, size);
+    return p;
+}
+
+
+STATIC_INLINE void mem_free_align (void * ptr)
+{
+    if (ptr) {
+    #if defined(_WIN32)
+        _aligned_free(ptr);
+    #elif defined(MEMAPI_USE_LIBJEMALLOC)
+        je_free(ptr);
+    #else
+        free(ptr);
+    #endif
+    }
+}
+
+
 /**
  * mem_alloc_unset() allocate with THE MEMORY NOT BE INITIALIZED.
  */
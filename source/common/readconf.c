@@ -699,6 +699,332 @@ int ConfReadValueParsedAlloc (const char *confFile, const char *family, const ch
 }
 
 
+typedef struct
+{
+    int secid;
+    char *key;
+
+    /* NULL for key without '=' */
+    char *val;
+} conf_index_pair_t;
+
+
+typedef struct _conf_index_t
+{
+    int numpairs;
+    conf_index_pair_t *pairs;
+
+    /* unique names of sections and their pairs in order of file */
+    int numsecs;
+    char **secnames;
+    int *secfirst;
+    int *seccount;
+    int *secpairs;
+
+    /* section of pairs when it changes as ConfGetSectionList() */
+    int numlist;
+    int *seclist;
+} conf_index_t;
+
+
+static int conf_index_secid (conf_index_t *cidx, const char *secname, int add)
+{
+    int i;
+
+    for (i = 0; i < cidx->numsecs; i++) {
+        if (! strcmp(cidx->secnames[i], secname)) {
+            return i;
+        }
+    }
+
+    if (! add) {
+        return -1;
+    }
+
+    if (! (cidx->numsecs & 15)) {
+        cidx->secnames = (char **) ConfMemRealloc(cidx->secnames, sizeof(char *) * cidx->numsecs, sizeof(char *) * (cidx->numsecs + 16));
+    }
+    cidx->secnames[cidx->numsecs] = ConfMemCopyString(secname, -1);
+
+    return cidx->numsecs++;
+}
+
+
+static void conf_index_add (conf_index_t *cidx, int secid, const char *key, const char *val, int vallen)
+{
+    conf_index_pair_t *pair;
+
+    if (! (cidx->numpairs & 63)) {
+        cidx->pairs = (conf_index_pair_t *) ConfMemRealloc(cidx->pairs, sizeof(*pair) * cidx->numpairs, sizeof(*pair) * (cidx->numpairs + 64));
+    }
+
+    pair = &cidx->pairs[cidx->numpairs++];
+    pair->secid = secid;
+    pair->key = ConfMemCopyString(key, -1);
+    pair->val = (val? ConfMemCopyString(val, vallen) : 0);
+}
+
+
+CONF_index ConfIndexLoad (const char *confFile)
+{
+    int i, nch, pending = 0;
+    char *start, *key, *val;
+
+    int valsize = 0;
+    char *valbuf = 0;
+
+    int prevsec = -1;
+    int secid;
+
+    conf_index_t *cidx;
+
+    CONF_position cpos = ConfOpenFile(confFile);
+    if (! cpos) {
+        return 0;
+    }
+
+    cidx = (conf_index_t *) ConfMemAlloc(1, sizeof(*cidx));
+
+    /* pairs without section have name "" like ConfGetNextPair() */
+    secid = conf_index_secid(cidx, "", 1);
+
+    for (;;) {
+        if (! pending) {
+            nch = readln(cpos->_fp, cpos->_linebuf, READCONF_LINESIZE_MAX);
+            if (nch < 0) {
+                break;
+            }
+        }
+        pending = 0;
+
+        start = dtrim(dtrim(cpos->_linebuf, 32), 9);
+        if (*start == READCONF_NOTE_CHAR) {
+            continue;
+        }
+
+        nch = (int) strlen(start);
+        if (nch <= 2) {
+            continue;
+        }
+
+        if (nch <= READCONF_SECNAME_MAX && *start == READCONF_SEC_BEGIN && *(start+nch-1) == READCONF_SEC_END) {
+            start[nch - 1] = 0;
+            secid = conf_index_secid(cidx, start + 1, 1);
+            continue;
+        }
+
+        if (splitpair(start, READCONF_SEPARATOR, &key, &val) != READCONF_TRUE) {
+            continue;
+        }
+
+        if (secid != prevsec && (prevsec != -1 || cidx->secnames[secid][0])) {
+            if (! (cidx->numlist & 15)) {
+                cidx->seclist = (int *) ConfMemRealloc(cidx->seclist, sizeof(int) * cidx->numlist, sizeof(int) * (cidx->numlist + 16));
+            }
+            cidx->seclist[cidx->numlist++] = secid;
+        }
+        prevsec = secid;
+
+        if (! val) {
+            conf_index_add(cidx, secid, key, 0, 0);
+            continue;
+        }
+
+        /* key is in linebuf which is overwritten by '+' lines */
+        nch = (int) strlen(val);
+        if (valsize < nch + READCONF_KEYLEN_MAX + 4) {
+            valbuf = (char *) ConfMemRealloc(valbuf, valsize, nch + READCONF_KEYLEN_MAX + 4);
+            valsize = nch + READCONF_KEYLEN_MAX + 4;
+        }
+        i = (int) strnlen(key, READCONF_KEYLEN_MAX);
+        memcpy(valbuf, key, i);
+        valbuf[i++] = 0;
+        memcpy(valbuf + i, val, nch + 1);
+        key = valbuf;
+        val = valbuf + i;
+
+        /* "a, \" + "+ b, \" + "+ c" => "a, b, c" */
+        while (nch > 0 && val[nch - 1] == '\\') {
+            int n;
+
+            if (readln(cpos->_fp, cpos->_linebuf, READCONF_LINESIZE_MAX) < 0) {
+                val[--nch] = 0;
+                break;
+            }
+
+            start = dtrim(dtrim(cpos->_linebuf, 32), 9);
+            if (*start == READCONF_NOTE_CHAR) {
+                continue;
+            }
+
+            if (*start != '+') {
+                /* end of val and line is parsed as next pair */
+                val[--nch] = 0;
+                pending = 1;
+                break;
+            }
+
+            start = dtrim(dtrim(start + 1, 32), 9);
+            n = (int) strlen(start);
+
+            if (valsize < (int)(val - valbuf) + nch + n + 1) {
+                int off = (int)(val - valbuf);
+                valbuf = (char *) ConfMemRealloc(valbuf, valsize, off + nch + n + 1 + READCONF_LINESIZE_MAX);
+                valsize = off + nch + n + 1 + READCONF_LINESIZE_MAX;
+                key = valbuf;
+                val = valbuf + off;
+            }
+
+            memcpy(val + nch - 1, start, n + 1);
+            nch += n - 1;
+        }
+
+        conf_index_add(cidx, secid, key, val, nch);
+    }
+
+    ConfMemFree(valbuf);
+    ConfCloseFile(cpos);
+
+    /* pairs grouped by section in order of file */
+    cidx->secfirst = (int *) ConfMemAlloc(cidx->numsecs + 1, sizeof(int));
+    cidx->seccount = (int *) ConfMemAlloc(cidx->numsecs + 1, sizeof(int));
+    cidx->secpairs = (int *) ConfMemAlloc(cidx->numpairs + 1, sizeof(int));
+
+    for (i = 0; i < cidx->numpairs; i++) {
+        cidx->seccount[cidx->pairs[i].secid]++;
+    }
+    for (i = 1; i < cidx->numsecs; i++) {
+        cidx->secfirst[i] = cidx->secfirst[i - 1] + cidx->seccount[i - 1];
+    }
+    for (i = 0; i < cidx->numsecs; i++) {
+        cidx->seccount[i] = 0;
+    }
+    for (i = 0; i < cidx->numpairs; i++) {
+        secid = cidx->pairs[i].secid;
+        cidx->secpairs[cidx->secfirst[secid] + cidx->seccount[secid]++] = i;
+    }
+
+    return cidx;
+}
+
+
+void ConfIndexFree (CONF_index cidx)
+{
+    if (cidx) {
+        int i;
+        for (i = 0; i < cidx->numpairs; i++) {
+            ConfMemFree(cidx->pairs[i].key);
+            ConfMemFree(cidx->pairs[i].val);
+        }
+        for (i = 0; i < cidx->numsecs; i++) {
+            ConfMemFree(cidx->secnames[i]);
+        }
+        ConfMemFree(cidx->pairs);
+        ConfMemFree(cidx->secnames);
+        ConfMemFree(cidx->secfirst);
+        ConfMemFree(cidx->seccount);
+        ConfMemFree(cidx->secpairs);
+        ConfMemFree(cidx->seclist);
+        ConfMemFree(cidx);
+    }
+}
+
+
+/* same result as ConfReadValue() */
+int ConfIndexReadValue (CONF_index cidx, const char *sectionName, const char *keyName, char *valbuf, size_t maxbufsize)
+{
+    int i, first, count;
+    const conf_index_pair_t *pair = 0;
+
+    if (sectionName) {
+        int secid = conf_index_secid(cidx, sectionName, 0);
+        if (secid == -1) {
+            return 0;
+        }
+        first = cidx->secfirst[secid];
+        count = cidx->seccount[secid];
+    } else {
+        first = 0;
+        count = cidx->numpairs;
+    }
+
+    for (i = first; i < first + count; i++) {
+        const conf_index_pair_t *p = &cidx->pairs[sectionName? cidx->secpairs[i] : i];
+        if (! strcmp(p->key, keyName)) {
+            pair = p;
+            break;
+        }
+    }
+
+    if (! pair) {
+        return 0;
+    }
+
+    if (! pair->val) {
+        if (valbuf) {
+            *valbuf = 0;
+        }
+        return 1;
+    } else {
+        int valsz = (int) strlen(pair->val) + 1;
+
+        if (valbuf && maxbufsize) {
+            size_t cb = ((size_t) valsz <= maxbufsize? (size_t) valsz : maxbufsize);
+            memcpy(valbuf, pair->val, cb);
+            valbuf[cb - 1] = 0;
+        }
+        return valsz;
+    }
+}
+
+
+int ConfIndexReadValueParsed (CONF_index cidx, const char *family, const char *qualifier, const char *key, char *valbuf, size_t maxbufsize)
+{
+    if (! qualifier) {
+        return ConfIndexReadValue(cidx, family, key, valbuf, maxbufsize);
+    } else {
+        char section[READCONF_SECNAME_MAX + 4];
+        snprintf(section, sizeof(section), "%s:%s", family, qualifier);
+        return ConfIndexReadValue(cidx, section, key, valbuf, maxbufsize);
+    }
+}
+
+
+int ConfIndexReadValueParsedAlloc (CONF_index cidx, const char *family, const char *qualifier, const char *key, char **value)
+{
+    int valsz = ConfIndexReadValueParsed(cidx, family, qualifier, key, 0, 0);
+
+    *value = ConfMemAlloc(1, (valsz > 0? valsz : 1));
+
+    return ConfIndexReadValueParsed(cidx, family, qualifier, key, *value, (valsz > 0? valsz : 1));
+}
+
+
+/* same list as ConfGetSectionList() */
+int ConfIndexGetSectionList (CONF_index cidx, void **sectionList)
+{
+    int i;
+    char **secs;
+
+    *sectionList = 0;
+
+    if (! cidx) {
+        return READCONF_RET_ERROR;
+    }
+    if (! cidx->numlist) {
+        return 0;
+    }
+
+    secs = _SectionListAlloc(cidx->numlist);
+    for (i = 0; i < cidx->numlist; i++) {
+        secs[i + 1] = ConfMemCopyString(cidx->secnames[cidx->seclist[i]], -1);
+    }
+
+    *sectionList = (void *) secs;
+    return cidx->numlist;
+}
+
+
 int ConfGetSectionList (const char *confFile, void **sectionList)
 {
     char *key;
@@ -87,6 +87,8 @@ typedef int READCONF_RESULT;
 
 typedef struct _conf_position_t* CONF_position;
 
+typedef struct _conf_index_t* CONF_index;
+
 
 typedef struct {
     int count;
@@ -147,6 +149,19 @@ extern void ConfSectionListFree (void *sectionList);
 
 extern char * ConfSectionListGetAt (void *sectionList, int secIndex);
 
+/* all pairs of file parsed in one pass (with '+' lists) for lookup in memory */
+extern CONF_index ConfIndexLoad (const char *confFile);
+
+extern void ConfIndexFree (CONF_index cidx);
+
+extern int ConfIndexReadValue (CONF_index cidx, const char *sectionName, const char *keyName, char *valbuf, size_t maxbufsize);
+
+extern int ConfIndexReadValueParsed (CONF_index cidx, const char *family, const char *qualifier, const char *key, char *valbuf, size_t maxbufsize);
+
+extern int ConfIndexReadValueParsedAlloc (CONF_index cidx, const char *family, const char *qualifier, const char *key, char **value);
+
+extern int ConfIndexGetSectionList (CONF_index cidx, void **sectionList);
+
 extern READCONF_BOOL ConfSectionGetFamily (const char *sectionName, char *family);
 
 extern READCONF_BOOL ConfSectionGetQualifier (const char *sectionName, char *qualifier);
@@ -128,23 +128,40 @@ static char * ringbuf_elt_new (size_t datasize, ringbuf_elt_free_cb free_cb, rin
 }
 
 
+/**
+ * fields of pushers and of poppers are on their own cache lines, each side
+ *  loads index of other side again (acquire) only when the one it has seen
+ *  last time says full or empty.
+ */
 typedef struct
 {
-    /* MT-safety Read Lock */
-    uatomic_int RLock;
-
     /* MT-safety Write Lock */
     uatomic_int WLock;
 
     /* Write (push) index: 0, L-1 */
     uatomic_int W;
 
+    /* R last seen by pusher */
+    int WCacheR;
+
+    char WPad[UATOMIC_CACHELINE_SIZE - sizeof(uatomic_int)*2 - sizeof(int)];
+
+    /* MT-safety Read Lock */
+    uatomic_int RLock;
+
     /* Read (pop) index: 0, L-1 */
     uatomic_int R;
 
+    /* W last seen by popper */
+    int RCacheW;
+
+    char RPad[UATOMIC_CACHELINE_SIZE - sizeof(uatomic_int)*2 - sizeof(int)];
+
     /* Length of ring buffer */
     int L;
 
+    char LPad[UATOMIC_CACHELINE_SIZE - sizeof(int)];
+
     /* Buffer */
     ringbuf_elt_t *B[0];
 } ringbuf_t;
@@ -166,7 +183,7 @@ static ringbuf_t * ringbuf_init(int length)
     }
 
     /* new and initialize read and write index by 0 */
-    rb = (ringbuf_t *) mem_alloc_zero(1, sizeof(*rb) + sizeof(ringbuf_elt_t*) * length);
+    rb = (ringbuf_t *) mem_alloc_align_zero(sizeof(*rb) + sizeof(ringbuf_elt_t*) * length, UATOMIC_CACHELINE_SIZE);
     rb->L = length;
     return rb;
 }
@@ -190,7 +207,7 @@ static void ringbuf_uninit(ringbuf_t *rb)
             }
         }
     }
-    mem_free(rb);
+    mem_free_align(rb);
 }
 
 
@@ -200,14 +217,22 @@ static int ringbuf_push (ringbuf_t *rb, ringbuf_elt_t *elt)
         /* copy constant of length */
         int L = rb->L;
 
-        /* original values of R, W */
-        int Ro = uatomic_int_get(&rb->R);
-
-        /* MUST get W after R */
+        /* W is only changed by pusher holding WLock */
         int Wo = rb->W;
 
+        /* R seen last time or loaded again if full by it */
+        int Ro = rb->WCacheR;
+
         RINGBUF_RESTORE_STATE(Ro, Wo, L);
 
+        if (L + R - wrap*L - W <= 0) {
+            Ro = uatomic_int_load_acq(&rb->R);
+            rb->WCacheR = Ro;
+
+            wrap = ((int)(Ro/L == Wo/L ? 0 : 1));
+            R = Ro % L;
+        }
+
         /* Sw = L - (f*L+W - R) */
         if (L + R - wrap*L - W > 0) {
             /* writable: Sw > 0 */
@@ -219,7 +244,7 @@ static int ringbuf_push (ringbuf_t *rb, ringbuf_elt_t *elt)
             /* W = [0, 2L) */
             W = RINGBUF_NORMALIZE_OFFSET(Wo, L);
 
-            uatomic_int_set(&rb->W, W);
+            uatomic_int_store_rel(&rb->W, W);
 
             /* push success */
             uatomic_int_zero(&rb->WLock);
@@ -239,14 +264,22 @@ static int ringbuf_pop (ringbuf_t *rb, ringbuf_elt_t **eltp)
     if (! uatomic_int_comp_exch(&rb->RLock, 0, 1)) {
         int L = rb->L;
 
-        /* original values of W, R */
-        int Wo = uatomic_int_get(&rb->W);
-
-        /* MUST get R after W */
+        /* R is only changed by popper holding RLock */
         int Ro = rb->R;
 
+        /* W seen last time or loaded again if empty by it */
+        int Wo = rb->RCacheW;
+
         RINGBUF_RESTORE_STATE(Ro, Wo, L);
 
+        if (wrap*L + W - R <= 0) {
+            Wo = uatomic_int_load_acq(&rb->W);
+            rb->RCacheW = Wo;
+
+            wrap = ((int)(Ro/L == Wo/L ? 0 : 1));
+            W = Wo % L;
+        }
+
         /* Sr = f*L + W - R */
         if (wrap*L + W - R > 0) {
             /* readable: Sr > 0 */
@@ -260,7 +293,7 @@ static int ringbuf_pop (ringbuf_t *rb, ringbuf_elt_t **eltp)
             /* R = [0, 2L) */
             R = RINGBUF_NORMALIZE_OFFSET(Ro, L);
 
-            uatomic_int_set(&rb->R, R);
+            uatomic_int_store_rel(&rb->R, R);
 
             /* pop success */
             uatomic_int_zero(&rb->RLock);
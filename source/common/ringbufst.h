@@ -52,6 +52,7 @@ extern "C"
 # define INT_CAST_TO_LONG(s)  ((LONG)(s))
 #else
 # define INT_CAST_TO_LONG(s)  (s)
+# include <sys/mman.h>
 #endif
 
 
@@ -77,6 +78,12 @@ extern "C"
 
 #define RINGBUFST_ENTRY_CAST(p)  ((ringbuf_entry_st *)(p))
 
+/* flags for ringbufst_init_map() */
+#define RINGBUFST_MAP_PREFAULT     0x01
+#define RINGBUFST_MAP_HUGEPAGE     0x02
+
+#define RINGBUFST_HUGEPAGE_SIZE    ((size_t)2097152)
+
 
 /**
  * The layout of memory for any one entry in ringbufst.
@@ -90,26 +97,42 @@ typedef struct _ringbuf_entry_st
 
 /**
  * static memory layout of ring buffer.
+ *   fields of writers and of reader are on their own cache lines, each side
+ *   keeps the last offset of other side seen and loads it again (acquire)
+ *   only when the cached one says full or empty. memory must be aligned by
+ *   UATOMIC_CACHELINE_SIZE.
  * see also:
  *   ringbuf.h
  */
 typedef struct _ring_buffer_st
 {
-    /* Read Lock */
-    uatomic_int RLock;
-
     /* Write Lock */
     uatomic_int WLock;
 
     /* Write Offset to the Buffer start */
     uatomic_int WOffset;
 
+    /* ROffset last seen by writer */
+    ssize_t WCacheR;
+
+    char WPad[UATOMIC_CACHELINE_SIZE - sizeof(uatomic_int)*2 - sizeof(ssize_t)];
+
+    /* Read Lock */
+    uatomic_int RLock;
+
     /* Read Offset to the Buffer start */
     uatomic_int ROffset;
 
+    /* WOffset last seen by reader */
+    ssize_t RCacheW;
+
+    char RPad[UATOMIC_CACHELINE_SIZE - sizeof(uatomic_int)*2 - sizeof(ssize_t)];
+
     /* Length of ring Buffer: total size in bytes */
     size_t Length;
 
+    char LPad[UATOMIC_CACHELINE_SIZE - sizeof(size_t)];
+
     /* ring buffer static memory with Length */
     char Buffer[0];
 } ring_buffer_st;
@@ -129,6 +152,42 @@ typedef struct _ring_buffer_st
     ((((Ao)/(L))%2)*L + (Ao)%(L))
 
 
+/**
+ * writer: ROffset seen last time if entry of AENTSZ fits by it, or else
+ *  loads ROffset again. R only moves on so the cached one never overstates
+ *  space and its wrap is same as current one.
+ */
+static ssize_t __ringbufst_writer_roffset (ring_buffer_st *rbst, ssize_t Wo, ssize_t L, ssize_t AENTSZ)
+{
+    ssize_t Ro = rbst->WCacheR;
+
+    RINGBUFST_RESTORE_STATE(Ro, Wo, L);
+
+    if (L - (wrap*L + W - R) < AENTSZ || (! wrap && L - W < AENTSZ && R < AENTSZ)) {
+        Ro = uatomic_int_load_acq(&rbst->ROffset);
+        rbst->WCacheR = Ro;
+    }
+
+    return Ro;
+}
+
+
+/* reader: WOffset seen last time if any entry to read by it, or else loads WOffset again */
+static ssize_t __ringbufst_reader_woffset (ring_buffer_st *rbst, ssize_t Ro, ssize_t L)
+{
+    ssize_t Wo = rbst->RCacheW;
+
+    RINGBUFST_RESTORE_STATE(Ro, Wo, L);
+
+    if (wrap*L + W - R <= (ssize_t) RINGBUFST_ALIGN_ENTRYSIZE(0)) {
+        Wo = uatomic_int_load_acq(&rbst->WOffset);
+        rbst->RCacheW = Wo;
+    }
+
+    return Wo;
+}
+
+
 /**
  * public interface
  */
@@ -148,7 +207,7 @@ static ring_buffer_st * ringbufst_init (int length, int eltsizemax)
     /* new and initialize read and write index by 0 */
     cbLength = RINGBUFST_ALIGN_PAGESIZE(eltsizemax * length);
 
-    rbst = (ring_buffer_st *) mem_alloc_zero(1, sizeof(*rbst) + cbLength);
+    rbst = (ring_buffer_st *) mem_alloc_align_zero(sizeof(*rbst) + cbLength, UATOMIC_CACHELINE_SIZE);
 
     rbst->Length = cbLength;
 
@@ -156,11 +215,193 @@ static ring_buffer_st * ringbufst_init (int length, int eltsizemax)
 }
 
 
+/* bytes of memory for ring buffer of ringbufst_init_mem() */
+static size_t ringbufst_memsize (int length, int eltsizemax)
+{
+    if (length < RINGBUFST_LENGTH_MIN) {
+        length = RINGBUFST_LENGTH_MIN;
+    }
+    if (length > RINGBUFST_LENGTH_MAX) {
+        length = RINGBUFST_LENGTH_MAX;
+    }
+
+    return sizeof(ring_buffer_st) + RINGBUFST_ALIGN_PAGESIZE(eltsizemax * length);
+}
+
+
+/**
+ * ring buffer in memory of caller (mmaped file for example) which must not
+ *  be passed to ringbufst_uninit(). entries left in memory by last user are
+ *  kept if Length and offsets are valid, or else it is made empty.
+ */
+static ring_buffer_st * ringbufst_init_mem (void *mem, size_t memsize)
+{
+    ring_buffer_st *rbst = (ring_buffer_st *) mem;
+
+    ssize_t L = (ssize_t) (memsize - sizeof(*rbst));
+
+    if ((ssize_t) rbst->Length != L ||
+        rbst->ROffset < 0 || (ssize_t) rbst->ROffset >= 2*L ||
+        rbst->WOffset < 0 || (ssize_t) rbst->WOffset >= 2*L) {
+        bzero(rbst, sizeof(*rbst));
+        rbst->Length = (size_t) L;
+    }
+
+    rbst->WCacheR = rbst->ROffset;
+    rbst->RCacheW = rbst->WOffset;
+
+    /* locks held by last user are released */
+    uatomic_int_zero(&rbst->RLock);
+    uatomic_int_zero(&rbst->WLock);
+
+    return rbst;
+}
+
+
 static void ringbufst_uninit (ring_buffer_st *rbst)
 {
     uatomic_int_set(&rbst->RLock, 1);
     uatomic_int_set(&rbst->WLock, 1);
-    mem_free(rbst);
+    mem_free_align(rbst);
+}
+
+
+/**
+ * ring buffer in anonymous memory reserved by mmap: pages are touched when
+ *  written first unless RINGBUFST_MAP_PREFAULT. RINGBUFST_MAP_HUGEPAGE tries
+ *  MAP_HUGETLB, then transparent huge pages. must be freed by
+ *  ringbufst_uninit_map(). returns NULL on error.
+ */
+static ring_buffer_st * ringbufst_init_map (int length, int eltsizemax, int flags)
+{
+    ring_buffer_st *rbst = NULL;
+    size_t memsize = RINGBUFST_ALIGN_PAGESIZE(ringbufst_memsize(length, eltsizemax));
+
+#ifdef __WINDOWS__
+    rbst = (ring_buffer_st *) VirtualAlloc(NULL, memsize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (! rbst) {
+        return NULL;
+    }
+#else
+    void *addr = MAP_FAILED;
+    int mapflags = MAP_PRIVATE | MAP_ANONYMOUS | ((flags & RINGBUFST_MAP_PREFAULT)? MAP_POPULATE : 0);
+
+# ifdef MAP_HUGETLB
+    if (flags & RINGBUFST_MAP_HUGEPAGE) {
+        size_t hugesize = memapi_align_bsize(memsize, RINGBUFST_HUGEPAGE_SIZE);
+
+        /* fails if no huge pages reserved (vm.nr_hugepages) */
+        addr = mmap(NULL, hugesize, PROT_READ | PROT_WRITE, mapflags | MAP_HUGETLB, -1, 0);
+        if (addr != MAP_FAILED) {
+            memsize = hugesize;
+        }
+    }
+# endif
+
+    if (addr == MAP_FAILED) {
+        addr = mmap(NULL, memsize, PROT_READ | PROT_WRITE, mapflags, -1, 0);
+        if (addr == MAP_FAILED) {
+            return NULL;
+        }
+# ifdef MADV_HUGEPAGE
+        if (flags & RINGBUFST_MAP_HUGEPAGE) {
+            madvise(addr, memsize, MADV_HUGEPAGE);
+        }
+# endif
+    }
+
+    rbst = (ring_buffer_st *) addr;
+#endif
+
+    /* memory of mapping is zero */
+    rbst->Length = memsize - sizeof(*rbst);
+
+    return rbst;
+}
+
+
+static void ringbufst_uninit_map (ring_buffer_st *rbst)
+{
+    uatomic_int_set(&rbst->RLock, 1);
+    uatomic_int_set(&rbst->WLock, 1);
+
+#ifdef __WINDOWS__
+    VirtualFree(rbst, 0, MEM_RELEASE);
+#else
+    munmap(rbst, sizeof(*rbst) + rbst->Length);
+#endif
+}
+
+
+/**
+ * reader only: give pages of an empty ring buffer back to the system while
+ *  writers are locked out. pages are zero when written again.
+ * returns:
+ *   bytes given back. 0 if ring buffer is not empty or locked by writer.
+ */
+static size_t ringbufst_reclaim (ring_buffer_st *rbst)
+{
+    size_t start, end, ret = 0;
+
+    if (uatomic_int_comp_exch(&rbst->WLock, 0, 1)) {
+        return 0;
+    }
+
+    if (uatomic_int_load_acq(&rbst->ROffset) == rbst->WOffset) {
+        /* whole pages of Buffer: page of header is kept */
+        start = RINGBUFST_ALIGN_PAGESIZE((size_t) rbst->Buffer);
+        end = ((size_t) rbst->Buffer + rbst->Length) & ~(RINGBUFST_PAGE_SIZE - 1);
+
+        if (end > start) {
+#ifdef __WINDOWS__
+            if (VirtualAlloc((void *) start, end - start, MEM_RESET, PAGE_READWRITE)) {
+                ret = end - start;
+            }
+#else
+            if (madvise((void *) start, end - start, MADV_DONTNEED) == 0) {
+                ret = end - start;
+            }
+#endif
+        }
+    }
+
+    uatomic_int_zero(&rbst->WLock);
+    return ret;
+}
+
+
+/* bytes of ring buffer resident in physical memory */
+static size_t ringbufst_resident (const ring_buffer_st *rbst)
+{
+#ifdef __WINDOWS__
+    return sizeof(*rbst) + rbst->Length;
+#else
+    unsigned char vec[256];
+    size_t resident = 0;
+
+    size_t addr = (size_t) rbst & ~(RINGBUFST_PAGE_SIZE - 1);
+    size_t end = RINGBUFST_ALIGN_PAGESIZE((size_t) rbst->Buffer + rbst->Length);
+
+    while (addr < end) {
+        size_t i, npages = (end - addr) / RINGBUFST_PAGE_SIZE;
+
+        if (npages > sizeof(vec)) {
+            npages = sizeof(vec);
+        }
+
+        if (mincore((void *) addr, npages * RINGBUFST_PAGE_SIZE, vec) != 0) {
+            break;
+        }
+
+        for (i = 0; i < npages; i++) {
+            resident += (vec[i] & 1);
+        }
+
+        addr += npages * RINGBUFST_PAGE_SIZE;
+    }
+
+    return resident * RINGBUFST_PAGE_SIZE;
+#endif
 }
 
 
@@ -178,9 +419,9 @@ static int ringbufst_write (ring_buffer_st *rbst, size_t chunksz, void(*write_cb
     }
 
     if (! uatomic_int_comp_exch(&rbst->WLock, 0, 1)) {
-        /* Get original ROffset */
-        Ro = uatomic_int_get(&rbst->ROffset);
+        /* WOffset is only changed by writer holding WLock */
         Wo = rbst->WOffset;
+        Ro = __ringbufst_writer_roffset(rbst, Wo, L, AENTSZ);
 
         RINGBUFST_RESTORE_STATE(Ro, Wo, L);
 
@@ -194,7 +435,7 @@ static int ringbufst_write (ring_buffer_st *rbst, size_t chunksz, void(*write_cb
 
                 /* WOffset = Wo + AENTSZ */
                 W = RINGBUFST_NORMALIZE_OFFSET(Wo + AENTSZ, L);
-                uatomic_int_set(&rbst->WOffset, INT_CAST_TO_LONG(W));
+                uatomic_int_store_rel(&rbst->WOffset, INT_CAST_TO_LONG(W));
             } else {   /* wrap(0): 0 .. R < W < L */
                 if (L - W >= AENTSZ) {
                     entry = RINGBUFST_ENTRY_CAST(&rbst->Buffer[W]);
@@ -204,7 +445,7 @@ static int ringbufst_write (ring_buffer_st *rbst, size_t chunksz, void(*write_cb
 
                     /* WOffset = Wo + AENTSZ */
                     W = RINGBUFST_NORMALIZE_OFFSET(Wo + AENTSZ, L);
-                    uatomic_int_set(&rbst->WOffset, INT_CAST_TO_LONG(W));
+                    uatomic_int_store_rel(&rbst->WOffset, INT_CAST_TO_LONG(W));
                 } else if (R - 0 >= AENTSZ) {
                     /* clear W slot before wrap W */
                     bzero(&rbst->Buffer[W], L - W);
@@ -218,7 +459,7 @@ static int ringbufst_write (ring_buffer_st *rbst, size_t chunksz, void(*write_cb
                     /* WOffset = AENTSZ, wrap = 1 */
                     W = AENTSZ + (1 - (int)(Ro/L))*L;
 
-                    uatomic_int_set(&rbst->WOffset, INT_CAST_TO_LONG(W));
+                    uatomic_int_store_rel(&rbst->WOffset, INT_CAST_TO_LONG(W));
                 } else {
                     /* no space left to write. expect to call again(0) */
                     uatomic_int_zero(&rbst->WLock);
@@ -241,6 +482,70 @@ static int ringbufst_write (ring_buffer_st *rbst, size_t chunksz, void(*write_cb
 }
 
 
+/**
+ * write entries made by caller one after another (size of each chunk and
+ *  chunk padded to RINGBUFST_ALIGN_ENTRYSIZE) under one lock, publishing
+ *  WOffset once. entries are written in order until one has no room.
+ * returns:
+ *   bytes of entries written: less than entriessz if no room left, 0 if
+ *   locked. -1 if an entry is invalid.
+ */
+static ssize_t ringbufst_write_entries (ring_buffer_st *rbst, const char *entries, size_t entriessz)
+{
+    const ringbuf_entry_st *entry;
+
+    ssize_t Ro, Wo, AENTSZ,
+        L = (ssize_t) rbst->Length,
+        written = 0;
+
+    if (uatomic_int_comp_exch(&rbst->WLock, 0, 1)) {
+        /* lock fail to write, expect to call again(0) */
+        return 0;
+    }
+
+    Wo = rbst->WOffset;
+
+    while (written < (ssize_t) entriessz) {
+        entry = (const ringbuf_entry_st *) (entries + written);
+        AENTSZ = (ssize_t) RINGBUFST_ALIGN_ENTRYSIZE(entry->size);
+
+        if (! entry->size || AENTSZ > (ssize_t) (L / RINGBUFST_ENTRY_HDRSIZE) || written + AENTSZ > (ssize_t) entriessz) {
+            written = (-1);
+            break;
+        }
+
+        Ro = __ringbufst_writer_roffset(rbst, Wo, L, AENTSZ);
+
+        RINGBUFST_RESTORE_STATE(Ro, Wo, L);
+
+        if (L - (wrap*L + W - R) < AENTSZ) {
+            break;
+        }
+
+        if (wrap || L - W >= AENTSZ) {
+            memcpy(&rbst->Buffer[W], entry, AENTSZ);
+            Wo = RINGBUFST_NORMALIZE_OFFSET(Wo + AENTSZ, L);
+        } else if (R - 0 >= AENTSZ) {
+            /* clear W slot before wrap W to 0 */
+            bzero(&rbst->Buffer[W], L - W);
+            memcpy(&rbst->Buffer[0], entry, AENTSZ);
+            Wo = AENTSZ + (1 - (int)(Ro/L))*L;
+        } else {
+            break;
+        }
+
+        written += AENTSZ;
+    }
+
+    if (written > 0) {
+        uatomic_int_store_rel(&rbst->WOffset, INT_CAST_TO_LONG(Wo));
+    }
+
+    uatomic_int_zero(&rbst->WLock);
+    return written;
+}
+
+
 static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdbufsz)
 {
     ringbuf_entry_st *entry;
@@ -250,8 +555,8 @@ static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdb
             HENTSZ = (ssize_t)RINGBUFST_ALIGN_ENTRYSIZE(0);
 
     if (! uatomic_int_comp_exch(&rbst->RLock, 0, 1)) {
-        Wo = uatomic_int_get(&rbst->WOffset);
         Ro = rbst->ROffset;
+        Wo = __ringbufst_reader_woffset(rbst, Ro, L);
 
         RINGBUFST_RESTORE_STATE(Ro, Wo, L);
 
@@ -276,7 +581,7 @@ static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdb
                             memcpy(rdbuf, entry->chunk, entsize);
 
                             R = RINGBUFST_NORMALIZE_OFFSET(Ro + AENTSZ, L);
-                            uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(R));
+                            uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(R));
 
                             /* read success if returned entsize <= rdbufsz */
                             uatomic_int_zero(&rbst->RLock);
@@ -287,7 +592,7 @@ static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdb
                         return (-1);
                     } else {
                         /* reset ROffset to 0 (set wrap = 0) */
-                        uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG((Wo/L) * L));
+                        uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG((Wo/L) * L));
 
                         /* expect to read again */
                         uatomic_int_zero(&rbst->RLock);
@@ -312,7 +617,7 @@ static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdb
                             memcpy(rdbuf, entry->chunk, entsize);
 
                             /* ROffset = AENTSZ, wrap = 0 */
-                            uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(AENTSZ + (Wo/L)*L));
+                            uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(AENTSZ + (Wo/L)*L));
 
                             /* read success if returned entsize <= rdbufsz */
                             uatomic_int_zero(&rbst->RLock);
@@ -342,7 +647,7 @@ static size_t ringbufst_read_copy (ring_buffer_st *rbst, char *rdbuf, size_t rdb
                         memcpy(rdbuf, entry->chunk, entsize);
 
                         R = RINGBUFST_NORMALIZE_OFFSET(Ro + AENTSZ, L);
-                        uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(R));
+                        uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(R));
 
                         /* read success if returned entsize <= rdbufsz */
                         uatomic_int_zero(&rbst->RLock);
@@ -372,8 +677,8 @@ static int ringbufst_read_next (ring_buffer_st *rbst, int (*nextentry_cb)(const
     int ret = 0;
 
     if (! uatomic_int_comp_exch(&rbst->RLock, 0, 1)) {
-        ssize_t Wo = uatomic_int_get(&rbst->WOffset);
         ssize_t Ro = rbst->ROffset;
+        ssize_t Wo = __ringbufst_reader_woffset(rbst, Ro, (ssize_t)rbst->Length);
         ssize_t wrap = RINGBUFST_RESTORE_WRAP(Ro, Wo, rbst->Length);
 
         ret = __ringbufst_read_internal(rbst, wrap, Ro, Wo, (ssize_t)rbst->Length, nextentry_cb, arg);
@@ -393,8 +698,8 @@ static int ringbufst_read_next_batch (ring_buffer_st *rbst, int (*nextentry_cb)(
         ssize_t wrap, Wo, Ro;
 
         while (batch-- > 0) {
-            Wo = uatomic_int_get(&rbst->WOffset);
             Ro = rbst->ROffset;
+            Wo = __ringbufst_reader_woffset(rbst, Ro, (ssize_t)rbst->Length);
             wrap = RINGBUFST_RESTORE_WRAP(Ro, Wo, rbst->Length);
 
             ret = __ringbufst_read_internal(rbst, wrap, Ro, Wo, (ssize_t)rbst->Length, nextentry_cb, arg);
@@ -445,7 +750,7 @@ int __ringbufst_read_internal (ring_buffer_st *rbst, ssize_t wrap, ssize_t Ro, s
                         if (nextentry_cb(entry, arg)) {
                             /* read success and set ROffset to next entry */
                             R = RINGBUFST_NORMALIZE_OFFSET(Ro + AENTSZ, L);
-                            uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(R));
+                            uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(R));
 
                             return 1;
                         } else {
@@ -458,7 +763,7 @@ int __ringbufst_read_internal (ring_buffer_st *rbst, ssize_t wrap, ssize_t Ro, s
                     return (-1);
                 } else {
                     /* reset ROffset to 0 (set wrap = 0) */
-                    uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG((Wo/L) * L));
+                    uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG((Wo/L) * L));
 
                     return ringbufst_read_next(rbst, nextentry_cb, arg);
                 }
@@ -471,7 +776,7 @@ int __ringbufst_read_internal (ring_buffer_st *rbst, ssize_t wrap, ssize_t Ro, s
                     if (W - 0 >= AENTSZ) {
                         if (nextentry_cb(entry, arg)) {
                             /* read success and set ROffset to next entry */
-                            uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(AENTSZ + (Wo/L)*L));
+                            uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(AENTSZ + (Wo/L)*L));
 
                             return 1;
                         } else {
@@ -493,7 +798,7 @@ int __ringbufst_read_internal (ring_buffer_st *rbst, ssize_t wrap, ssize_t Ro, s
                     if (nextentry_cb(entry, arg)) {
                         /* read success and set ROffset to next entry */
                         R = RINGBUFST_NORMALIZE_OFFSET(Ro + AENTSZ, L);
-                        uatomic_int_set(&rbst->ROffset, INT_CAST_TO_LONG(R));
+                        uatomic_int_store_rel(&rbst->ROffset, INT_CAST_TO_LONG(R));
 
                         return 1;
                     } else {
@@ -44,13 +44,16 @@ static void * rtclock_timerthread (void *_rtc)
 
     rtclock_handle rtc = (rtclock_handle)_rtc;
 
-    int64_t ratious = (int64_t) uatomic_int_get(&rtc->ratious);
+    int64_t ratious;
 
     struct timespec timeout;
-    timeout.tv_sec  = ratious / MICROS_OF_SECOND;
-    timeout.tv_nsec = (ratious % MICROS_OF_SECOND) * 1000;
 
     for (;;) {
+        /* frequency may be raised by rtclock_set_frequency() */
+        ratious = (int64_t) uatomic_int_get(&rtc->ratious);
+        timeout.tv_sec  = ratious / MICROS_OF_SECOND;
+        timeout.tv_nsec = (ratious % MICROS_OF_SECOND) * 1000;
+
         rtclock_updatetime(rtc, &nowtime);
 
         nanos = nowtime.tv_nsec + timeout.tv_nsec;
@@ -118,6 +121,10 @@ rtclock_handle rtclock_init (rtclock_frequency_t frequency)
             exit(EXIT_FAILURE);
         }
 
+#ifdef RTCLOCK_HAVE_TSC
+        rtc->tscinvariant = rtclock_tscinvariant();
+#endif
+
         rtclock_updatetime(rtc, &nowtime);
 
         rtc->timezone = timezone_compute(nowtime.tv_sec, rtc->timezonefmt);
@@ -164,9 +171,36 @@ int rtclock_timezone (rtclock_handle rtc, const char **tzfmt)
 }
 
 
+/* ids of ticktime are taken from ticknanos by thread in blocks */
+#define RTCLOCK_TICKID_BLOCK  256
+
+typedef struct
+{
+    rtclock_handle rtc;
+    int64_t tickbase;
+    uint64_t next;
+    uint64_t end;
+} rtclock_tickblock_t;
+
+static THREAD_LOCAL rtclock_tickblock_t rtclock_tickblock;
+
+
 int64_t rtclock_ticktime (rtclock_handle rtc, struct timespec *ticktime)
 {
-    uint64_t nanos = (uint64_t)uatomic_int64_add(&rtc->ticknanos);
+    uint64_t nanos;
+    rtclock_tickblock_t *blk = &rtclock_tickblock;
+
+    int64_t tickbase = uatomic_int64_load_acq(&rtc->tickbase);
+
+    if (blk->next == blk->end || blk->tickbase != tickbase || blk->rtc != rtc) {
+        /* a new block on every tick keeps ids close to time */
+        blk->end = (uint64_t) uatomic_int64_add_n(&rtc->ticknanos, RTCLOCK_TICKID_BLOCK);
+        blk->next = blk->end - RTCLOCK_TICKID_BLOCK;
+        blk->tickbase = tickbase;
+        blk->rtc = rtc;
+    }
+
+    nanos = ++blk->next;
 
     ticktime->tv_sec = (time_t)(nanos / NANOS_OF_SECOND);
     ticktime->tv_nsec = nanos % NANOS_OF_SECOND;
@@ -187,4 +221,95 @@ void rtclock_localtime(rtclock_handle rtc, int timezone, int daylight, struct tm
 
     tmloc->tm_year += 1900;
     tmloc->tm_mon += 1;
-}
\ No newline at end of file
+}
+
+
+void rtclock_set_frequency (rtclock_handle rtc, rtclock_frequency_t frequency)
+{
+    if (frequency == RTCLOCK_FREQ_MSEC) {
+        uatomic_int_set(&rtc->ratious, (int)MILLIS_OF_SECOND);
+    }
+}
+
+
+rtclock_source_t rtclock_source_check (rtclock_handle rtc, rtclock_source_t source)
+{
+    if (source == RTCLOCK_SOURCE_TSC && ! rtc->tscinvariant) {
+        return RTCLOCK_SOURCE_REALTIME;
+    }
+    return source;
+}
+
+
+void rtclock_gettime (rtclock_handle rtc, rtclock_source_t source, struct timespec *now)
+{
+    int seq;
+
+    switch (source) {
+    case RTCLOCK_SOURCE_COARSE:
+#if defined(CLOCK_REALTIME_COARSE)
+        if (clock_gettime(CLOCK_REALTIME_COARSE, now) == 0) {
+            break;
+        }
+#endif
+        getnowtimeofday(now);
+        break;
+
+#ifdef RTCLOCK_HAVE_TSC
+    case RTCLOCK_SOURCE_TSC:
+        for (;;) {
+            uint64_t tsc, tscbase, nsbase, mult;
+
+            seq = uatomic_int_load_acq(&rtc->pubseq);
+            tscbase = rtc->tscbase;
+            nsbase = rtc->tscnsbase;
+            mult = rtc->tscmult;
+            uatomic_fence_acq();
+
+            if ((seq & 1) || seq != uatomic_int_load_acq(&rtc->pubseq)) {
+                continue;
+            }
+
+            if (! mult) {
+                /* not calibrated yet */
+                getnowtimeofday(now);
+                break;
+            }
+
+            tsc = rtclock_readtsc();
+            if (tsc > tscbase) {
+                nsbase += rtclock_mulshift32(tsc - tscbase, mult);
+            }
+
+            now->tv_sec = (time_t)(nsbase / NANOS_OF_SECOND);
+            now->tv_nsec = (long)(nsbase % NANOS_OF_SECOND);
+            break;
+        }
+        break;
+#endif
+
+    case RTCLOCK_SOURCE_RTCLOCK:
+        for (;;) {
+            int64_t sec;
+            long nsec;
+
+            seq = uatomic_int_load_acq(&rtc->pubseq);
+            sec = rtc->pubsec;
+            nsec = rtc->pubnsec;
+            uatomic_fence_acq();
+
+            if ((seq & 1) || seq != uatomic_int_load_acq(&rtc->pubseq)) {
+                continue;
+            }
+
+            now->tv_sec = (time_t) sec;
+            now->tv_nsec = nsec;
+            break;
+        }
+        break;
+
+    default:
+        getnowtimeofday(now);
+        break;
+    }
+}
@@ -69,6 +69,18 @@ typedef enum
 } rtclock_frequency_t;
 
 
+/**
+ * where rtclock_gettime() reads time from
+ */
+typedef enum
+{
+    RTCLOCK_SOURCE_REALTIME = 0,    /* clock_gettime(CLOCK_REALTIME) */
+    RTCLOCK_SOURCE_COARSE   = 1,    /* CLOCK_REALTIME_COARSE: resolution of kernel tick */
+    RTCLOCK_SOURCE_TSC      = 2,    /* invariant TSC calibrated by timer thread */
+    RTCLOCK_SOURCE_RTCLOCK  = 3     /* time published by timer thread every tick */
+} rtclock_source_t;
+
+
 /**
  * real time clock api
  */
@@ -80,10 +92,19 @@ extern int rtclock_timezone (rtclock_handle rtc, const char **tzfmt);
 
 extern int rtclock_daylight (rtclock_handle rtc);
 
+/* unique id as time of tick: monotonic per thread without contention */
 extern int64_t rtclock_ticktime (rtclock_handle rtc, struct timespec *ticktime);
 
 extern void rtclock_localtime(rtclock_handle rtc, int timezone, int daylight, struct tm *tmloc, struct timespec *now);
 
+/* raise frequency of timer thread. never lowered */
+extern void rtclock_set_frequency (rtclock_handle rtc, rtclock_frequency_t frequency);
+
+/* source actually used: TSC falls back to REALTIME without invariant TSC */
+extern rtclock_source_t rtclock_source_check (rtclock_handle rtc, rtclock_source_t source);
+
+extern void rtclock_gettime (rtclock_handle rtc, rtclock_source_t source, struct timespec *now);
+
 #ifdef __cplusplus
 }
 #endif
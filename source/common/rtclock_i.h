@@ -46,6 +46,15 @@ extern "C" {
 #include "timeut.h"
 #include "fileut.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  # include <x86intrin.h>
+  # include <cpuid.h>
+  # define RTCLOCK_HAVE_TSC
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  # include <intrin.h>
+  # define RTCLOCK_HAVE_TSC
+#endif
+
 
 /**
  * linux date command:
@@ -72,6 +81,9 @@ extern "C" {
 /* (ns) nanoeconds of one second */
 #define NANOS_OF_SECOND    ((uint64_t)1000000000l)
 
+/* tsc rate is measured over at most this window (seconds) */
+#define RTCLOCK_TSC_WINDOW  60
+
 
 typedef struct _rtclock_t
 {
@@ -83,15 +95,138 @@ typedef struct _rtclock_t
     pthread_mutex_t timerlock;
     pthread_t timerthread;
 
-    /* fake time in nanos supports up to max year 2484 AC. */
+    /* fake time in nanos supports up to max year 2484 AC. never goes back */
     uatomic_int64 ticknanos;
 
+    /* aligned time in nanos of last tick */
+    uatomic_int64 tickbase;
+
     int daylight;
     long timezone;
     char timezonefmt[TIMEZONE_FORMAT_LEN + 1];
+
+    /* 1 if tsc is invariant (constant rate in all P/C-states) */
+    int tscinvariant;
+
+    /* timer thread only: start of tsc calibration window */
+    uint64_t tscfirst;
+    uint64_t nsfirst;
+
+    /* seqlock: odd while timer thread is updating below fields */
+    uatomic_int pubseq;
+
+    /* time of last tick */
+    volatile int64_t pubsec;
+    volatile long pubnsec;
+
+    /* ns = tscnsbase + ((tsc - tscbase) * tscmult) >> 32 */
+    volatile uint64_t tscbase;
+    volatile uint64_t tscnsbase;
+    volatile uint64_t tscmult;
 } rtclock_t;
 
 
+#ifdef RTCLOCK_HAVE_TSC
+NOWARNING_UNUSED(static)
+uint64_t rtclock_readtsc (void)
+{
+    return (uint64_t) __rdtsc();
+}
+
+
+NOWARNING_UNUSED(static)
+int rtclock_tscinvariant (void)
+{
+    unsigned int regs[4] = {0};
+
+# if defined(_MSC_VER)
+    __cpuid((int *) regs, 0x80000000);
+    if (regs[0] < 0x80000007) {
+        return 0;
+    }
+    __cpuid((int *) regs, 0x80000007);
+# else
+    if (! __get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) || regs[0] < 0x80000007) {
+        return 0;
+    }
+    __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+# endif
+
+    /* CPUID.80000007H:EDX[8] */
+    return (regs[3] & (1 << 8))? 1 : 0;
+}
+#endif
+
+
+/* (delta * mult) >> 32 without 128-bit integer */
+NOWARNING_UNUSED(static)
+uint64_t rtclock_mulshift32 (uint64_t delta, uint64_t mult)
+{
+    return (delta >> 32) * mult + (((delta & 0xffffffffULL) * mult) >> 32);
+}
+
+
+/**
+ * publish time of tick and tsc calibration by timer thread
+ */
+static void rtclock_publish (rtclock_handle rtc, const struct timespec *nowtime)
+{
+    int seq;
+    uint64_t tsc = 0, mult = 0;
+    uint64_t ns = (uint64_t) nowtime->tv_sec * NANOS_OF_SECOND + nowtime->tv_nsec;
+
+#ifdef RTCLOCK_HAVE_TSC
+    if (rtc->tscinvariant) {
+        tsc = rtclock_readtsc();
+
+        if (! rtc->tscfirst || ns < rtc->nsfirst || tsc <= rtc->tscfirst) {
+            /* start calibration */
+            rtc->tscfirst = tsc;
+            rtc->nsfirst = ns;
+        } else if (ns - rtc->nsfirst >= NANOS_OF_SECOND / 1000) {
+            mult = (uint64_t) ((double)(ns - rtc->nsfirst) / (double)(tsc - rtc->tscfirst) * 4294967296.0);
+
+            if (ns - rtc->nsfirst > RTCLOCK_TSC_WINDOW * NANOS_OF_SECOND) {
+                /* slide window to follow adjustment of realtime */
+                rtc->tscfirst = rtc->tscbase;
+                rtc->nsfirst = rtc->tscnsbase;
+            }
+        }
+    }
+#endif
+
+    seq = rtc->pubseq;
+    uatomic_int_store_rel(&rtc->pubseq, seq + 1);
+    uatomic_fence_rel();
+
+    rtc->pubsec = (int64_t) nowtime->tv_sec;
+    rtc->pubnsec = nowtime->tv_nsec;
+
+    rtc->tscbase = tsc;
+    rtc->tscnsbase = ns;
+    rtc->tscmult = mult;
+
+    uatomic_int_store_rel(&rtc->pubseq, seq + 2);
+}
+
+
+/* ids taken by threads are below ticknanos, so it is raised but never set back */
+static void rtclock_raisetick (rtclock_handle rtc, int64_t nanos)
+{
+    int64_t old = uatomic_int64_get(&rtc->ticknanos);
+
+    while (old < nanos) {
+        int64_t prev = uatomic_int64_comp_exch(&rtc->ticknanos, old, nanos);
+        if (prev == old) {
+            break;
+        }
+        old = prev;
+    }
+
+    uatomic_int64_store_rel(&rtc->tickbase, nanos);
+}
+
+
 static void rtclock_updatetime (rtclock_handle rtc, struct timespec *nowtime)
 {
     uint64_t timeus;
@@ -104,8 +239,10 @@ static void rtclock_updatetime (rtclock_handle rtc, struct timespec *nowtime)
     /* aligned time in us: timeus=1606890292000000 */
     timeus = (uint64_t)((timeus / rtc->ratious) * rtc->ratious);
 
-    /* set aligned time in ns: ticknanos=1606890292000000000 */
-    uatomic_int64_set(&rtc->ticknanos, timeus * (uint64_t)1000);
+    /* raise aligned time in ns: ticknanos=1606890292000000000 */
+    rtclock_raisetick(rtc, (int64_t)(timeus * (uint64_t)1000));
+
+    rtclock_publish(rtc, nowtime);
 }
 
 
@@ -103,6 +103,9 @@ extern "C"
 
 #define SHMMBUF_ENTRY_HDRSIZE    (sizeof(shmmbuf_entry_t))
 
+/* fields of writers and of reader are kept apart by (fixed for all processes) */
+#define SHMMBUF_CACHELINE_SIZE   128
+
 #define SHMMBUF_ALIGN_BSIZE(bsz, alignsize)  \
             ((size_t)((((size_t)(bsz)+(alignsize)-1)/(alignsize))*(alignsize)))
 
@@ -354,6 +357,10 @@ size_t shmmbuf_state_get (shmmbuf_state_t *st)
 }
 
 
+/* state stored by other process without taking its lock */
+#define shmmbuf_state_load_acq(st)  __atomic_load_n(&(st)->state, __ATOMIC_ACQUIRE)
+
+
 NOWARNING_UNUSED(static)
 size_t shmmbuf_state_set (shmmbuf_state_t *st, size_t newval)
 {
@@ -362,7 +369,7 @@ size_t shmmbuf_state_set (shmmbuf_state_t *st, size_t newval)
 
     if (! err) {
         oldval = st->state;
-        st->state = newval;
+        __atomic_store_n(&st->state, newval, __ATOMIC_RELEASE);
         pthread_mutex_unlock(&st->mutex);
         return oldval;
     } else if (err == EOWNERDEAD) {
@@ -385,7 +392,7 @@ size_t shmmbuf_state_comp_exch (shmmbuf_state_t *st, size_t comp, size_t exch)
     if (! err) {
         oldval = st->state;
         if (st->state == comp) {
-            st->state = exch;
+            __atomic_store_n(&st->state, exch, __ATOMIC_RELEASE);
         }
         pthread_mutex_unlock(&st->mutex);
         return oldval;
@@ -588,23 +595,35 @@ typedef struct _shmmap_buffer_t
      *    Sr > 0: readable
      */
 
-    /* Read Lock */
-    pthread_mutex_t RLock;
+    /**
+     * fields of writers and of reader are on their own cache lines, each
+     *  side loads offset of other side again only when the one it has seen
+     *  last time says full or empty.
+     */
 
     /* Write Lock */
-    pthread_mutex_t WLock;
+    pthread_mutex_t WLock __attribute__((aligned(SHMMBUF_CACHELINE_SIZE)));
 
     /* Write Offset to the Buffer start */
     shmmbuf_state_t WOffset;
 
+    /* ROffset last seen by writer */
+    ssize_t WCacheR;
+
+    /* Read Lock */
+    pthread_mutex_t RLock __attribute__((aligned(SHMMBUF_CACHELINE_SIZE)));
+
     /* Read Offset to the Buffer start */
     shmmbuf_state_t ROffset;
 
+    /* WOffset last seen by reader */
+    ssize_t RCacheW;
+
     /* Length of ring Buffer: total size in bytes */
-    size_t Length;
+    size_t Length __attribute__((aligned(SHMMBUF_CACHELINE_SIZE)));
 
     /* ring buffer in shared memory with Length */
-    char Buffer[0];
+    char Buffer[0] __attribute__((aligned(SHMMBUF_CACHELINE_SIZE)));
 } shmmap_buffer_t;
 
 
@@ -622,6 +641,40 @@ typedef struct _shmmap_buffer_t
     ((((Ao)/(L))%2)*L + (Ao)%(L))
 
 
+/* writer: ROffset seen last time if entry of AENTSZ fits by it, or else loads ROffset again */
+NOWARNING_UNUSED(static)
+ssize_t __shmmap_writer_roffset (shmmap_buffer_t *shmbuf, ssize_t Wo, ssize_t L, ssize_t AENTSZ)
+{
+    ssize_t Ro = shmbuf->WCacheR;
+
+    SHMRINGBUF_RESTORE_STATE(Ro, Wo, L);
+
+    if (L - (wrap*L + W - R) < AENTSZ || (! wrap && L - W < AENTSZ && R < AENTSZ)) {
+        Ro = (ssize_t) shmmbuf_state_load_acq(&shmbuf->ROffset);
+        shmbuf->WCacheR = Ro;
+    }
+
+    return Ro;
+}
+
+
+/* reader: WOffset seen last time if any entry to read by it, or else loads WOffset again */
+NOWARNING_UNUSED(static)
+ssize_t __shmmap_reader_woffset (shmmap_buffer_t *shmbuf, ssize_t Ro, ssize_t L)
+{
+    ssize_t Wo = shmbuf->RCacheW;
+
+    SHMRINGBUF_RESTORE_STATE(Ro, Wo, L);
+
+    if (wrap*L + W - R <= (ssize_t) SHMMBUF_ALIGN_ENTRYSIZE(0)) {
+        Wo = (ssize_t) shmmbuf_state_load_acq(&shmbuf->WOffset);
+        shmbuf->RCacheW = Wo;
+    }
+
+    return Wo;
+}
+
+
 NOWARNING_UNUSED(static)
 int __shmmap_buffer_read_internal (shmmap_buffer_t *shmbuf, ssize_t wrap, ssize_t R, ssize_t W, ssize_t L, int (*nextentry_cb)(const shmmbuf_entry_t *, void *), void *arg);
 
@@ -885,9 +938,9 @@ int shmmap_buffer_write (shmmap_buffer_t *shmbuf, const void *chunk, size_t chun
     }
 
     if (process_shared_mutex_lock(&shmbuf->WLock, 1) == 0) {
-        /* Get original ROffset */
-        Ro = shmmbuf_state_get(&shmbuf->ROffset);
+        /* WOffset is only changed by writer holding WLock */
         Wo = shmbuf->WOffset.state;
+        Ro = __shmmap_writer_roffset(shmbuf, Wo, L, AENTSZ);
 
         SHMRINGBUF_RESTORE_STATE(Ro, Wo, L);
 
@@ -975,8 +1028,8 @@ size_t shmmap_buffer_read_copy (shmmap_buffer_t *shmbuf, char *rdbuf, size_t rdb
             HENTSZ = (ssize_t)SHMMBUF_ALIGN_ENTRYSIZE(0);
 
     if (process_shared_mutex_lock(&shmbuf->RLock, 1) == 0) {
-        Wo = shmmbuf_state_get(&shmbuf->WOffset);
         Ro = shmbuf->ROffset.state;
+        Wo = __shmmap_reader_woffset(shmbuf, Ro, L);
 
         SHMRINGBUF_RESTORE_STATE(Ro, Wo, L);
 
@@ -1120,8 +1173,8 @@ int shmmap_buffer_read_next (shmmap_buffer_t *shmbuf, int (*nextentry_cb)(const
     int ret = SHMMBUF_READ_AGAIN;
 
     if (process_shared_mutex_lock(&shmbuf->RLock, 1) == 0) {
-        ssize_t Wo = shmmbuf_state_get(&shmbuf->WOffset);
         ssize_t Ro = shmbuf->ROffset.state;
+        ssize_t Wo = __shmmap_reader_woffset(shmbuf, Ro, (ssize_t)shmbuf->Length);
         ssize_t wrap = SHMRINGBUF_RESTORE_WRAP(Ro, Wo, shmbuf->Length);
 
         ret = __shmmap_buffer_read_internal(shmbuf, wrap, Ro, Wo, (ssize_t)shmbuf->Length, nextentry_cb, arg);
@@ -1147,8 +1200,8 @@ int shmmap_buffer_read_next_batch (shmmap_buffer_t *shmbuf, int (*nextentry_cb)(
         ssize_t wrap, Wo, Ro;
 
         while (batch-- > 0) {
-            Wo = shmmbuf_state_get(&shmbuf->WOffset);
             Ro = shmbuf->ROffset.state;
+            Wo = __shmmap_reader_woffset(shmbuf, Ro, (ssize_t)shmbuf->Length);
             wrap = SHMRINGBUF_RESTORE_WRAP(Ro, Wo, shmbuf->Length);
 
             ret = __shmmap_buffer_read_internal(shmbuf, wrap, Ro, Wo, (ssize_t)shmbuf->Length, nextentry_cb, arg);
@@ -81,6 +81,16 @@
 #endif
 
 
+/**
+ * bytes between fields written by different threads. 128 covers 64-byte
+ *  lines fetched in pairs (x86 adjacent-line prefetch) and 128-byte lines
+ *  (apple arm64, power). -DUATOMIC_CACHELINE_SIZE=64 to trade for memory.
+ */
+#ifndef UATOMIC_CACHELINE_SIZE
+#   define UATOMIC_CACHELINE_SIZE   128
+#endif
+
+
 #if defined(_LINUX_GNUC) || defined(__CYGWIN__)
 // Linux (实现GCC/Clang)
 typedef volatile int         uatomic_int;
@@ -115,6 +125,17 @@ typedef volatile void *      uatomic_ptr;
 #   define uatomic_ptr_zero(a)          uatomic_int_zero(((void**)(a)))
 #   define uatomic_ptr_comp_exch(a, comp, exch)  uatomic_int_comp_exch(((void**)(a)), (comp), (exch))
 
+/* plain load-acquire and store-release without locked instruction */
+#   define uatomic_int_load_acq(a)          __atomic_load_n(a, __ATOMIC_ACQUIRE)
+#   define uatomic_int_store_rel(a, newval) __atomic_store_n(a, (newval), __ATOMIC_RELEASE)
+#   define uatomic_int64_load_acq(a)        __atomic_load_n(a, __ATOMIC_ACQUIRE)
+#   define uatomic_int64_store_rel(a, newval) __atomic_store_n(a, (newval), __ATOMIC_RELEASE)
+#   define uatomic_ptr_load_acq(a)          __atomic_load_n(((void**)(a)), __ATOMIC_ACQUIRE)
+#   define uatomic_ptr_store_rel(a, newval) __atomic_store_n(((void**)(a)), (newval), __ATOMIC_RELEASE)
+#   define uatomic_fence_acq()              __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#   define uatomic_fence_rel()              __atomic_thread_fence(__ATOMIC_RELEASE)
+#   define uatomic_fence_full()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
 #elif defined(__WINDOWS__)
 typedef volatile LONG        uatomic_int;
 typedef uatomic_int          uatomic_bool;
@@ -149,6 +170,103 @@ typedef volatile PVOID       uatomic_ptr;
 #   define uatomic_ptr_zero(a)          InterlockedExchangePointer(a, 0)
 #   define uatomic_ptr_comp_exch(a, comp, exch)  InterlockedCompareExchangePointer(a, (exch), (comp))
 
+/* plain load-acquire and store-release without locked instruction */
+#   if defined(__GNUC__)
+// MingW
+#   define uatomic_int_load_acq(a)          __atomic_load_n(a, __ATOMIC_ACQUIRE)
+#   define uatomic_int_store_rel(a, newval) __atomic_store_n(a, (newval), __ATOMIC_RELEASE)
+#   define uatomic_int64_load_acq(a)        __atomic_load_n(a, __ATOMIC_ACQUIRE)
+#   define uatomic_int64_store_rel(a, newval) __atomic_store_n(a, (newval), __ATOMIC_RELEASE)
+#   define uatomic_ptr_load_acq(a)          __atomic_load_n(((void**)(a)), __ATOMIC_ACQUIRE)
+#   define uatomic_ptr_store_rel(a, newval) __atomic_store_n(((void**)(a)), (newval), __ATOMIC_RELEASE)
+#   define uatomic_fence_acq()              __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#   define uatomic_fence_rel()              __atomic_thread_fence(__ATOMIC_RELEASE)
+#   define uatomic_fence_full()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#   elif defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64)
+// MSVC: volatile is not acquire/release with /volatile:iso (default on ARM)
+#   include <intrin.h>
+
+#   if defined(_M_ARM64)
+#       define uatomic_hw_barrier_()        __dmb(_ARM64_BARRIER_ISH)
+#   elif defined(_M_ARM)
+#       define uatomic_hw_barrier_()        __dmb(_ARM_BARRIER_ISH)
+#   else
+/* x86 and x64 keep order of loads and of stores: compiler barrier only */
+#       define uatomic_hw_barrier_()        ((void) 0)
+#   endif
+
+static __inline LONG uatomic_int_load_acq_ (const volatile LONG *a)
+{
+    LONG v = (LONG) __iso_volatile_load32((const volatile __int32 *) a);
+    _ReadWriteBarrier();
+    uatomic_hw_barrier_();
+    return v;
+}
+
+static __inline void uatomic_int_store_rel_ (volatile LONG *a, LONG v)
+{
+    uatomic_hw_barrier_();
+    _ReadWriteBarrier();
+    __iso_volatile_store32((volatile __int32 *) a, (__int32) v);
+}
+
+static __inline LONG64 uatomic_int64_load_acq_ (const volatile LONG64 *a)
+{
+#   if defined(_M_IX86)
+    /* no plain 64-bit access on x86: never torn by cmpxchg8b */
+    return InterlockedCompareExchange64((volatile LONG64 *) a, 0, 0);
+#   else
+    LONG64 v = (LONG64) __iso_volatile_load64((const volatile __int64 *) a);
+    _ReadWriteBarrier();
+    uatomic_hw_barrier_();
+    return v;
+#   endif
+}
+
+static __inline void uatomic_int64_store_rel_ (volatile LONG64 *a, LONG64 v)
+{
+#   if defined(_M_IX86)
+    InterlockedExchange64(a, v);
+#   else
+    uatomic_hw_barrier_();
+    _ReadWriteBarrier();
+    __iso_volatile_store64((volatile __int64 *) a, (__int64) v);
+#   endif
+}
+
+static __inline void * uatomic_ptr_load_acq_ (const volatile PVOID *a)
+{
+#   if defined(_WIN64)
+    return (void *) uatomic_int64_load_acq_((const volatile LONG64 *) a);
+#   else
+    return (void *) (LONG_PTR) uatomic_int_load_acq_((const volatile LONG *) a);
+#   endif
+}
+
+static __inline void uatomic_ptr_store_rel_ (volatile PVOID *a, void *v)
+{
+#   if defined(_WIN64)
+    uatomic_int64_store_rel_((volatile LONG64 *) a, (LONG64) v);
+#   else
+    uatomic_int_store_rel_((volatile LONG *) a, (LONG) (LONG_PTR) v);
+#   endif
+}
+
+#   define uatomic_int_load_acq(a)          uatomic_int_load_acq_(a)
+#   define uatomic_int_store_rel(a, newval) uatomic_int_store_rel_(a, (newval))
+#   define uatomic_int64_load_acq(a)        uatomic_int64_load_acq_(a)
+#   define uatomic_int64_store_rel(a, newval) uatomic_int64_store_rel_(a, (newval))
+#   define uatomic_ptr_load_acq(a)          uatomic_ptr_load_acq_((const volatile PVOID *)(a))
+#   define uatomic_ptr_store_rel(a, newval) uatomic_ptr_store_rel_((volatile PVOID *)(a), (void *)(newval))
+#   define uatomic_fence_acq()              do { _ReadWriteBarrier(); uatomic_hw_barrier_(); } while(0)
+#   define uatomic_fence_rel()              do { uatomic_hw_barrier_(); _ReadWriteBarrier(); } while(0)
+#   define uatomic_fence_full()             MemoryBarrier()
+
+#   else
+#       error uatomic: load-acquire and store-release not implemented for this target.
+#   endif
+
 #else
 #   error Currently only Windows and Linux os are supported.
 #endif
@@ -0,0 +1,120 @@
+/*******************************************************************************
+* Copyright © 2024-2025 Light Zhang <mapaware@hotmail.com>, MapAware, Inc.     *
+* ALL RIGHTS RESERVED.                                                         *
+*                                                                              *
+* PERMISSION IS HEREBY GRANTED, FREE OF CHARGE, TO ANY PERSON OR ORGANIZATION  *
+* OBTAINING A COPY OF THE SOFTWARE COVERED BY THIS LICENSE TO USE, REPRODUCE,  *
+* DISPLAY, DISTRIBUTE, EXECUTE, AND TRANSMIT THE SOFTWARE, AND TO PREPARE      *
+* DERIVATIVE WORKS OF THE SOFTWARE, AND TO PERMIT THIRD - PARTIES TO WHOM THE  *
+* SOFTWARE IS FURNISHED TO DO SO, ALL SUBJECT TO THE FOLLOWING :               *
+*                                                                              *
+* THE COPYRIGHT NOTICES IN THE SOFTWARE AND THIS ENTIRE STATEMENT, INCLUDING   *
+* THE ABOVE LICENSE GRANT, THIS RESTRICTION AND THE FOLLOWING DISCLAIMER, MUST *
+* BE INCLUDED IN ALL COPIES OF THE SOFTWARE, IN WHOLE OR IN PART, AND ALL      *
+* DERIVATIVE WORKS OF THE SOFTWARE, UNLESS SUCH COPIES OR DERIVATIVE WORKS ARE *
+* SOLELY IN THE FORM OF MACHINE - EXECUTABLE OBJECT CODE GENERATED BY A SOURCE *
+* LANGUAGE PROCESSOR.                                                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON - INFRINGEMENT.IN NO EVENT   *
+* SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE    *
+* FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,  *
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER  *
+* DEALINGS IN THE SOFTWARE.                                                    *
+*******************************************************************************/
+/*
+** @file      varint.h
+**    LEB128 variable-length integer and zigzag codec.
+**
+** @author mapaware@hotmail.com
+** @version 0.0.1
+** @since 2026-10-18 09:20:31
+** @date 2026-10-18 09:20:31
+*/
+#ifndef _VARINT_H__
+#define _VARINT_H__
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#include "basetype.h"
+
+/* max bytes of an encoded 64-bit varint */
+#define VARINT_SIZE_MAX    10
+
+
+STATIC_INLINE ub8 zigzag_encode64 (sb8 v)
+{
+    return ((ub8) v << 1) ^ (ub8) (v >> 63);
+}
+
+
+STATIC_INLINE sb8 zigzag_decode64 (ub8 u)
+{
+    return (sb8) ((u >> 1) ^ (~(u & 1) + 1));
+}
+
+
+/**
+ * varint_encode64
+ *   write u into buf as LEB128. buf must have at least VARINT_SIZE_MAX bytes.
+ * returns:
+ *   bytes written (1..10)
+ */
+STATIC_INLINE int varint_encode64 (ub8 u, ub1 *buf)
+{
+    int n = 0;
+    while (u >= 0x80) {
+        buf[n++] = (ub1) (u | 0x80);
+        u >>= 7;
+    }
+    buf[n++] = (ub1) u;
+    return n;
+}
+
+
+/**
+ * varint_decode64
+ *   read a LEB128 value from buf of bufsz bytes.
+ * returns:
+ *   bytes consumed (1..10) on success
+ *   0 if buf is truncated or value is malformed
+ */
+STATIC_INLINE int varint_decode64 (const ub1 *buf, size_t bufsz, ub8 *u)
+{
+    ub8 v = 0;
+    int n = 0, shift = 0;
+
+    while ((size_t) n < bufsz && n < VARINT_SIZE_MAX) {
+        ub1 b = buf[n++];
+        v |= (ub8) (b & 0x7F) << shift;
+        if (! (b & 0x80)) {
+            *u = v;
+            return n;
+        }
+        shift += 7;
+    }
+
+    return 0;
+}
+
+
+/* bytes needed to encode u as varint */
+STATIC_INLINE int varint_size64 (ub8 u)
+{
+    int n = 1;
+    while (u >= 0x80) {
+        u >>= 7;
+        n++;
+    }
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VARINT_H__ */